@@ -34,6 +34,7 @@ check_function_exists(pthread_yield_np HAVE_PTHREAD_YIELD_NP)
 check_function_exists(pthread_delay HAVE_PTHREAD_DELAY)
 check_function_exists(pthread_delay_np HAVE_PTHREAD_DELAY_NP)
 check_function_exists(pthread_setschedprio HAVE_PTHREAD_SETSCHEDPRIO)
+check_function_exists(pthread_setaffinity_np HAVE_PTHREAD_SETAFFINITY_NP)
 check_function_exists(ftok HAVE_FTOK)
 check_function_exists(shm_open HAVE_SHM_OPEN)
 check_function_exists(localtime_r HAVE_LOCALTIME_R)
@@ -58,6 +59,10 @@ check_function_exists(waitpid HAVE_WAITPID)
 check_function_exists(wait4 HAVE_WAIT4)
 check_function_exists(setgroups HAVE_SETGROUPS)
 check_function_exists(strlcpy HAVE_STRLCPY)
+check_function_exists(recvmmsg HAVE_RECVMMSG)
+check_function_exists(sendmmsg HAVE_SENDMMSG)
+check_function_exists(copy_file_range HAVE_COPY_FILE_RANGE)
+check_function_exists(futimens HAVE_FUTIMENS)
 
 check_include_files(sys/stat.h HAVE_SYS_STAT_H)
 check_include_files(strings.h HAVE_STRINGS_H)
@@ -86,6 +91,11 @@ check_include_files(linux/version.h HAVE_LINUX_VERSION_H)
 check_include_files(regex.h HAVE_REGEX_H)
 check_include_files(sys/inotify.h HAVE_SYS_INOTIFY_H)
 check_include_files(sys/event.h HAVE_SYS_EVENT_H)
+check_include_files(sys/epoll.h HAVE_SYS_EPOLL_H)
+check_include_files(sys/sendfile.h HAVE_SYS_SENDFILE_H)
+check_include_files(linux/io_uring.h HAVE_LINUX_IO_URING_H)
+check_include_files(linux/futex.h HAVE_LINUX_FUTEX_H)
+check_include_files(linux/fs.h HAVE_LINUX_FS_H)
 check_include_files(syslog.h HAVE_SYSLOG_H)
 check_include_files(libintl.h HAVE_LIBINTL_H)
 check_include_files(netinet/in.h HAVE_NETINET_IN_H)
@@ -336,6 +336,47 @@ void IPV4Address::setAddress(const char *host)
 #endif
 
     if(!setIPAddress(host)) {
+#ifdef  HAVE_GETADDRINFO
+        struct addrinfo hint, *list = NULL, *first;
+        memset(&hint, 0, sizeof(hint));
+        hint.ai_family = AF_INET;
+        hint.ai_socktype = SOCK_STREAM;
+        struct in_addr *addr;
+
+        if(ucommon::Socket::resolve(host, NULL, &hint, &list) || !list) {
+            if(ipaddr)
+                delete[] ipaddr;
+            ipaddr = new struct in_addr[1];
+            memset(ipaddr, 0, sizeof(struct in_addr));
+            return;
+        }
+
+        // Count the number of IP addresses returned
+        addr_count = 0;
+        first = list;
+        while(list) {
+            ++addr_count;
+            list = list->ai_next;
+        }
+
+        // Allocate enough memory
+        if(ipaddr)
+            delete[] ipaddr;    // Cause this was allocated in base
+        ipaddr = new struct in_addr[addr_count];
+
+        // Now go through the list again assigning to
+        // the member ipaddr;
+        list = first;
+        int i = 0;
+        while(list) {
+            addr = &((struct sockaddr_in *)list->ai_addr)->sin_addr;
+            if(validator)
+                (*validator)(*addr);
+            ipaddr[i++] = *addr;
+            list = list->ai_next;
+        }
+        freeaddrinfo(first);
+#else
         struct hostent *hp;
         struct in_addr **bptr;
 #if defined(__GLIBC__)
@@ -385,6 +426,7 @@ void IPV4Address::setAddress(const char *host)
                 (*validator)(*bptr[i]);
             ipaddr[i] = *bptr[i];
         }
+#endif
     }
 }
 
@@ -691,7 +733,7 @@ bool IPV6Address::setIPAddress(const char *host)
     return true;
 }
 
-#if defined(HAVE_GETADDRINFO) && !defined(HAVE_GETHOSTBYNAME2)
+#ifdef  HAVE_GETADDRINFO
 
 void IPV6Address::setAddress(const char *host)
 {
@@ -711,10 +753,11 @@ void IPV6Address::setAddress(const char *host)
         struct addrinfo hint, *list = NULL, *first;
         memset(&hint, 0, sizeof(hint));
         hint.ai_family = AF_INET6;
+        hint.ai_socktype = SOCK_STREAM;
         struct in6_addr *addr;
         struct sockaddr_in6 *ip6addr;
 
-        if(getaddrinfo(host, NULL, &hint, &list) || !list) {
+        if(ucommon::Socket::resolve(host, NULL, &hint, &list) || !list) {
             if(ipaddr)
                 delete[] ipaddr;
             ipaddr = new struct in6_addr[1];
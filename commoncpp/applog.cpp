@@ -43,6 +43,9 @@
 #ifndef _MSWINDOWS_
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
+#include <fcntl.h>
+#include <unistd.h>
 #endif
 #include <string>
 #include <iomanip>
@@ -140,6 +143,71 @@ class logger : public ost::ThreadQueue
 
 };
 
+#ifndef _MSWINDOWS_
+// preformatted message in the ring of the asynchronous logger
+class asyncRecord
+{
+  public:
+    enum recordEnum
+    {
+      TEXT_SIZE = 1024
+    };
+
+    // slot is free when sequence equals its position, and ready to write
+    // when it is one past
+    ucommon::Atomic::counter sequence;
+    size_t                   length;
+    char                     text[TEXT_SIZE];
+};
+
+class asyncLogger : public ucommon::JoinableThread, private ucommon::Conditional
+{
+  private:
+    asyncRecord  *_ring;
+    unsigned     _mask;
+    unsigned     _head;
+    ucommon::Atomic::counter _tail;
+    ucommon::Atomic::counter _sleeping;
+    ucommon::Atomic::counter _dropped;
+    string       _nomeFile;
+    bool         _usePipe;
+    bool         _closedByApplog;
+    bool         _reopen;
+    bool         _stopping;
+    int          _fd;
+
+    enum batchEnum
+    {
+      BATCH_SIZE = 64
+    };
+
+    bool drain(void);
+    bool writeAll(struct iovec *iov, unsigned count);
+    void _openFile(void);
+    void _closeFile(void);
+
+  protected:
+    // writes ready records in batches until stopped
+    virtual void run(void);
+
+  public:
+    asyncLogger(const char* logFileName, bool usePipe, unsigned records);
+    virtual ~asyncLogger();
+
+    // formats and enqueues a message, or drops it if the ring is full
+    void post(const char *stamp, const string& ident, const char *level, const char *msg, bool endOfLine);
+
+    // To change log file name
+    void logFileName(const char* FileName, bool usePipe = false);
+
+    void openFile();
+    void closeFile();
+
+    inline unsigned long dropped(void)
+      {return (unsigned long)_dropped.get();}
+};
+#endif
+
 // mapping thread ID <-> logStruct (buffer)
 typedef std::map <cctid_t, logStruct> LogPrivateData;
 // map ident <-> levels
@@ -159,6 +227,11 @@ class __LOCAL AppLogPrivate
     bool           _logPipe;
     // log spooler
     logger         *_pLogger;
+#ifndef _MSWINDOWS_
+    // asynchronous log ring, only replaced with _ringLock held for writing
+    asyncLogger    *_pRing;
+    ThreadLock     _ringLock;
+#endif
 
     string        _nomeFile;
     Mutex         _lock;
@@ -167,12 +240,35 @@ class __LOCAL AppLogPrivate
     static const levelNamePair _values[];
     static LevelName           _assoc;
 
+#ifndef _MSWINDOWS_
+    AppLogPrivate() : _pLogger(NULL), _pRing(NULL) {}
+#else
     AppLogPrivate() : _pLogger(NULL) {}
+#endif
+
+#ifndef _MSWINDOWS_
+    // passes open and close on to the ring, if there is one
+    bool asyncFile(bool open)
+    {
+      _ringLock.readLock();
+      asyncLogger *ring = _pRing;
+      if (ring && open)
+        ring->openFile();
+      else if (ring)
+        ring->closeFile();
+      _ringLock.unlock();
+      return ring != NULL;
+    }
+#endif
 
     ~AppLogPrivate()
     {
       if (_pLogger)
         delete _pLogger;
+#ifndef _MSWINDOWS_
+      if (_pRing)
+        delete _pRing;
+#endif
     }
 };
 
@@ -425,6 +521,236 @@ void logger::final()
   }
 }
 
+#ifndef _MSWINDOWS_
+// class asyncLogger
+asyncLogger::asyncLogger(const char* logFileName, bool usePipe, unsigned records) :
+    JoinableThread(), Conditional(), _usePipe(usePipe), _closedByApplog(false),
+    _reopen(false), _stopping(false), _fd(-1)
+{
+  unsigned size = 2;
+
+  while (size < records && size < 0x40000000)
+    size <<= 1;
+
+  _ring = new asyncRecord[size];
+  _mask = size - 1;
+  _head = 0;
+  for (unsigned pos = 0; pos < size; ++pos)
+    _ring[pos].sequence.fetch_add((atomic_t)pos);
+
+  _nomeFile = "";
+  if (logFileName)
+    _nomeFile = logFileName;
+
+  start();
+}
+
+asyncLogger::~asyncLogger()
+{
+  lock();
+  _stopping = true;
+  signal();
+  unlock();
+  join();
+
+  _closeFile();
+  delete[] _ring;
+}
+
+void asyncLogger::post(const char *stamp, const string& ident, const char *level, const char *msg, bool endOfLine)
+{
+  asyncRecord *rec;
+  atomic_t pos, diff;
+  int len;
+
+  // claim the next free slot, or drop the message if the writer has not
+  // yet released it...
+  for (;;)
+  {
+    pos = _tail.get();
+    rec = &_ring[(unsigned)pos & _mask];
+    diff = (atomic_t)((unsigned)rec->sequence.get() - (unsigned)pos);
+    if (diff < 0)
+    {
+      _dropped.fetch_add();
+      return;
+    }
+    if (!diff && _tail.compare_exchange(pos, (atomic_t)((unsigned)pos + 1)))
+      break;
+  }
+
+  len = snprintf(rec->text, sizeof(rec->text), "%s%s%s[%s] %s%s", stamp,
+                 ident.c_str(), ident.empty() ? "" : ": ", level, msg, endOfLine ? "\n" : "");
+
+  if (len < 0)
+    len = 0;
+  else if ((size_t)len >= sizeof(rec->text))
+  {
+    len = sizeof(rec->text) - 1;
+    if (endOfLine)
+      rec->text[len - 1] = '\n';
+  }
+
+  rec->length = (size_t)len;
+  rec->sequence.fetch_add();
+
+  if (_sleeping.get())
+  {
+    lock();
+    signal();
+    unlock();
+  }
+}
+
+void asyncLogger::logFileName(const char* FileName, bool usePipe)
+{
+  if (!FileName)
+    return;
+
+  lock();
+  _usePipe = usePipe;
+  _nomeFile = FileName;
+  _reopen = true;
+  unlock();
+}
+
+void asyncLogger::openFile()
+{
+  lock();
+  _closedByApplog = false;
+  unlock();
+}
+
+void asyncLogger::closeFile()
+{
+  lock();
+  _closedByApplog = true;
+  signal();
+  unlock();
+}
+
+void asyncLogger::_openFile(void)
+{
+  if (_nomeFile.empty())
+    return;
+
+  if (!_usePipe)
+    _fd = ::open(_nomeFile.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0666);
+  else
+  {
+    int err = mkfifo(_nomeFile.c_str(), S_IRUSR | S_IWUSR);
+    if (err == 0 || errno == EEXIST)
+      _fd = ::open(_nomeFile.c_str(), O_RDWR);
+  }
+}
+
+void asyncLogger::_closeFile(void)
+{
+  if (_fd > -1)
+  {
+    ::close(_fd);
+    _fd = -1;
+  }
+}
+
+bool asyncLogger::writeAll(struct iovec *iov, unsigned count)
+{
+  ssize_t len;
+
+  while (count)
+  {
+    len = ::writev(_fd, iov, (int)count);
+    if (len < 0 && errno == EINTR)
+      continue;
+    if (len < 1)
+      return false;
+
+    while (count && (size_t)len >= iov->iov_len)
+    {
+      len -= (ssize_t)iov->iov_len;
+      ++iov;
+      --count;
+    }
+    if (count)
+    {
+      iov->iov_base = (caddr_t)iov->iov_base + len;
+      iov->iov_len -= (size_t)len;
+    }
+  }
+  return true;
+}
+
+// writes one batch of ready records with a single writev
+bool asyncLogger::drain(void)
+{
+  struct iovec iov[BATCH_SIZE];
+  asyncRecord *rec;
+  unsigned count = 0;
+  bool closing, usePipe;
+
+  while (count < BATCH_SIZE)
+  {
+    rec = &_ring[(_head + count) & _mask];
+    if ((unsigned)rec->sequence.get() != _head + count + 1)
+      break;
+    iov[count].iov_base = rec->text;
+    iov[count].iov_len = rec->length;
+    ++count;
+  }
+
+  lock();
+  if (_reopen)
+  {
+    _reopen = false;
+    _closeFile();
+  }
+  closing = _closedByApplog;
+  usePipe = _usePipe;
+  if (count && !closing && _fd < 0)
+    _openFile();
+  unlock();
+
+  if (count && (_fd < 0 || !writeAll(iov, count)))
+    _dropped.fetch_add((atomic_t)count);
+
+  while (count--)
+  {
+    _ring[_head & _mask].sequence.fetch_add((atomic_t)_mask);
+    ++_head;
+  }
+
+  //if we use a pipe to avoid filling it without a consumer, or the
+  // file was closed by applog, we close it between batches
+  if (usePipe || closing)
+    _closeFile();
+
+  rec = &_ring[_head & _mask];
+  return (unsigned)rec->sequence.get() == _head + 1;
+}
+
+void asyncLogger::run(void)
+{
+  bool stopping = false;
+
+  while (!stopping)
+  {
+    if (drain())
+      continue;
+
+    lock();
+    _sleeping.compare_exchange(0, 1);
+    if (!_stopping && (unsigned)_ring[_head & _mask].sequence.get() != _head + 1)
+      wait((timeout_t)1000);
+    _sleeping.clear();
+    stopping = _stopping;
+    unlock();
+  }
+
+  while (drain())
+    ;
+}
+#endif
+
 #ifndef _MSWINDOWS_
 AppLog::AppLog(const char* logFileName, bool logDirectly, bool usePipe) :
     streambuf(), ostream((streambuf*) this)
@@ -565,6 +891,15 @@ void AppLog::logFileName(const char* FileName, bool logDirectly)
 #else
   d->_logPipe = false;
 #endif
+#ifndef _MSWINDOWS_
+  if (d->_pRing)
+  {
+    d->_pRing->logFileName(FileName, d->_logPipe);
+    d->_lock.leaveMutex();
+    return;
+  }
+#endif
+
   if (!d->_logDirectly)
   {
     if (d->_pLogger)
@@ -615,8 +950,21 @@ void AppLog::writeLog(bool endOfLine)
     if (logIt == d->_logs.end())
       return;
 
+#ifndef _MSWINDOWS_
+    // messages are posted into the ring without the log lock, so the ring
+    // is held for reading until posted...
+    d->_ringLock.readLock();
+    asyncLogger *ring = d->_pRing;
+    if (!ring)
+      d->_ringLock.unlock();
+
+    if (!ring &&
+        ((d->_logDirectly && !d->_logfs.is_open() && !logIt->second._clogEnable) ||
+         (!d->_logDirectly && !d->_pLogger && !logIt->second._clogEnable)))
+#else
     if ((d->_logDirectly && !d->_logfs.is_open() && !logIt->second._clogEnable) ||
         (!d->_logDirectly && !d->_pLogger && !logIt->second._clogEnable))
+#endif
 
     {
       logIt->second._msgpos = 0;
@@ -626,12 +974,6 @@ void AppLog::writeLog(bool endOfLine)
 
     if (logIt->second._enable)
     {
-      time_t now;
-      struct tm *dt;
-      time(&now);
-      struct timeval detail_time;
-      gettimeofday(&detail_time, NULL);
-      dt = localtime(&now);
       char buf[50];
 
       const char *p = "unknown";
@@ -663,12 +1005,30 @@ void AppLog::writeLog(bool endOfLine)
           break;
       }
 
-      snprintf(buf, sizeof(buf) - 1, "%04d-%02d-%02d %02d:%02d:%02d.%03d ",
-               dt->tm_year + 1900, dt->tm_mon + 1, dt->tm_mday,
-               dt->tm_hour, dt->tm_min, dt->tm_sec, (int)(detail_time.tv_usec / 1000));
+      // only the milliseconds are formatted while the second is unchanged
+      size_t len = ucommon::DateTime::stamp(buf, sizeof(buf) - 1);
+      buf[len++] = ' ';
+      buf[len] = 0;
+
+#ifndef _MSWINDOWS_
+      if (ring)
+      {
+        // preformatted into the ring, the lock is only needed for slog and clog
+        ring->post(buf, logIt->second._ident, p, logIt->second._msgbuf, endOfLine);
+        d->_ringLock.unlock();
 
-      buf[sizeof(buf)-1] = 0;    // per sicurezza
+        if (!logIt->second._clogEnable &&
+            !(logIt->second._slogEnable && logIt->second._priority <= Slog::levelError))
+        {
+          logIt->second._msgpos = 0;
+          logIt->second._msgbuf[0] = '\0';
+          return;
+        }
 
+        d->_lock.enterMutex();
+      }
+      else
+#endif
       if (d->_logDirectly)
       {
         d->_lock.enterMutex();
@@ -731,6 +1091,10 @@ void AppLog::writeLog(bool endOfLine)
 
       d->_lock.leaveMutex();
     }
+#ifndef _MSWINDOWS_
+    else if (ring)
+      d->_ringLock.unlock();
+#endif
 
     logIt->second._msgpos = 0;
     logIt->second._msgbuf[0] = '\0';
@@ -739,6 +1103,11 @@ void AppLog::writeLog(bool endOfLine)
 
 void AppLog::close(void)
 {
+#ifndef _MSWINDOWS_
+  if (d->asyncFile(false))
+    return;
+#endif
+
   if (d->_logDirectly)
   {
     d->_lock.enterMutex();
@@ -772,6 +1141,15 @@ void AppLog::open(const char *ident)
       std::cerr << "Empty file name" << std::endl;
       slog.emerg("Empty file nane!\n");
     }
+#ifndef _MSWINDOWS_
+    // the ring opens its own file when it writes
+    if (d->asyncFile(true))
+    {
+      if (ident != NULL)
+        logIt->second._ident = ident;
+      return;
+    }
+#endif
     if (d->_logDirectly)
     {
       d->_lock.enterMutex();
@@ -857,6 +1235,74 @@ void AppLog::slogEnable(bool en)
   }
 }
 
+#ifndef _MSWINDOWS_
+void AppLog::asyncEnable(bool en, unsigned records)
+{
+  d->_lock.enterMutex();
+  if (!en)
+  {
+    if (d->_pRing)
+    {
+      // loggers still posting are waited for, and what is still in the
+      // ring is written before returning to the prior mode
+      d->_ringLock.writeLock();
+      asyncLogger *ring = d->_pRing;
+      d->_pRing = NULL;
+      d->_ringLock.unlock();
+      delete ring;
+      if (!d->_nomeFile.empty())
+      {
+        string name = d->_nomeFile;
+        d->_lock.leaveMutex();
+        logFileName(name.c_str(), d->_logDirectly, d->_logPipe);
+        return;
+      }
+    }
+    d->_lock.leaveMutex();
+    return;
+  }
+
+  if (d->_pRing)
+  {
+    d->_lock.leaveMutex();
+    return;
+  }
+
+  if (d->_logfs.is_open())
+  {
+    d->_logfs.flush();
+    d->_logfs.close();
+  }
+  if (d->_pLogger)
+  {
+    delete d->_pLogger;
+    d->_pLogger = NULL;
+  }
+
+  asyncLogger *ring;
+  if (d->_nomeFile.empty())
+    ring = new asyncLogger(NULL, d->_logPipe, records);
+  else
+    ring = new asyncLogger(d->_nomeFile.c_str(), d->_logPipe, records);
+
+  d->_ringLock.writeLock();
+  d->_pRing = ring;
+  d->_ringLock.unlock();
+  d->_lock.leaveMutex();
+}
+
+unsigned long AppLog::asyncDropped(void)
+{
+  unsigned long count = 0;
+
+  d->_lock.enterMutex();
+  if (d->_pRing)
+    count = d->_pRing->dropped();
+  d->_lock.leaveMutex();
+  return count;
+}
+#endif
+
 int AppLog::sync()
 {
   int retVal = (pbase() != pptr());
@@ -157,7 +157,7 @@ Socket(fam, SOCK_DCCP, IPPROTO_DCCP)
     hint.ai_protocol = IPPROTO_DCCP;
     hint.ai_flags = AI_PASSIVE;
 
-    if(getaddrinfo(name, cp, &hint, &list) || !list) {
+    if(ucommon::Socket::resolve(name, cp, &hint, &list) || !list) {
         endSocket();
         error(errBindingFailed, (char *)"Could not find service", errno);
         return;
@@ -409,7 +409,7 @@ void DCCPSocket::connect(const char *target)
     hint.ai_socktype = SOCK_DCCP;
     hint.ai_protocol = IPPROTO_DCCP;
 
-    if(getaddrinfo(namebuf, cp, &hint, &list) || !list) {
+    if(ucommon::Socket::resolve(namebuf, cp, &hint, &list) || !list) {
         connectError();
         return;
     }
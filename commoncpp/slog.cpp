@@ -337,10 +337,7 @@ int Slog::overflow(int c)
             ::syslog(priority, "%s", thread->msgbuf);
 #else
         {
-            time_t now;
-            struct tm *dt;
-            time(&now);
-            dt = localtime(&now);
+            char stamp[24];
             char buf[256];
             const char *p = "unknown";
             switch(priority) {
@@ -370,10 +367,9 @@ int Slog::overflow(int c)
                 break;
             }
 
-            snprintf(buf, sizeof(buf), "%04d-%02d-%02d %02d:%02d:%02d [%s] %s\n",
-                dt->tm_year + 1900, dt->tm_mon + 1, dt->tm_mday,
-                dt->tm_hour, dt->tm_min, dt->tm_sec,
-                p, thread->msgbuf);
+            ucommon::DateTime::stamp(stamp, sizeof(stamp), false);
+            snprintf(buf, sizeof(buf), "%s [%s] %s\n",
+                stamp, p, thread->msgbuf);
             if(syslog)
                 fputs(buf, syslog);
 //              syslog << "[" << priority << "] " << thread->msgbuf << endl;
@@ -136,7 +136,7 @@ Socket(AF_INET, SOCK_STREAM, IPPROTO_TCP)
     hint.ai_protocol = IPPROTO_TCP;
     hint.ai_flags = AI_PASSIVE;
 
-    if(getaddrinfo(name, cp, &hint, &list) || !list) {
+    if(ucommon::Socket::resolve(name, cp, &hint, &list) || !list) {
         endSocket();
         error(errBindingFailed, (char *)"Could not find service", errno);
         return;
@@ -313,7 +313,7 @@ Socket(AF_INET6, SOCK_STREAM, IPPROTO_TCP)
     hint.ai_protocol = IPPROTO_TCP;
     hint.ai_flags = AI_PASSIVE;
 
-    if(getaddrinfo(name, cp, &hint, &list) || !list) {
+    if(ucommon::Socket::resolve(name, cp, &hint, &list) || !list) {
         endSocket();
         error(errBindingFailed, (char *)"Could not find service", errno);
         return;
@@ -511,7 +511,7 @@ void TCPStream::connect(const char *target, unsigned mss)
     hint.ai_socktype = SOCK_STREAM;
     hint.ai_protocol = IPPROTO_TCP;
 
-    if(getaddrinfo(namebuf, cp, &hint, &list) || !list) {
+    if(ucommon::Socket::resolve(namebuf, cp, &hint, &list) || !list) {
         endStream();
         connectError();
         return;
@@ -1019,6 +1019,27 @@ int TCPStream::sync(void)
     return 0;
 }
 
+ssize_t TCPStream::sendFile(fd_t file, off_t offset, size_t size)
+{
+    if(so == INVALID_SOCKET)
+        return -1;
+
+    // a partial write rebuffers the remainder, so flush until empty...
+    while(bufsize > 1 && pbase() && pptr() > pbase()) {
+        ssize_t pending = (ssize_t)(pptr() - pbase());
+        overflow(EOF);
+        if((ssize_t)(pptr() - pbase()) >= pending)
+            return -1;
+    }
+
+    ssize_t rlen = ucommon::Socket::sendfile(so, file, offset, size);
+    if(rlen < 0) {
+        iostream::clear(ios::failbit | rdstate());
+        error(errOutput,(char *)"Could not write to socket",socket_errno);
+    }
+    return rlen;
+}
+
 size_t TCPStream::printf(const char *format, ...)
 {
     va_list args;
@@ -828,9 +828,13 @@ size_t FixedBuffer::onPeek(void *data)
 }
 
 ThreadQueue::ThreadQueue(const char *id, int pri, size_t stack) :
-Mutex(), Thread(pri, stack), Semaphore(0), name(id)
+Mutex(), Thread(pri, stack), Semaphore(1, 0), name(id)
 {
     first = last = NULL;
+    pool = NULL;
+    pooled = 0;
+    poolLimit = 64;
+    poolSize = 256;
     started = false;
     timeout = 0;
 }
@@ -844,37 +848,71 @@ ThreadQueue::~ThreadQueue()
     data = first;
     while(data) {
         next = data->next;
-        delete[] data;
+        delete[] (char *)data;
+        data = next;
+    }
+    data = pool;
+    while(data) {
+        next = data->next;
+        delete[] (char *)data;
         data = next;
     }
 }
 
 void ThreadQueue::run(void)
 {
-    bool posted;
-    data_t *prev;
+    data_t *data, *next, *end, *expired;
     started = true;
     for(;;) {
-        posted = Semaphore::wait(timeout);
-        if(!posted) {
-            onTimer();
-            if(!first)
-                continue;
+        enterMutex();
+        end = last;
+        leaveMutex();
+        if(!end) {
+            if(!timeout)
+                Semaphore::wait();
+            else if(!Semaphore::wait(timeout))
+                onTimer();
+            continue;
         }
         if(!started)
             sleep((timeout_t)~0);
+
+        // only this thread removes items, so everything up to the last
+        // one seen may be processed without holding the lock...
         startQueue();
-        while(first) {
-            runQueue(first->data);
-            enterMutex();
-            prev = first;
-            first = first->next;
-            delete[] prev;
-            if(!first)
-                last = NULL;
-            leaveMutex();
-            if(first)
-                Semaphore::wait(); // demark semaphore
+        data = first;
+        for(;;) {
+            runQueue(data->data);
+            if(data == end)
+                break;
+            data = data->next;
+        }
+
+        expired = NULL;
+        enterMutex();
+        data = first;
+        first = end->next;
+        if(!first)
+            last = NULL;
+        end->next = NULL;
+        while(data) {
+            next = data->next;
+            if(data->size == poolSize && pooled < poolLimit) {
+                data->next = pool;
+                pool = data;
+                ++pooled;
+            }
+            else {
+                data->next = expired;
+                expired = data;
+            }
+            data = next;
+        }
+        leaveMutex();
+        while(expired) {
+            next = expired->next;
+            delete[] (char *)expired;
+            expired = next;
         }
         stopQueue();
     }
@@ -901,13 +939,65 @@ void ThreadQueue::setTimer(timeout_t timed)
         Semaphore::post();
 }
 
+void ThreadQueue::setPool(unsigned count, unsigned size)
+{
+    data_t *data, *expired = NULL;
+
+    enterMutex();
+    if(size != poolSize) {
+        expired = pool;
+        pool = NULL;
+        pooled = 0;
+    }
+    poolLimit = count;
+    poolSize = size;
+    while(pooled > poolLimit) {
+        data = pool;
+        pool = data->next;
+        data->next = expired;
+        expired = data;
+        --pooled;
+    }
+    while(pooled < poolLimit) {
+        data = (data_t *)new char[sizeof(data_t) + poolSize];
+        data->size = poolSize;
+        data->next = pool;
+        pool = data;
+        ++pooled;
+    }
+    leaveMutex();
+
+    while(expired) {
+        data = expired->next;
+        delete[] (char *)expired;
+        expired = data;
+    }
+}
+
 void ThreadQueue::post(const void *dp, unsigned len)
 {
-    data_t *data = (data_t *)new char[sizeof(data_t) + len];
+    data_t *data;
+    bool wake;
+
+    // a kept item is filled and queued under the same lock, and only a
+    // post the pool cannot hold drops it to allocate...
+    enterMutex();
+    if(len <= poolSize && pool) {
+        data = pool;
+        pool = data->next;
+        --pooled;
+    }
+    else {
+        unsigned size = (len > poolSize) ? len : poolSize;
+        leaveMutex();
+        data = (data_t *)new char[sizeof(data_t) + size];
+        data->size = size;
+        enterMutex();
+    }
     memcpy(data->data, dp, len);
     data->len = len;
     data->next = NULL;
-    enterMutex();
+    wake = (first == NULL);
     if(!first)
         first = data;
     if(last)
@@ -918,7 +1008,10 @@ void ThreadQueue::post(const void *dp, unsigned len)
         started = true;
     }
     leaveMutex();
-    Semaphore::post();
+
+    // the run thread only sleeps once it has emptied the queue...
+    if(wake)
+        Semaphore::post();
 }
 
 void ThreadQueue::startQueue(void)
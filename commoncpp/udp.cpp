@@ -128,7 +128,7 @@ Socket(fam, SOCK_DGRAM, IPPROTO_UDP)
     hint.ai_protocol = IPPROTO_UDP;
     hint.ai_flags = AI_PASSIVE;
 
-    if(getaddrinfo(name, cp, &hint, &list) || !list) {
+    if(ucommon::Socket::resolve(name, cp, &hint, &list) || !list) {
         error(errBindingFailed, (char *)"Could not find service", errno);
         endSocket();
         return;
@@ -301,6 +301,45 @@ ssize_t UDPSocket::receive(void *buf, size_t len, bool reply)
     return _IORET64 bytes;
 }
 
+ssize_t UDPSocket::send(const datagram_t *list, unsigned count)
+{
+    if(isConnected())
+        return ucommon::Socket::sendbatch(so, list, count);
+
+    // packets without an address of their own go to our peer...
+    struct sockaddr_storage dest;
+    const struct sockaddr *addr = peer;
+    memset(&dest, 0, sizeof(dest));
+    if(addr)
+        memcpy(&dest, addr, peer.getLength());
+
+    ssize_t total = 0;
+    unsigned pos = 0;
+    while(pos < count) {
+        datagram_t batch[64];
+        unsigned chunk = 0;
+        while(chunk < 64 && pos + chunk < count) {
+            batch[chunk] = list[pos + chunk];
+            if(!batch[chunk].address)
+                batch[chunk].address = &dest;
+            ++chunk;
+        }
+        ssize_t result = ucommon::Socket::sendbatch(so, batch, chunk);
+        if(result < 0)
+            return total ? total : -1;
+        total += result;
+        if((unsigned)result < chunk)
+            break;
+        pos += chunk;
+    }
+    return total;
+}
+
+ssize_t UDPSocket::receive(datagram_t *list, unsigned count)
+{
+    return ucommon::Socket::recvbatch(so, list, count);
+}
+
 Socket::Error UDPSocket::join(const IPV4Multicast &ia,int InterfaceIndex)
 {
     return join(Socket::address(getaddress(ia)), InterfaceIndex);
@@ -25,6 +25,54 @@
 
 namespace ucommon {
 
+/**
+ * Control block of a lockfree ring array.  This is stored after the slots
+ * of the array, followed by a sequence number for each slot.  Enqueue and
+ * dequeue positions are kept on separate cache lines.
+ */
+class ArrayRef::Array::Ring
+{
+private:
+    __DELETE_DEFAULTS(Ring);
+
+public:
+    Atomic::counter enqueue;
+    char pad1[64];
+    Atomic::counter dequeue;
+    char pad2[64];
+    Atomic::counter pullers, pushers;
+    char pad3[64];
+    unsigned mask;
+
+    Ring(size_t size);
+
+    inline Atomic::counter *sequence(void) {
+        return reinterpret_cast<Atomic::counter *>(this + 1);
+    }
+
+    // register a parked thread, ordered against the ring positions
+    static inline void park(Atomic::counter& waiters) {
+        atomic_t current;
+        do {
+            current = waiters.get();
+        } while(!waiters.compare_exchange(current, current + 1));
+    }
+
+    static inline bool parked(Atomic::counter& waiters) {
+        return !waiters.compare_exchange(0, 0);
+    }
+};
+
+ArrayRef::Array::Ring::Ring(size_t size) :
+enqueue(0), dequeue(0), pullers(0), pushers(0)
+{
+    Atomic::counter *seq = sequence();
+
+    mask = (unsigned)(size - 1);
+    for(size_t index = 0; index < size; ++index)
+        new(&seq[index]) Atomic::counter((atomic_t)index);
+}
+
 ArrayRef::Array::Array(arraytype_t arraymode, void *addr, size_t used) :
 Counted(addr, used), ConditionalAccess()
 {
@@ -33,11 +81,15 @@ Counted(addr, used), ConditionalAccess()
 
     head = 0;
     type = arraymode;
+    ring = NULL;
     if(type == ARRAY)
         tail = size;
     else
         tail = 0;
 
+    if(type == RING)
+        ring = new(mem((caddr_t)(list + used))) Ring(used);
+
     if(!used)
         return;
 
@@ -66,8 +118,121 @@ void ArrayRef::Array::dealloc()
     Counted::dealloc();
 }
 
+bool ArrayRef::Array::enqueue(Counted *object, timeout_t timeout)
+{
+    Atomic::counter *seq = ring->sequence();
+    Counted **list = get();
+    struct timespec ts;
+    unsigned pos;
+    int diff;
+    bool result = true;
+
+    if(!object)
+        return false;
+
+    for(;;) {
+        pos = (unsigned)ring->enqueue.get();
+        diff = (int)((unsigned)seq[pos & ring->mask].get() - pos);
+        if(!diff) {
+            if(ring->enqueue.compare_exchange((atomic_t)pos, (atomic_t)(pos + 1)))
+                break;
+            continue;
+        }
+        if(diff > 0)
+            continue;
+
+        // ring is full, park until a slot is released or we time out...
+        if(!timeout)
+            return false;
+
+        if(timeout != Timer::inf)
+            set(&ts, timeout);
+
+        lock();
+        Ring::park(ring->pushers);
+        while(result && (unsigned)ring->enqueue.get() - (unsigned)ring->dequeue.get() > ring->mask) {
+            if(timeout == Timer::inf)
+                waitBroadcast();
+            else
+                result = waitBroadcast(&ts);
+        }
+        ring->pushers.fetch_sub();
+        unlock();
+        if(!result)
+            return enqueue(object, 0);
+    }
+
+    object->retain();
+    list[pos & ring->mask] = object;
+    seq[pos & ring->mask].fetch_add();
+
+    if(Ring::parked(ring->pullers)) {
+        lock();
+        signal();
+        unlock();
+    }
+    return true;
+}
+
+TypeRef::Counted *ArrayRef::Array::dequeue(timeout_t timeout)
+{
+    Atomic::counter *seq = ring->sequence();
+    Counted **list = get();
+    Counted *object;
+    struct timespec ts;
+    unsigned pos;
+    int diff;
+    bool result = true;
+
+    for(;;) {
+        pos = (unsigned)ring->dequeue.get();
+        diff = (int)((unsigned)seq[pos & ring->mask].get() - (pos + 1));
+        if(!diff) {
+            if(ring->dequeue.compare_exchange((atomic_t)pos, (atomic_t)(pos + 1)))
+                break;
+            continue;
+        }
+        if(diff > 0)
+            continue;
+
+        // ring is empty, park until an object is inserted or we time out...
+        if(!timeout)
+            return NULL;
+
+        if(timeout != Timer::inf)
+            set(&ts, timeout);
+
+        lock();
+        Ring::park(ring->pullers);
+        while(result && ring->dequeue.get() == ring->enqueue.get()) {
+            if(timeout == Timer::inf)
+                waitSignal();
+            else
+                result = waitSignal(&ts);
+        }
+        ring->pullers.fetch_sub();
+        unlock();
+        if(!result)
+            return dequeue(0);
+    }
+
+    object = list[pos & ring->mask];
+    list[pos & ring->mask] = NULL;
+    seq[pos & ring->mask].fetch_add((atomic_t)ring->mask);
+
+    if(Ring::parked(ring->pushers)) {
+        lock();
+        broadcast();
+        unlock();
+    }
+    return object;
+}
+
 size_t ArrayRef::Array::count(void)
 {
+    if(ring)
+        return (size_t)((unsigned)ring->enqueue.get() - (unsigned)ring->dequeue.get());
+
     if(head <= tail)
         return tail - head;
 
@@ -175,6 +340,13 @@ void ArrayRef::pop(void)
     if(!array || !array->size)
         return;
 
+    if(array->type == RING) {
+        Counted *object = array->dequeue(0);
+        if(object)
+            object->release();
+        return;
+    }
+
     array->lock();
     switch(array->type) {
     case STACK:
@@ -220,7 +392,18 @@ ArrayRef::Array *ArrayRef::create(arraytype_t mode, size_t size)
     if(!size)
         return NULL;
 
-    size_t s = sizeof(Array) + (size * sizeof(Counted *));
+    size_t s;
+    if(mode == RING) {
+        size_t ring = 2;
+        while(ring < size)
+            ring <<= 1;
+        size = ring;
+        s = sizeof(Array) + (size * sizeof(Counted *)) + Thread::cache() +
+            sizeof(Array::Ring) + (size * sizeof(Atomic::counter));
+    }
+    else
+        s = sizeof(Array) + (size * sizeof(Counted *));
+
     caddr_t p = auto_release.allocate(s);
     return new(mem(p)) Array(mode, p, size);
 }
@@ -231,6 +414,9 @@ bool ArrayRef::push(const TypeRef& object, timeout_t timeout)
     if(!array || array->type == ARRAY)
         return false;
 
+    if(array->type == RING)
+        return array->enqueue(object.ref, timeout);
+
     array->lock();
     while(array->count() >= (array->size - 1)) {
         if(!array->waitSignal(timeout)) {
@@ -264,6 +450,11 @@ void ArrayRef::push(const TypeRef& object)
     if(!array || array->type == ARRAY)
         return;
 
+    if(array->type == RING) {
+        array->enqueue(object.ref, Timer::inf);
+        return;
+    }
+
     array->lock();
     while(array->count() >= (array->size - 1)) {
         array->waitSignal();
@@ -283,6 +474,11 @@ void ArrayRef::pull(TypeRef& object, timeout_t timeout)
         return;
     }
 
+    if(array->type == RING) {
+        object.ref = array->dequeue(timeout);
+        return;
+    }
+
     array->lock();
     for(;;) {
         if(array->head != array->tail) {
@@ -330,6 +526,11 @@ void ArrayRef::pull(TypeRef& object)
         return;
     }
 
+    if(array->type == RING) {
+        object.ref = array->dequeue(Timer::inf);
+        return;
+    }
+
     array->lock();
     for(;;) {
         if(array->head != array->tail) {
@@ -0,0 +1,650 @@
+// Copyright (C) 2015-2020 Cherokees of Idaho.
+//
+// This file is part of GNU uCommon C++.
+//
+// GNU uCommon C++ is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// GNU uCommon C++ is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with GNU uCommon C++.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <ucommon-config.h>
+#include <ucommon/export.h>
+#include <ucommon/timers.h>
+#include <ucommon/socket.h>
+#include <ucommon/fsys.h>
+#include <ucommon/asyncio.h>
+
+#ifndef _MSWINDOWS_
+
+#include <cstdlib>
+#include <cstring>
+#include <climits>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#if defined(HAVE_POLL_H)
+#include <poll.h>
+#elif defined(HAVE_SYS_POLL_H)
+#include <sys/poll.h>
+#endif
+
+#if defined(HAVE_LINUX_IO_URING_H)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#define ASYNCIO_URING
+#endif
+#endif
+
+#ifndef MSG_DONTWAIT
+#define MSG_DONTWAIT 0
+#endif
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+namespace ucommon {
+
+// requests are kept in fifo lists while queued for submit, while waiting
+// on poll when there is no io_uring, and when done until called back...
+class AsyncIO::Backend
+{
+private:
+    __DELETE_COPY(Backend);
+
+public:
+    class fifo
+    {
+    public:
+        request *head, *tail;
+        unsigned count;
+
+        inline fifo() {
+            head = tail = NULL;
+            count = 0;
+        }
+
+        void add(request *object);
+        request *take(void);
+    };
+
+    fifo queued, waiting, done;
+    struct pollfd *fds;
+    unsigned limit;
+
+#ifdef  ASYNCIO_URING
+    int ring;
+    unsigned *sq_head, *sq_tail, *sq_mask, *sq_flags, *sq_array, sq_entries;
+    unsigned *cq_head, *cq_tail, *cq_mask;
+    struct io_uring_sqe *sqes;
+    struct io_uring_cqe *cqes;
+    void *sq_map, *cq_map;
+    size_t sq_size, cq_size, sqe_size;
+    unsigned tail;
+
+    bool prepare(request *object);
+    unsigned enter(void);
+    unsigned reap(void);
+#endif
+
+    Backend(unsigned depth);
+    ~Backend();
+
+    bool perform(request *object);
+    void wait(timeout_t timeout);
+};
+
+void AsyncIO::Backend::fifo::add(request *object)
+{
+    object->next = NULL;
+    if(tail)
+        tail->next = object;
+    else
+        head = object;
+    tail = object;
+    ++count;
+}
+
+AsyncIO::request *AsyncIO::Backend::fifo::take(void)
+{
+    request *object = head;
+    if(!object)
+        return NULL;
+
+    head = object->next;
+    if(!head)
+        tail = NULL;
+    --count;
+    return object;
+}
+
+AsyncIO::Backend::Backend(unsigned depth)
+{
+    fds = NULL;
+    limit = 0;
+
+#ifdef  ASYNCIO_URING
+    struct io_uring_params params;
+
+    tail = 0;
+    sq_map = cq_map = sqes = NULL;
+    memset(&params, 0, sizeof(params));
+    ring = (int)::syscall(__NR_io_uring_setup, depth, &params);
+
+    // kernels without io_uring, or that deny it, use poll instead...
+    if(ring < 0)
+        return;
+
+    sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    sqe_size = params.sq_entries * sizeof(struct io_uring_sqe);
+
+    if(params.features & IORING_FEAT_SINGLE_MMAP) {
+        if(cq_size > sq_size)
+            sq_size = cq_size;
+        cq_size = sq_size;
+    }
+
+    sq_map = ::mmap(NULL, sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_SQ_RING);
+    if(sq_map == MAP_FAILED) {
+        sq_map = NULL;
+        goto failed;
+    }
+
+    if(params.features & IORING_FEAT_SINGLE_MMAP)
+        cq_map = sq_map;
+    else {
+        cq_map = ::mmap(NULL, cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_CQ_RING);
+        if(cq_map == MAP_FAILED) {
+            cq_map = NULL;
+            goto failed;
+        }
+    }
+
+    sqes = (struct io_uring_sqe *)::mmap(NULL, sqe_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_SQES);
+    if(sqes == MAP_FAILED) {
+        sqes = NULL;
+        goto failed;
+    }
+
+    sq_head = (unsigned *)((char *)sq_map + params.sq_off.head);
+    sq_tail = (unsigned *)((char *)sq_map + params.sq_off.tail);
+    sq_mask = (unsigned *)((char *)sq_map + params.sq_off.ring_mask);
+    sq_flags = (unsigned *)((char *)sq_map + params.sq_off.flags);
+    sq_array = (unsigned *)((char *)sq_map + params.sq_off.array);
+    sq_entries = params.sq_entries;
+    cq_head = (unsigned *)((char *)cq_map + params.cq_off.head);
+    cq_tail = (unsigned *)((char *)cq_map + params.cq_off.tail);
+    cq_mask = (unsigned *)((char *)cq_map + params.cq_off.ring_mask);
+    cqes = (struct io_uring_cqe *)((char *)cq_map + params.cq_off.cqes);
+    tail = *sq_tail;
+    return;
+
+failed:
+    if(sq_map)
+        ::munmap(sq_map, sq_size);
+    if(cq_map && cq_map != sq_map)
+        ::munmap(cq_map, cq_size);
+    ::close(ring);
+    sq_map = cq_map = NULL;
+    ring = -1;
+#endif
+}
+
+AsyncIO::Backend::~Backend()
+{
+    ::free(fds);
+
+#ifdef  ASYNCIO_URING
+    if(ring < 0)
+        return;
+
+    ::munmap(sqes, sqe_size);
+    if(cq_map != sq_map)
+        ::munmap(cq_map, cq_size);
+    ::munmap(sq_map, sq_size);
+    ::close(ring);
+#endif
+}
+
+#ifdef  ASYNCIO_URING
+
+bool AsyncIO::Backend::prepare(request *object)
+{
+    if(tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE) >= sq_entries)
+        return false;
+
+    unsigned index = tail & *sq_mask;
+    struct io_uring_sqe *sqe = &sqes[index];
+
+    memset(sqe, 0, sizeof(struct io_uring_sqe));
+    sqe->fd = object->fd;
+    sqe->user_data = (uint64_t)(uintptr_t)object;
+
+    switch(object->op) {
+    case READ:
+        sqe->opcode = IORING_OP_READ;
+        sqe->addr = (uint64_t)(uintptr_t)object->data;
+        sqe->len = (uint32_t)object->size;
+        sqe->off = (uint64_t)object->offset;
+        break;
+    case WRITE:
+        sqe->opcode = IORING_OP_WRITE;
+        sqe->addr = (uint64_t)(uintptr_t)object->data;
+        sqe->len = (uint32_t)object->size;
+        sqe->off = (uint64_t)object->offset;
+        break;
+    case FSYNC:
+        sqe->opcode = IORING_OP_FSYNC;
+        break;
+    case ACCEPT:
+        sqe->opcode = IORING_OP_ACCEPT;
+        if(object->address) {
+            sqe->addr = (uint64_t)(uintptr_t)object->address;
+            sqe->addr2 = (uint64_t)(uintptr_t)&object->addrlen;
+        }
+        break;
+    case CONNECT:
+        sqe->opcode = IORING_OP_CONNECT;
+        sqe->addr = (uint64_t)(uintptr_t)object->data;
+        sqe->off = object->addrlen;
+        break;
+    case RECV:
+        sqe->opcode = IORING_OP_RECV;
+        sqe->addr = (uint64_t)(uintptr_t)object->data;
+        sqe->len = (uint32_t)object->size;
+        sqe->msg_flags = (uint32_t)object->flags;
+        break;
+    case SEND:
+        sqe->opcode = IORING_OP_SEND;
+        sqe->addr = (uint64_t)(uintptr_t)object->data;
+        sqe->len = (uint32_t)object->size;
+        sqe->msg_flags = (uint32_t)(object->flags | MSG_NOSIGNAL);
+        break;
+    }
+
+    sq_array[index] = index;
+    ++tail;
+    return true;
+}
+
+unsigned AsyncIO::Backend::enter(void)
+{
+    __atomic_store_n(sq_tail, tail, __ATOMIC_RELEASE);
+
+    unsigned count = tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE);
+    if(!count)
+        return 0;
+
+    int result;
+    do {
+        result = (int)::syscall(__NR_io_uring_enter, ring, count, 0, 0, NULL, 0);
+    } while(result < 0 && errno == EINTR);
+
+    if(result < 0)
+        return 0;
+
+    return (unsigned)result;
+}
+
+unsigned AsyncIO::Backend::reap(void)
+{
+    unsigned head = *cq_head;
+    unsigned last = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+    unsigned count = 0;
+
+    for(;;) {
+        // completions the kernel held back while the ring was full...
+        if(head == last) {
+            __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+            if(!(__atomic_load_n(sq_flags, __ATOMIC_ACQUIRE) & IORING_SQ_CQ_OVERFLOW))
+                break;
+            if(::syscall(__NR_io_uring_enter, ring, 0, 0, IORING_ENTER_GETEVENTS, NULL, 0) < 0 && errno != EINTR)
+                break;
+            last = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+            if(head == last)
+                break;
+        }
+
+        struct io_uring_cqe *cqe = &cqes[head & *cq_mask];
+        request *object = (request *)(uintptr_t)cqe->user_data;
+        if(cqe->res < 0) {
+            object->status = -1;
+            object->err = -cqe->res;
+        }
+        else {
+            object->status = cqe->res;
+            object->err = 0;
+        }
+        done.add(object);
+        ++head;
+        ++count;
+    }
+    return count;
+}
+
+#endif
+
+// perform an operation once without blocking on a socket; false if the
+// operation has to wait on poll to be ready...
+bool AsyncIO::Backend::perform(request *object)
+{
+    ssize_t result = -1;
+    int fd = object->fd;
+
+    switch(object->op) {
+    case READ:
+        if(object->offset < 0)
+            result = ::read(fd, object->data, object->size);
+        else
+            result = ::pread(fd, object->data, object->size, object->offset);
+        break;
+    case WRITE:
+        if(object->offset < 0)
+            result = ::write(fd, object->data, object->size);
+        else
+            result = ::pwrite(fd, object->data, object->size, object->offset);
+        break;
+    case FSYNC:
+        result = ::fsync(fd);
+        break;
+    case ACCEPT:
+        if(object->address)
+            result = ::accept(fd, (struct sockaddr *)object->address, &object->addrlen);
+        else
+            result = ::accept(fd, NULL, NULL);
+        break;
+    case CONNECT:
+        // after connect is started, poll says when it is done...
+        if(object->flags) {
+            int err = 0;
+            socklen_t len = sizeof(err);
+            if(::getsockopt(fd, SOL_SOCKET, SO_ERROR, (char *)&err, &len))
+                err = errno;
+            errno = err;
+            result = err ? -1 : 0;
+            break;
+        }
+        object->flags = 1;
+        result = ::connect(fd, (const struct sockaddr *)object->data, object->addrlen);
+        if(result < 0 && errno == EINPROGRESS)
+            return false;
+        break;
+    case RECV:
+        result = ::recv(fd, (char *)object->data, object->size, object->flags | MSG_DONTWAIT);
+        break;
+    case SEND:
+        result = ::send(fd, (const char *)object->data, object->size, object->flags | MSG_DONTWAIT | MSG_NOSIGNAL);
+        break;
+    }
+
+    if(result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+        return false;
+
+    if(result < 0) {
+        object->status = -1;
+        object->err = errno;
+    }
+    else {
+        object->status = result;
+        object->err = 0;
+    }
+    return true;
+}
+
+void AsyncIO::Backend::wait(timeout_t timeout)
+{
+    unsigned count = waiting.count;
+    if(!count)
+        return;
+
+    if(count > limit) {
+        struct pollfd *expand = (struct pollfd *)::realloc(fds, sizeof(struct pollfd) * count);
+        if(!expand)
+            __THROW_ALLOC();
+        fds = expand;
+        limit = count;
+    }
+
+    unsigned pos = 0;
+    request *object = waiting.head;
+    while(object) {
+        fds[pos].fd = object->fd;
+        fds[pos].revents = 0;
+        switch(object->op) {
+        case ACCEPT:
+        case RECV:
+        case READ:
+            fds[pos].events = POLLIN;
+            break;
+        default:
+            fds[pos].events = POLLOUT;
+            break;
+        }
+        object = object->next;
+        ++pos;
+    }
+
+    int msec = -1;
+    if(timeout != Timer::inf)
+        msec = timeout > (timeout_t)INT_MAX ? INT_MAX : (int)timeout;
+
+    if(::poll(fds, count, msec) < 1)
+        return;
+
+    request *prior = NULL;
+    pos = 0;
+    object = waiting.head;
+    while(object) {
+        request *next = object->next;
+        if(fds[pos++].revents && perform(object)) {
+            if(prior)
+                prior->next = next;
+            else
+                waiting.head = next;
+            if(waiting.tail == object)
+                waiting.tail = prior;
+            --waiting.count;
+            done.add(object);
+        }
+        else
+            prior = object;
+        object = next;
+    }
+}
+
+AsyncIO::request::request()
+{
+    next = NULL;
+    op = READ;
+    fd = -1;
+    data = NULL;
+    size = 0;
+    offset = -1;
+    flags = 0;
+    address = NULL;
+    addrlen = 0;
+    status = 0;
+    err = 0;
+    busy = false;
+}
+
+AsyncIO::request::~request()
+{
+}
+
+void AsyncIO::request::completed(void)
+{
+}
+
+AsyncIO::AsyncIO(unsigned depth)
+{
+    if(depth < 8)
+        depth = 8;
+
+    inflight = 0;
+    backend = new Backend(depth);
+}
+
+AsyncIO::~AsyncIO()
+{
+    delete backend;
+}
+
+bool AsyncIO::is_native(void) const
+{
+#ifdef  ASYNCIO_URING
+    return backend->ring > -1;
+#else
+    return false;
+#endif
+}
+
+bool AsyncIO::queue(request *object, operation_t op, int fd, void *data, size_t size, off_t offset, int flags)
+{
+    if(!object || object->busy || fd < 0)
+        return false;
+
+    object->op = op;
+    object->fd = fd;
+    object->data = data;
+    object->size = size;
+    object->offset = offset;
+    object->flags = flags;
+    object->address = NULL;
+    object->addrlen = 0;
+    object->status = 0;
+    object->err = 0;
+    object->busy = true;
+    backend->queued.add(object);
+    ++inflight;
+    return true;
+}
+
+bool AsyncIO::read(request *object, fd_t file, void *buffer, size_t size, off_t offset)
+{
+    return queue(object, READ, file, buffer, size, offset, 0);
+}
+
+bool AsyncIO::write(request *object, fd_t file, const void *buffer, size_t size, off_t offset)
+{
+    return queue(object, WRITE, file, (void *)buffer, size, offset, 0);
+}
+
+bool AsyncIO::fsync(request *object, fd_t file)
+{
+    return queue(object, FSYNC, file, NULL, 0, -1, 0);
+}
+
+bool AsyncIO::accept(request *object, socket_t socket, struct sockaddr_storage *address)
+{
+    if(!queue(object, ACCEPT, socket, NULL, 0, -1, 0))
+        return false;
+
+    if(address) {
+        object->address = address;
+        object->addrlen = sizeof(struct sockaddr_storage);
+    }
+    return true;
+}
+
+bool AsyncIO::connect(request *object, socket_t socket, const struct sockaddr *address)
+{
+    if(!address || !queue(object, CONNECT, socket, (void *)address, 0, -1, 0))
+        return false;
+
+    object->addrlen = Socket::len(address);
+    return true;
+}
+
+bool AsyncIO::recv(request *object, socket_t socket, void *buffer, size_t size, int flags)
+{
+    return queue(object, RECV, socket, buffer, size, -1, flags);
+}
+
+bool AsyncIO::send(request *object, socket_t socket, const void *buffer, size_t size, int flags)
+{
+    return queue(object, SEND, socket, (void *)buffer, size, -1, flags);
+}
+
+unsigned AsyncIO::submit(void)
+{
+    unsigned count = 0;
+    request *object;
+
+#ifdef  ASYNCIO_URING
+    if(backend->ring > -1) {
+        // a full ring is entered to make room for the rest of the batch...
+        while(backend->queued.head) {
+            if(!backend->prepare(backend->queued.head)) {
+                count += backend->enter();
+                if(!backend->prepare(backend->queued.head))
+                    break;
+            }
+            backend->queued.take();
+        }
+        return count + backend->enter();
+    }
+#endif
+
+    // accept may block, so it is only tried once poll says it is ready...
+    while(NULL != (object = backend->queued.take())) {
+        ++count;
+        if(object->op != ACCEPT && backend->perform(object))
+            backend->done.add(object);
+        else
+            backend->waiting.add(object);
+    }
+    return count;
+}
+
+unsigned AsyncIO::complete(timeout_t timeout)
+{
+    unsigned count = 0;
+    request *object;
+
+    submit();
+
+#ifdef  ASYNCIO_URING
+    if(backend->ring > -1) {
+        if(!backend->reap() && !backend->done.head && inflight && timeout) {
+            struct pollfd pfd;
+            int msec = -1;
+            if(timeout != Timer::inf)
+                msec = timeout > (timeout_t)INT_MAX ? INT_MAX : (int)timeout;
+            pfd.fd = backend->ring;
+            pfd.events = POLLIN;
+            pfd.revents = 0;
+            if(::poll(&pfd, 1, msec) > 0)
+                backend->reap();
+        }
+    }
+    else
+#endif
+    if(!backend->done.head)
+        backend->wait(timeout);
+
+    // requests may be queued again from their own callback...
+    while(NULL != (object = backend->done.take())) {
+        object->busy = false;
+        --inflight;
+        ++count;
+        object->completed();
+    }
+    return count;
+}
+
+} // namespace ucommon
+
+#endif
@@ -65,6 +65,11 @@ bool Atomic::is_lockfree(void)
     return true;
 }
 
+void Atomic::fence(void)
+{
+    MemoryBarrier();
+}
+
 atomic_t Atomic::counter::fetch_add(atomic_t change) volatile
 {
     return InterlockedExchangeAdd(&value, change);
@@ -95,6 +100,11 @@ void Atomic::counter::clear() volatile
     _InterlockedAnd(&value, 0);
 }
 
+bool Atomic::counter::compare_exchange(atomic_t expected, atomic_t desired) volatile
+{
+    return InterlockedCompareExchange(&value, desired, expected) == expected;
+}
+
 bool Atomic::spinlock::acquire() volatile
 {
     return !InterlockedBitTestAndSet(&value, 1);
@@ -122,6 +132,11 @@ bool Atomic::is_lockfree(void)
     return std::atomic_is_lock_free(ptr);
 }
 
+void Atomic::fence(void)
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
 atomic_t Atomic::counter::get() volatile
 {
     return std::atomic_load_explicit((atomic_val)(&value), std::memory_order_acquire);
@@ -132,6 +147,11 @@ void Atomic::counter::clear() volatile
     std::atomic_fetch_and_explicit((atomic_val)(&value), (atomic_t)0, std::memory_order_release);
 }
 
+bool Atomic::counter::compare_exchange(atomic_t expected, atomic_t desired) volatile
+{
+    return std::atomic_compare_exchange_strong((atomic_val)(&value), &expected, desired);
+}
+
 atomic_t Atomic::counter::fetch_retain() volatile
 {
     return std::atomic_fetch_add_explicit((atomic_val)(&value), (atomic_t)1, std::memory_order_relaxed);
@@ -179,6 +199,11 @@ bool Atomic::is_lockfree(void)
     return true;
 }
 
+void Atomic::fence(void)
+{
+    __c11_atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
 atomic_t Atomic::counter::get() volatile
 {
     return __c11_atomic_load((atomic_val)(&value), __ATOMIC_ACQUIRE);
@@ -189,6 +214,11 @@ void Atomic::counter::clear() volatile
     __c11_atomic_fetch_and((atomic_val)(&value), (atomic_t)0, __ATOMIC_RELEASE);
 }
 
+bool Atomic::counter::compare_exchange(atomic_t expected, atomic_t desired) volatile
+{
+    return __c11_atomic_compare_exchange_strong((atomic_val)(&value), &expected, desired, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
 atomic_t Atomic::counter::fetch_retain() volatile
 {
     return __c11_atomic_fetch_add((atomic_val)(&value), (atomic_t)1, __ATOMIC_RELAXED);
@@ -235,6 +265,11 @@ bool Atomic::is_lockfree(void)
     return true;
 }
 
+void Atomic::fence(void)
+{
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
 atomic_t Atomic::counter::fetch_retain() volatile
 {
     return __atomic_fetch_add(&value, (atomic_t)1, __ATOMIC_RELAXED);
@@ -257,7 +292,7 @@ atomic_t Atomic::counter::fetch_sub(atomic_t change) volatile
 
 atomic_t Atomic::counter::get() volatile
 {
-    return __atomic_fetch_add(&value, 0, __ATOMIC_ACQUIRE);
+    return __atomic_load_n(&value, __ATOMIC_ACQUIRE);
 }
 
 void Atomic::counter::clear() volatile
@@ -265,6 +300,11 @@ void Atomic::counter::clear() volatile
     __atomic_fetch_and(&value, (atomic_t)0, __ATOMIC_RELEASE);
 }
 
+bool Atomic::counter::compare_exchange(atomic_t expected, atomic_t desired) volatile
+{
+    return __atomic_compare_exchange_n(&value, &expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
 bool Atomic::spinlock::acquire(void) volatile
 {
     // if not locked by another already, then we acquired it...
@@ -291,6 +331,11 @@ bool Atomic::is_lockfree(void)
     return true;
 }
 
+void Atomic::fence(void)
+{
+    __sync_synchronize();
+}
+
 atomic_t Atomic::counter::fetch_retain() volatile
 {
     return __sync_fetch_and_add(&value, (atomic_t)1);
@@ -321,6 +366,11 @@ void Atomic::counter::clear() volatile
     __sync_fetch_and_and(&value, (atomic_t)0);
 }
 
+bool Atomic::counter::compare_exchange(atomic_t expected, atomic_t desired) volatile
+{
+    return __sync_bool_compare_and_swap(&value, expected, desired);
+}
+
 bool Atomic::spinlock::acquire(void) volatile
 {
     // if not locked by another already, then we acquired it...
@@ -347,6 +397,15 @@ bool Atomic::is_lockfree(void)
     return false;
 }
 
+void Atomic::fence(void)
+{
+    static atomic_t barrier = 0;
+
+    // taking and releasing a lock orders memory around it...
+    Mutex::protect((void *)&barrier);
+    Mutex::release((void *)&barrier);
+}
+
 atomic_t Atomic::counter::get() volatile
 {
     atomic_t rval;
@@ -363,6 +422,18 @@ void Atomic::counter::clear() volatile
     Mutex::release((void *)&value);
 }
 
+bool Atomic::counter::compare_exchange(atomic_t expected, atomic_t desired) volatile
+{
+    bool rtn = false;
+    Mutex::protect((void *)&value);
+    if(value == expected) {
+        value = desired;
+        rtn = true;
+    }
+    Mutex::release((void *)&value);
+    return rtn;
+}
+
 atomic_t Atomic::counter::fetch_add(atomic_t change) volatile
 {
     atomic_t rval;
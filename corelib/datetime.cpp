@@ -24,6 +24,7 @@
 #include <ucommon/datetime.h>
 #include <ucommon/thread.h>
 #include <ucommon/timers.h>
+#include <ucommon/atomic.h>
 #include <stdlib.h>
 #include <ctype.h>
 #ifdef HAVE_UNISTD_H
@@ -49,19 +50,10 @@ const size_t DateTime::sz_string = 20;
 
 tm_t *DateTime::local(const time_t *now)
 {
-    tm_t *result, *dt = new tm_t;
-    time_t tmp;
+    tm_t *dt = new tm_t;
 
-    if(!now) {
-        now = &tmp;
-        time(&tmp);
-    }
-
-    result = localtime_r(now, dt);
-    if(result)
-        return result;
-    delete dt;
-    return NULL;
+    local(*dt, now);
+    return dt;
 }
 
 tm_t *DateTime::gmt(const time_t *now)
@@ -134,6 +126,125 @@ void DateTime::release(tm_t *dt)
 
 #endif
 
+// the local time of the most recent second converted.  It is changed
+// under an odd sequence, so a reader knows if what it copied was being
+// changed and converts for itself instead...
+static struct {
+    Atomic::counter sequence;
+    time_t second;
+    tm_t local;
+    char text[20];
+} cache;
+
+static bool fetch(time_t now, tm_t *dt, char *text)
+{
+    atomic_t seq = cache.sequence.get();
+
+    if(!seq || (seq & 1) || cache.second != now)
+        return false;
+
+    if(dt)
+        *dt = cache.local;
+    if(text)
+        memcpy(text, cache.text, sizeof(cache.text));
+
+    // a full barrier that also confirms nothing changed while copying
+    return cache.sequence.compare_exchange(seq, seq);
+}
+
+static void store(time_t now, const tm_t *dt, const char *text)
+{
+    atomic_t seq = cache.sequence.get();
+
+    // another thread is storing, or a newer second is already kept...
+    if((seq & 1) || (seq && now <= cache.second))
+        return;
+
+    if(!cache.sequence.compare_exchange(seq, (atomic_t)((unsigned)seq + 1)))
+        return;
+
+    cache.second = now;
+    cache.local = *dt;
+    memcpy(cache.text, text, sizeof(cache.text));
+    cache.sequence.fetch_add(1);
+}
+
+// keeps a field of the stamp within it's width, so the stamp always fits
+static inline unsigned field(int value, unsigned limit)
+{
+    if(value < 0)
+        return 0;
+    if((unsigned)value > limit)
+        return limit;
+    return (unsigned)value;
+}
+
+static void convert(time_t now, tm_t *dt, char *text)
+{
+#ifdef  HAVE_LOCALTIME_R
+    if(!localtime_r(&now, dt))
+        memset(dt, 0, sizeof(tm_t));
+#else
+    tm_t *result = DateTime::local(&now);
+    if(result) {
+        *dt = *result;
+        DateTime::release(result);
+    }
+    else
+        memset(dt, 0, sizeof(tm_t));
+#endif
+
+    snprintf(text, sizeof(cache.text), "%04u-%02u-%02u %02u:%02u:%02u",
+        field(dt->tm_year + 1900, 9999), field(dt->tm_mon + 1, 12), field(dt->tm_mday, 31),
+        field(dt->tm_hour, 23), field(dt->tm_min, 59), field(dt->tm_sec, 60));
+
+    store(now, dt, text);
+}
+
+void DateTime::local(tm_t& result, const time_t *when)
+{
+    char text[sizeof(cache.text)];
+    time_t now;
+
+    if(when)
+        now = *when;
+    else
+        time(&now);
+
+    if(!fetch(now, &result, NULL))
+        convert(now, &result, text);
+}
+
+size_t DateTime::stamp(char *buffer, size_t size, bool millisec)
+{
+    char text[sizeof(cache.text) + 4];
+    struct timeval now;
+    size_t len = sizeof(cache.text) - 1;
+    tm_t dt;
+
+    if(!buffer || !size)
+        return 0;
+
+    gettimeofday(&now, NULL);
+    if(!fetch(now.tv_sec, NULL, text))
+        convert(now.tv_sec, &dt, text);
+
+    if(millisec) {
+        unsigned ms = (unsigned)(now.tv_usec / 1000);
+        text[len++] = '.';
+        text[len++] = (char)('0' + ms / 100);
+        text[len++] = (char)('0' + (ms / 10) % 10);
+        text[len++] = (char)('0' + ms % 10);
+    }
+
+    if(len >= size)
+        len = size - 1;
+
+    memcpy(buffer, text, len);
+    buffer[len] = 0;
+    return len;
+}
+
 Date::Date()
 {
     set();
@@ -151,9 +262,9 @@ Date::Date(const tm_t *dt)
 
 Date::Date(const time_t tm)
 {
-    tm_t *dt = DateTime::local(&tm);
-    set(dt->tm_year + 1900, dt->tm_mon + 1, dt->tm_mday);
-    DateTime::release(dt);
+    tm_t dt;
+    DateTime::local(dt, &tm);
+    set(dt.tm_year + 1900, dt.tm_mon + 1, dt.tm_mday);
 }
 
 Date::Date(const char *str, size_t size)
@@ -167,37 +278,38 @@ Date::~Date()
 
 void Date::set()
 {
-    tm_t *dt = DateTime::local();
+    tm_t dt;
+    DateTime::local(dt);
 
-    set(dt->tm_year + 1900, dt->tm_mon + 1, dt->tm_mday);
-    DateTime::release(dt);
+    set(dt.tm_year + 1900, dt.tm_mon + 1, dt.tm_mday);
 }
 
 void Date::set(const char *str, size_t size)
 {
-    tm_t *dt = DateTime::local();
+    tm_t dt;
     int nyear = 0;
     const char *mstr = str;
     const char *dstr = str;
 
+    DateTime::local(dt);
     if(!size)
         size = strlen(str);
 //0000
     if(size == 4) {
-        nyear = dt->tm_year + 1900;
+        nyear = dt.tm_year + 1900;
         mstr = str;
         dstr = str + 2;
     }
 //00/00
     else if(size == 5) {
-        nyear = dt->tm_year + 1900;
+        nyear = dt.tm_year + 1900;
         mstr = str;
         dstr = str + 3;
     }
 //000000
     else if(size == 6) {
         ZNumber zyear((char*)str, 2);
-        nyear = ((dt->tm_year + 1900) / 100) * 100 + zyear();
+        nyear = ((dt.tm_year + 1900) / 100) * 100 + zyear();
         mstr = str + 2;
         dstr = str + 4;
     }
@@ -211,7 +323,7 @@ void Date::set(const char *str, size_t size)
 //00/00/00
     else if(size == 8) {
         ZNumber zyear((char*)str, 2);
-        nyear = ((dt->tm_year + 1900) / 100) * 100 + zyear();
+        nyear = ((dt.tm_year + 1900) / 100) * 100 + zyear();
         mstr = str + 3;
         dstr = str + 6;
     }
@@ -224,11 +336,9 @@ void Date::set(const char *str, size_t size)
     }
     else {
         julian = 0x7fffffffl;
-        DateTime::release(dt);
         return;
     }
 
-    DateTime::release(dt);
     ZNumber nmonth((char*)mstr, 2);
     ZNumber nday((char*)dstr, 2);
     set(nyear, nmonth(), nday());
@@ -453,9 +563,9 @@ Time::Time(const tm_t *dt)
 
 Time::Time(const time_t tm)
 {
-    tm_t *dt = DateTime::local(&tm);
-    set(dt->tm_hour, dt->tm_min, dt->tm_sec);
-    DateTime::release(dt);
+    tm_t dt;
+    DateTime::local(dt, &tm);
+    set(dt.tm_hour, dt.tm_min, dt.tm_sec);
 }
 
 Time::Time(const char *str, size_t size)
@@ -474,9 +584,9 @@ Time::~Time()
 
 void Time::set(void)
 {
-    tm_t *dt = DateTime::local();
-    set(dt->tm_hour, dt->tm_min, dt->tm_sec);
-    DateTime::release(dt);
+    tm_t dt;
+    DateTime::local(dt);
+    set(dt.tm_hour, dt.tm_min, dt.tm_sec);
 }
 
 bool Time::is_valid(void) const
@@ -667,10 +777,10 @@ Time& Time::operator=(const Time& time)
 
 DateTime::DateTime(const time_t tm)
 {
-    tm_t *dt = DateTime::local();
-    Date::set(dt->tm_year + 1900, dt->tm_mon + 1, dt->tm_mday);
-    Time::set(dt->tm_hour, dt->tm_min, dt->tm_sec);
-    DateTime::release(dt);
+    tm_t dt;
+    DateTime::local(dt, &tm);
+    Date::set(dt.tm_year + 1900, dt.tm_mon + 1, dt.tm_mday);
+    Time::set(dt.tm_hour, dt.tm_min, dt.tm_sec);
 }
 
 DateTime::DateTime(const tm_t *dt) :
@@ -729,10 +839,10 @@ DateTime::DateTime(int year, unsigned month, unsigned day,
 
 DateTime::DateTime() : Date(), Time()
 {
-    tm_t *dt = DateTime::local();
-    Time::set(dt->tm_hour, dt->tm_min, dt->tm_sec);
-    Date::set(dt->tm_year + 1900, dt->tm_mon + 1, dt->tm_mday);
-    DateTime::release(dt);
+    tm_t dt;
+    DateTime::local(dt);
+    Time::set(dt.tm_hour, dt.tm_min, dt.tm_sec);
+    Date::set(dt.tm_year + 1900, dt.tm_mon + 1, dt.tm_mday);
 }
 
 DateTime::~DateTime()
@@ -873,12 +983,11 @@ stringref_t DateTime::format(const char *text) const
     char buffer[64];
     size_t last;
     time_t t;
-    tm_t *tbp;
+    tm_t tb;
 
     t = get();
-    tbp = local(&t);
-    last = ::strftime(buffer, 64, text, tbp);
-    release(tbp);
+    local(tb, &t);
+    last = ::strftime(buffer, 64, text, &tb);
 
     buffer[last] = '\0';
     return stringref_t(buffer);
@@ -0,0 +1,481 @@
+// Copyright (C) 2015-2020 Cherokees of Idaho.
+//
+// This file is part of GNU uCommon C++.
+//
+// GNU uCommon C++ is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// GNU uCommon C++ is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with GNU uCommon C++.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <ucommon-config.h>
+#include <ucommon/export.h>
+#include <ucommon/typeref.h>
+#include <ucommon/thread.h>
+#include <ucommon/mapref.h>
+#include <ucommon/flatmap.h>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace ucommon {
+
+// slots per control group, and control byte markers; any other byte
+// is the low 7 bits of the hash of the key held in that slot...
+#define FLAT_GROUP      16
+#define FLAT_EMPTY      0x80
+#define FLAT_DELETED    0xfe
+#define FLAT_TAG(h)     ((uint8_t)((h) & 0x7f))
+#define FLAT_GROUPS(m)  ((m)->capacity / FLAT_GROUP)
+
+static inline unsigned lowbit(unsigned mask)
+{
+#if defined(__GNUC__)
+    return (unsigned)__builtin_ctz(mask);
+#else
+    unsigned bit = 0;
+    while(!(mask & 1)) {
+        mask >>= 1;
+        ++bit;
+    }
+    return bit;
+#endif
+}
+
+FlatRef::Map::Map(void *addr, size_t size, TypeRelease *ar) :
+Counted(addr, sizeof(Map), ar)
+{
+    ctrl = NULL;
+    slots = NULL;
+    capacity = count = deleted = 0;
+    resize(size + size / 7);
+}
+
+unsigned FlatRef::Map::match(size_t group, uint8_t tag) const
+{
+    const uint8_t *bytes = ctrl + group * FLAT_GROUP;
+
+#if defined(__SSE2__)
+    __m128i block = _mm_loadu_si128((const __m128i *)bytes);
+    return (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(block, _mm_set1_epi8((char)tag)));
+#else
+    unsigned mask = 0;
+    for(unsigned pos = 0; pos < FLAT_GROUP; ++pos) {
+        if(bytes[pos] == tag)
+            mask |= (1u << pos);
+    }
+    return mask;
+#endif
+}
+
+bool FlatRef::Map::place(size_t hash, size_t& pos)
+{
+    size_t groups = FLAT_GROUPS(this);
+    size_t group = (hash >> 7) & (groups - 1);
+    size_t step = 0;
+    unsigned mask;
+
+    // triangular steps over a power of two visit every group once...
+    while(step < groups) {
+        mask = match(group, FLAT_EMPTY) | match(group, FLAT_DELETED);
+        if(mask) {
+            pos = group * FLAT_GROUP + lowbit(mask);
+            return true;
+        }
+        group = (group + ++step) & (groups - 1);
+    }
+    return false;
+}
+
+bool FlatRef::Map::resize(size_t size)
+{
+    size_t resize = FLAT_GROUP;
+    size_t pos;
+
+    while(resize < size)
+        resize <<= 1;
+
+    caddr_t block = (caddr_t)::malloc(resize * (sizeof(slot_t) + 1));
+    if(!block)
+        return false;
+
+    slot_t *old = slots;
+    uint8_t *prior = ctrl;
+    size_t index = capacity;
+
+    slots = (slot_t *)block;
+    ctrl = (uint8_t *)(block + resize * sizeof(slot_t));
+    capacity = resize;
+    deleted = 0;
+    memset(ctrl, FLAT_EMPTY, resize);
+
+    while(index--) {
+        if(prior[index] & 0x80)
+            continue;
+        place(old[index].hash, pos);
+        ctrl[pos] = prior[index];
+        slots[pos] = old[index];
+    }
+
+    if(old)
+        ::free(old);
+    return true;
+}
+
+FlatRef::slot_t *FlatRef::Map::insert(size_t hash)
+{
+    size_t pos;
+
+    // keep an eighth of the slots empty so unmatched probes end early...
+    if(count + deleted + 1 > capacity - capacity / 8) {
+        if(count + 1 > capacity / 2)
+            resize(capacity * 2);
+        else
+            resize(capacity);
+    }
+
+    if(count + deleted >= capacity || !place(hash, pos))
+        return NULL;
+
+    if(ctrl[pos] == FLAT_DELETED)
+        --deleted;
+    ctrl[pos] = FLAT_TAG(hash);
+    ++count;
+    slots[pos].key = slots[pos].value = NULL;
+    slots[pos].hash = hash;
+    return &slots[pos];
+}
+
+void FlatRef::Map::remove(size_t pos)
+{
+    slot_t *slot = &slots[pos];
+
+    if(slot->key)
+        slot->key->release();
+    if(slot->value)
+        slot->value->release();
+    slot->key = slot->value = NULL;
+
+    // a group that still has an empty slot never ended a probe early...
+    if(match(pos / FLAT_GROUP, FLAT_EMPTY))
+        ctrl[pos] = FLAT_EMPTY;
+    else {
+        ctrl[pos] = FLAT_DELETED;
+        ++deleted;
+    }
+    --count;
+}
+
+void FlatRef::Map::clear(void)
+{
+    size_t pos = capacity;
+
+    while(pos--) {
+        if(ctrl[pos] & 0x80)
+            continue;
+        if(slots[pos].key)
+            slots[pos].key->release();
+        if(slots[pos].value)
+            slots[pos].value->release();
+    }
+    memset(ctrl, FLAT_EMPTY, capacity);
+    count = deleted = 0;
+}
+
+void FlatRef::Map::dealloc()
+{
+    if(slots) {
+        clear();
+        ::free(slots);
+        slots = NULL;
+        ctrl = NULL;
+        capacity = 0;
+    }
+    Counted::dealloc();
+}
+
+FlatRef::Probe::Probe(Map *m, size_t hash)
+{
+    map = m;
+    tag = FLAT_TAG(hash);
+    step = 0;
+    pos = 0;
+    group = (hash >> 7) & (FLAT_GROUPS(map) - 1);
+    mask = map->match(group, tag);
+}
+
+bool FlatRef::Probe::next(void)
+{
+    for(;;) {
+        if(mask) {
+            pos = group * FLAT_GROUP + lowbit(mask);
+            mask &= mask - 1;
+            return true;
+        }
+
+        if(map->match(group, FLAT_EMPTY) || ++step >= FLAT_GROUPS(map))
+            return false;
+
+        group = (group + step) & (FLAT_GROUPS(map) - 1);
+        mask = map->match(group, tag);
+    }
+}
+
+FlatRef::Instance::Instance()
+{
+    map = NULL;
+    pos = 0;
+}
+
+FlatRef::Instance::Instance(FlatRef& from)
+{
+    map = static_cast<Map*>(from.ref);
+    pos = 0;
+    if(!map)
+        return;
+
+    map->retain();
+    map->lock.access();
+    rewind();
+}
+
+FlatRef::Instance::Instance(const Instance& copy)
+{
+    map = copy.map;
+    pos = copy.pos;
+    if(!map)
+        return;
+
+    map->retain();
+    map->lock.access();
+}
+
+FlatRef::Instance::~Instance()
+{
+    drop();
+}
+
+void FlatRef::Instance::drop()
+{
+    if(!map)
+        return;
+
+    map->lock.release();
+    map->release();
+    map = NULL;
+    pos = 0;
+}
+
+void FlatRef::Instance::assign(const Instance& copy)
+{
+    drop();
+    map = copy.map;
+    pos = copy.pos;
+    if(!map)
+        return;
+
+    map->retain();
+    map->lock.access();
+}
+
+void FlatRef::Instance::assign(FlatRef& from)
+{
+    drop();
+    map = static_cast<Map*>(from.ref);
+    if(!map)
+        return;
+
+    map->retain();
+    map->lock.access();
+    rewind();
+}
+
+void FlatRef::Instance::rewind()
+{
+    if(!map)
+        return;
+
+    pos = 0;
+    if(pos < map->capacity && (map->ctrl[pos] & 0x80))
+        next();
+}
+
+TypeRef::Counted *FlatRef::Instance::key()
+{
+    if(!map || pos >= map->capacity)
+        return NULL;
+
+    return map->slots[pos].key;
+}
+
+TypeRef::Counted *FlatRef::Instance::value()
+{
+    if(!map || pos >= map->capacity)
+        return NULL;
+
+    return map->slots[pos].value;
+}
+
+bool FlatRef::Instance::eol()
+{
+    if(!map)
+        return false;
+
+    return pos >= map->capacity;
+}
+
+bool FlatRef::Instance::next()
+{
+    if(!map)
+        return false;
+
+    while(++pos < map->capacity) {
+        if(!(map->ctrl[pos] & 0x80))
+            return true;
+    }
+    return false;
+}
+
+FlatRef::FlatRef() :
+TypeRef()
+{
+}
+
+FlatRef::FlatRef(const FlatRef& copy) :
+TypeRef(copy)
+{
+}
+
+FlatRef::FlatRef(size_t size, TypeRelease *ar) :
+TypeRef(create(size, ar))
+{
+}
+
+FlatRef::Map *FlatRef::create(size_t size, TypeRelease *ar)
+{
+    if(!ar)
+        ar = &auto_release;
+
+    caddr_t p = ar->allocate(sizeof(Map));
+    Map *m = new(mem(p)) Map(p, size, ar);
+    if(!m->slots) {
+        m->retain();
+        m->release();
+        return NULL;
+    }
+    return m;
+}
+
+size_t FlatRef::count(void)
+{
+    Map *m = polydynamic_cast<Map *>(ref);
+    if(!m)
+        return 0;
+
+    return m->count;
+}
+
+size_t FlatRef::capacity(void)
+{
+    Map *m = polydynamic_cast<Map *>(ref);
+    if(!m)
+        return 0;
+
+    return m->capacity;
+}
+
+void FlatRef::purge(void)
+{
+    Map *m = modify();
+    if(!m)
+        return;
+
+    m->clear();
+    commit(m);
+}
+
+FlatRef::Map *FlatRef::access(void)
+{
+    Map *m = polydynamic_cast<Map *>(ref);
+    if(!m || !m->slots)
+        return NULL;
+
+    m->retain();
+    m->lock.access();
+    return m;
+}
+
+FlatRef::Map *FlatRef::modify(void)
+{
+    Map *m = polydynamic_cast<Map *>(ref);
+    if(!m || !m->slots)
+        return NULL;
+
+    m->retain();
+    m->lock.modify();
+    return m;
+}
+
+void FlatRef::add(Map *m, size_t hash, TypeRef& key, TypeRef& value)
+{
+    slot_t *slot = m->insert(hash);
+    if(!slot)
+        return;
+
+    slot->key = key.ref;
+    slot->value = value.ref;
+    if(slot->key)
+        slot->key->retain();
+    if(slot->value)
+        slot->value->retain();
+}
+
+void FlatRef::update(slot_t *slot, TypeRef& value)
+{
+    if(!slot)
+        return;
+
+    if(slot->value)
+        slot->value->release();
+    slot->value = value.ref;
+    if(slot->value)
+        slot->value->retain();
+}
+
+void FlatRef::remove(Map *m, size_t pos)
+{
+    if(m)
+        m->remove(pos);
+}
+
+// the map locked is passed back, since the reference may have been set
+// to another map while it was held...
+void FlatRef::commit(Map *m)
+{
+    if(!m)
+        return;
+
+    m->lock.commit();
+    m->release();
+}
+
+void FlatRef::release(Map *m)
+{
+    if(!m)
+        return;
+
+    m->lock.release();
+    m->release();
+}
+
+} // namespace
@@ -85,6 +85,19 @@
 #include <sys/event.h>
 #endif
 
+#ifdef  HAVE_SYS_SENDFILE_H
+#include <sys/sendfile.h>
+#endif
+
+#ifdef  HAVE_LINUX_FS_H
+#include <sys/ioctl.h>
+#include <linux/fs.h>
+#endif
+
+#if !defined(_MSWINDOWS_) && !defined(HAVE_FUTIMENS)
+#include <utime.h>
+#endif
+
 namespace ucommon {
 
 const fsys::offset_t fsys::end = (offset_t)(-1);
@@ -1371,42 +1384,163 @@ int dir::remove(const char *path)
     return 0;
 }
 
+// files are copied through memory with at least this much buffer unless
+// told otherwise, and the kernel copies files this much at a time so that
+// progress may be reported...
+#define COPY_BUFFER     (256l * 1024l)
+#define COPY_CHUNK      (8l * 1024l * 1024l)
+
+#ifndef _MSWINDOWS_
+
+// a kernel copy method the kernel or filesystems cannot use fails before
+// copying anything, and the next method picks up from the same offsets...
+static bool unsupported(int err)
+{
+    return err == ENOSYS || err == EINVAL || err == EXDEV || err == EOPNOTSUPP || err == EBADF;
+}
+
+#endif
+
 int fsys::copy(const char *oldpath, const char *newpath, size_t size)
+{
+    return copy(oldpath, newpath, 0, NULL, NULL, size);
+}
+
+int fsys::copy(const char *oldpath, const char *newpath, unsigned options, progress_t progress, void *user, size_t size)
 {
     int result = 0;
-    char *buffer = new char[size];
+    char *buffer = NULL;
     fsys src, dest;
-    ssize_t count = (ssize_t)size;
-
-    if(!buffer) {
-        result = ENOMEM;
-        goto end;
-    }
+    fileinfo_t ino;
+    uint64_t total = 0, copied = 0;
+    ssize_t count, pos, written;
 
     remove(newpath);
 
     src.open(oldpath, fsys::STREAM);
     if(!is(src))
+        return src.err();
+
+    result = src.info(&ino);
+    if(result)
         goto end;
 
+    // files that claim no size, such as those in /proc, are read to the end
+    if(S_ISREG(ino.st_mode))
+        total = (uint64_t)ino.st_size;
+
     dest.open(newpath, GROUP_PUBLIC, fsys::STREAM);
-    if(!is(dest))
+    if(!is(dest)) {
+        result = dest.err();
         goto end;
+    }
+
+#ifndef _MSWINDOWS_
+    if(total > 0) {
+#ifdef  FICLONE
+        if(!(options & COPY_NOCLONE) && !ioctl(dest.fd, FICLONE, src.fd)) {
+            copied = total;
+            if(progress)
+                progress(user, copied, total);
+            goto done;
+        }
+#endif
+#ifdef  HAVE_COPY_FILE_RANGE
+        for(;;) {
+            count = ::copy_file_range(src.fd, NULL, dest.fd, NULL, COPY_CHUNK, 0);
+            if(count < 0 && !copied && unsupported(errno))
+                break;
+            if(count < 0) {
+                result = remapError();
+                goto end;
+            }
+            if(!count)
+                goto done;
+            copied += count;
+            if(progress && !progress(user, copied, total)) {
+                result = ECANCELED;
+                goto end;
+            }
+        }
+#endif
+#ifdef  HAVE_SYS_SENDFILE_H
+        for(;;) {
+            count = ::sendfile(dest.fd, src.fd, NULL, COPY_CHUNK);
+            if(count < 0 && !copied && unsupported(errno))
+                break;
+            if(count < 0) {
+                result = remapError();
+                goto end;
+            }
+            if(!count)
+                goto done;
+            copied += count;
+            if(progress && !progress(user, copied, total)) {
+                result = ECANCELED;
+                goto end;
+            }
+        }
+#endif
+    }
+#endif
+
+    if(!size)
+        size = COPY_BUFFER;
 
-    while(count > 0) {
+    buffer = new char[size];
+    for(;;) {
         count = src.read(buffer, size);
         if(count < 0) {
             result = src.err();
             goto end;
         }
-        if(count > 0)
-            count = dest.write(buffer, size);
-        if(count < 0) {
-            result = dest.err();
+        if(!count)
+            break;
+        for(pos = 0; pos < count; pos += written) {
+            written = dest.write(buffer + pos, count - pos);
+            if(written <= 0) {
+                result = dest.err() ? dest.err() : EIO;
+                goto end;
+            }
+        }
+        copied += count;
+        if(progress && !progress(user, copied, total)) {
+            result = ECANCELED;
             goto end;
         }
     }
 
+done:
+#ifndef _MSWINDOWS_
+    // only privileged users may give files away; others keep their copy...
+    if((options & COPY_OWNER) && fchown(dest.fd, ino.st_uid, ino.st_gid) && errno != EPERM) {
+        result = remapError();
+        goto end;
+    }
+
+    // set after the owner, since changing owner clears set id bits...
+    if((options & COPY_MODE) && fchmod(dest.fd, ino.st_mode & 07777)) {
+        result = remapError();
+        goto end;
+    }
+
+    if(options & COPY_TIMES) {
+#ifdef  HAVE_FUTIMENS
+        struct timespec times[2];
+        times[0] = ino.st_atim;
+        times[1] = ino.st_mtim;
+        if(futimens(dest.fd, times))
+            result = remapError();
+#else
+        struct utimbuf times;
+        times.actime = ino.st_atime;
+        times.modtime = ino.st_mtime;
+        if(utime(newpath, &times))
+            result = remapError();
+#endif
+    }
+#endif
+
 end:
     if(is(src))
         src.close();
@@ -24,19 +24,170 @@
 #include <ucommon/string.h>
 #include <ctype.h>
 
+#ifdef  HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
+#ifdef  HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#endif
+
 namespace ucommon {
 
-keydata::keyvalue::keyvalue(keyfile *allocator, keydata *section, const char *kv, const char *dv) :
+// a loaded file, kept mapped while keys refer into it...
+class __LOCAL keyfile::mapping
+{
+public:
+    mapping *next;
+    caddr_t addr;
+    size_t size;
+};
+
+// an index of sections and keys while a mapped file is loaded, so that
+// names already defined are found without searching every list...
+class __LOCAL keyfile::loader
+{
+private:
+    __DELETE_COPY(loader);
+
+    class entry
+    {
+    public:
+        entry *next;
+        keydata *section;
+        keydata::keyvalue *key;
+    };
+
+    memalloc pager;
+    entry **table;
+    unsigned size;
+
+    entry **path(keydata *section, const char *id) const;
+
+public:
+    loader(keyfile *file, size_t count);
+    ~loader();
+
+    keydata *get(const char *id) const;
+    keydata::keyvalue *get(keydata *section, const char *id) const;
+    void add(keydata *section);
+    void add(keydata *section, keydata::keyvalue *key);
+};
+
+keyfile::loader::loader(keyfile *file, size_t count) :
+pager()
+{
+    size = 64;
+    while(size < count && size < 0x100000)
+        size <<= 1;
+
+    table = new entry *[size];
+    memset(table, 0, sizeof(entry *) * size);
+
+    linked_pointer<keydata::keyvalue> vp = file->defaults->begin();
+    while(is(vp)) {
+        add(file->defaults, *vp);
+        vp.next();
+    }
+
+    linked_pointer<keydata> kp = file->begin();
+    while(is(kp)) {
+        add(*kp);
+        kp.next();
+    }
+}
+
+keyfile::loader::~loader()
+{
+    delete[] table;
+}
+
+// names are matched without case, so they are hashed without it...
+keyfile::loader::entry **keyfile::loader::path(keydata *section, const char *id) const
+{
+    uint32_t val = 2166136261u;
+
+    if(section)
+        val ^= (uint32_t)((uintptr_t)section >> 4);
+
+    while(*id) {
+        val = (val ^ (uint32_t)tolower(*id++)) * 16777619u;
+    }
+    return &table[val & (size - 1)];
+}
+
+keydata *keyfile::loader::get(const char *id) const
+{
+    entry *node = *path(NULL, id);
+
+    while(node) {
+        if(!node->key && eq_case(id, node->section->get()))
+            return node->section;
+        node = node->next;
+    }
+    return NULL;
+}
+
+keydata::keyvalue *keyfile::loader::get(keydata *section, const char *id) const
+{
+    entry *node = *path(section, id);
+
+    while(node) {
+        if(node->key && node->section == section && eq_case(id, node->key->id))
+            return node->key;
+        node = node->next;
+    }
+    return NULL;
+}
+
+void keyfile::loader::add(keydata *section)
+{
+    entry **root = path(NULL, section->get());
+    entry *node = (entry *)pager.alloc(sizeof(entry));
+
+    node->section = section;
+    node->key = NULL;
+    node->next = *root;
+    *root = node;
+
+    linked_pointer<keydata::keyvalue> vp = section->begin();
+    while(is(vp)) {
+        add(section, *vp);
+        vp.next();
+    }
+}
+
+void keyfile::loader::add(keydata *section, keydata::keyvalue *key)
+{
+    entry **root = path(section, key->id);
+    entry *node = (entry *)pager.alloc(sizeof(entry));
+
+    node->section = section;
+    node->key = key;
+    node->next = *root;
+    *root = node;
+}
+
+keydata::keyvalue::keyvalue(keyfile *allocator, keydata *section, const char *kv, const char *dv, bool copy) :
 OrderedObject(&section->index)
 {
     assert(allocator != NULL);
     assert(section != NULL);
     assert(kv != NULL);
 
-    id = allocator->dup(kv);
+    if(copy)
+        id = allocator->dup(kv);
+    else
+        id = kv;
 
-    if(dv)
+    if(dv && copy)
         value = allocator->dup(dv);
+    else if(dv)
+        value = dv;
     else
         value = "";
 }
@@ -110,6 +261,7 @@ memalloc(pagesize), index()
 {
     errcode = 0;
     defaults = NULL;
+    mapped = NULL;
 }
 
 keyfile::keyfile(const char *path, size_t pagesize) :
@@ -117,6 +269,7 @@ memalloc(pagesize), index()
 {
     errcode = 0;
     defaults = NULL;
+    mapped = NULL;
     load(path);
 }
 
@@ -125,28 +278,49 @@ memalloc(pagesize), index()
 {
     errcode = 0;
     defaults = NULL;
+    mapped = NULL;
     load(&copy);
 }
 
+keyfile::~keyfile()
+{
+    unmap();
+}
+
 void keyfile::assign(keyfile& source)
 {
+    unmap();
     errcode = source.errcode;
     defaults = source.defaults;
+    mapped = source.mapped;
     index.copy(source.index);
 
     memalloc::assign(source);
     source.errcode = 0;
     source.defaults = NULL;
+    source.mapped = NULL;
     source.index.reset();
 }
 
 void keyfile::release(void)
 {
+    unmap();
     defaults = NULL;
     index.reset();
     memalloc::purge();
 }
 
+void keyfile::unmap(void)
+{
+#ifdef HAVE_SYS_MMAN_H
+    while(mapped) {
+        ::munmap(mapped->addr, mapped->size);
+        mapped = mapped->next;
+    }
+#endif
+    mapped = NULL;
+}
+
 keydata *keyfile::get(const char *key) const
 {
     assert(key != NULL);
@@ -355,6 +529,172 @@ bool keyfile::save(const char *path)
     return true;
 }
 
+keydata *keyfile::parse(keydata *section, char *lp, loader *from)
+{
+    keydata::keyvalue *kv;
+    keydata *target;
+    const char *key;
+    char *value;
+    char *ep;
+
+    while(isspace(*lp))
+        ++lp;
+
+    if(!*lp)
+        return section;
+
+    if(*lp == '[') {
+        ep = strchr(lp, ']');
+        if(!ep)
+            return section;
+        *ep = 0;
+        lp = String::strip(++lp, " \t");
+        if(!from) {
+            section = get(lp);
+            if (!section)
+                section = create(lp);
+            return section;
+        }
+        section = from->get(lp);
+        if(!section) {
+            section = new(alloc(sizeof(keydata))) keydata(this, lp);
+            from->add(section);
+        }
+        return section;
+    }
+    else if(!isalnum(*lp) || !strchr(lp, '='))
+        return section;
+
+    ep = strchr(lp, '=');
+    *ep = 0;
+    key = String::strip(lp, " \t");
+    value = String::strip(++ep, " \t\r\n");
+    value = String::unquote(value, "\"\"\'\'{}()");
+    target = section ? section : defaults;
+    if(!from) {
+        target->set(key, value);
+        return section;
+    }
+
+    // mapped keys and values are used in place...
+    kv = from->get(target, key);
+    if(kv)
+        kv->delist(&target->index);
+    kv = new(alloc(sizeof(keydata::keyvalue))) keydata::keyvalue(this, target, key, value, false);
+    from->add(target, kv);
+    return section;
+}
+
+#ifdef HAVE_SYS_MMAN_H
+
+static char *chop(char *lp, char *ep)
+{
+    while(ep > lp && strchr("\r\n\t ", ep[-1]))
+        *(--ep) = 0;
+    return ep;
+}
+
+bool keyfile::map(const char *path)
+{
+    struct stat ino;
+    keydata *section = NULL;
+    mapping *mp;
+    caddr_t addr;
+    char *lp, *sp, *ep, *np, *next, *end;
+    size_t size, len;
+
+    int fd = ::open(path, O_RDONLY);
+    if(fd < 0)
+        return false;
+
+    // pipes, devices, and empty files are read the usual way...
+    if(fstat(fd, &ino) || !S_ISREG(ino.st_mode) || ino.st_size < 1) {
+        ::close(fd);
+        return false;
+    }
+
+    // a page of a private mapping is only our own once written, and one
+    // still shared with a file cut short while we parse would fault, so
+    // where we can they are all copied as they are mapped, and a file cut
+    // short before that finished is read the usual way...
+    size = (size_t)ino.st_size;
+#ifdef  MAP_POPULATE
+    addr = (caddr_t)::mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+#else
+    addr = (caddr_t)::mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+#endif
+    if(addr != (caddr_t)MAP_FAILED && (fstat(fd, &ino) || (size_t)ino.st_size < size)) {
+        ::munmap(addr, size);
+        addr = (caddr_t)MAP_FAILED;
+    }
+    ::close(fd);
+    if(addr == (caddr_t)MAP_FAILED)
+        return false;
+
+    mp = (mapping *)alloc(sizeof(mapping));
+    mp->addr = addr;
+    mp->size = size;
+    mp->next = mapped;
+    mapped = mp;
+
+    errcode = 0;
+    if(!defaults) {
+        void *mem = alloc(sizeof(keydata));
+        defaults = new(mem) keydata(this);
+    }
+
+    // lines are terminated in place, so keys and values refer into the
+    // mapping rather than being copied again...
+    loader keys(this, size / 32);
+    lp = addr;
+    end = addr + size;
+    while(lp < end) {
+        np = (char *)memchr(lp, '\n', end - lp);
+        if(np)
+            next = np + 1;
+        else {
+            len = end - lp;
+            np = (char *)alloc(len + 1);
+            memcpy(np, lp, len);
+            lp = np;
+            np += len;
+            next = end;
+        }
+        *np = 0;
+        ep = chop(lp, np);
+
+        // continued lines are moved down to join the line before, and
+        // continue again only if what was joined ends in a backslash...
+        sp = lp;
+        while(ep > sp && ep[-1] == '\\') {
+            *(--ep) = 0;
+            if(next >= end)
+                break;
+            np = (char *)memchr(next, '\n', end - next);
+            len = (np ? np : end) - next;
+            memmove(ep, next, len);
+            ep[len] = 0;
+            next = np ? np + 1 : end;
+            sp = ep;
+            ep = chop(sp, sp + len);
+        }
+
+        section = parse(section, lp, &keys);
+        lp = next;
+    }
+    return true;
+}
+
+#else
+
+bool keyfile::map(const char *path)
+{
+    __UNUSED(path);
+    return false;
+}
+
+#endif
+
 void keyfile::load(const char *path)
 {
     assert(path != NULL);
@@ -373,14 +713,15 @@ void keyfile::load(const char *path)
     }
 #endif
 
+    if(map(path))
+        return;
+
     char linebuf[1024];
     char *lp = linebuf;
     char *ep;
     size_t size = sizeof(linebuf);
     FILE *fp = fopen(path, "r");
     keydata *section = NULL;
-    const char *key;
-    char *value;
 
     errcode = 0;
 
@@ -414,37 +755,7 @@ void keyfile::load(const char *path)
         if(!linebuf[0] && feof(fp))
             break;
 
-        lp = linebuf;
-        while(isspace(*lp))
-            ++lp;
-
-        if(!*lp)
-            goto next;
-
-        if(*lp == '[') {
-            ep = strchr(lp, ']');
-            if(!ep)
-                goto next;
-            *ep = 0;
-            lp = String::strip(++lp, " \t");
-            section = get(lp);
-            if (!section)
-                section = create(lp);
-            goto next;
-        }
-        else if(!isalnum(*lp) || !strchr(lp, '='))
-            goto next;
-
-        ep = strchr(lp, '=');
-        *ep = 0;
-        key = String::strip(lp, " \t");
-        value = String::strip(++ep, " \t\r\n");
-        value = String::unquote(value, "\"\"\'\'{}()");
-        if(section)
-            section->set(key, value);
-        else
-            defaults->set(key, value);
-next:
+        section = parse(section, linebuf);
         lp = linebuf;
         size = sizeof(linebuf);
     }
@@ -165,8 +165,10 @@ void NamedObject::add(NamedObject **root, char *nid, unsigned max)
                 prior->Next = this;
                 Next = node->Next;
             }
-            else
-                root[max] = node->getNext();
+            else {
+                Next = node->Next;
+                root[max] = this;
+            }
             node->release();
             break;
         }
@@ -240,11 +242,21 @@ unsigned NamedObject::keyindex(const char *id, unsigned max)
     assert(id != nullptr && *id != 0);
     assert(max > 1);
 
-    unsigned val = 0;
+    uint32_t val = 2166136261u;
+    unsigned char ch;
 
-    while(*id)
-        val = (val << 1) ^ (*(id++) & 0x1f);
+    // fnv-1a of every byte, case folded like the original 5 bit hash...
+    while(*id) {
+        ch = (unsigned char)*(id++);
+        if(ch >= 'A' && ch <= 'Z')
+            ch += 'a' - 'A';
+        val = (val ^ ch) * 16777619u;
+    }
 
+    // mix high bits down for table sizes that are not prime
+    val ^= val >> 16;
+    val *= 0x7feb352du;
+    val ^= val >> 15;
     return val % max;
 }
 
@@ -381,6 +393,85 @@ NamedObject *NamedObject::map(NamedObject **idx, const char *id, unsigned max)
     return find(idx[keyindex(id, max)], id);
 }
 
+NamedIndex::NamedIndex(unsigned max)
+{
+    if(max < 2)
+        max = 2;
+
+    size = max;
+    members = 0;
+    table = new NamedObject *[size];
+    memset(table, 0, sizeof(NamedObject *) * size);
+}
+
+NamedIndex::~NamedIndex()
+{
+    delete[] table;
+}
+
+void NamedIndex::resize(unsigned max)
+{
+    NamedObject **list = new NamedObject *[max];
+    NamedObject *node, *next;
+    unsigned path = size;
+
+    memset(list, 0, sizeof(NamedObject *) * max);
+    while(path--) {
+        node = table[path];
+        while(node) {
+            next = node->getNext();
+            static_cast<LinkedObject *>(node)->enlist(reinterpret_cast<LinkedObject **>(&list[NamedObject::keyindex(node->getId(), max)]));
+            node = next;
+        }
+    }
+    delete[] table;
+    table = list;
+    size = max;
+}
+
+void NamedIndex::add(NamedObject *object, char *name)
+{
+    assert(object != nullptr);
+    assert(name != nullptr && *name != 0);
+
+    if(!NamedObject::map(table, name, size))
+        ++members;
+
+    object->add(table, name, size);
+    if(members > size * 2)
+        resize(size * 2 + 1);
+}
+
+NamedObject *NamedIndex::map(const char *name) const
+{
+    return NamedObject::map(table, name, size);
+}
+
+NamedObject *NamedIndex::remove(const char *name)
+{
+    NamedObject *node = NamedObject::remove(table, name, size);
+    if(node)
+        --members;
+    return node;
+}
+
+NamedObject *NamedIndex::skip(NamedObject *current) const
+{
+    return NamedObject::skip(table, current, size);
+}
+
+NamedObject **NamedIndex::index(void) const
+{
+    return NamedObject::index(table, size);
+}
+
+void NamedIndex::purge(void)
+{
+    NamedObject::purge(table, size);
+    memset(table, 0, sizeof(NamedObject *) * size);
+    members = 0;
+}
+
 NamedObject *NamedObject::find(NamedObject *root, const char *id)
 {
     assert(id != nullptr && *id != 0);
@@ -18,6 +18,7 @@
 
 #include <ucommon-config.h>
 #include <ucommon/export.h>
+#include <ucommon/atomic.h>
 #include <ucommon/linked.h>
 #include <ucommon/string.h>
 #include <ucommon/timers.h>
@@ -62,6 +63,14 @@
 #include <sched.h>
 #endif
 
+#if defined(HAVE_LINUX_FUTEX_H)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#if defined(SYS_futex)
+#define MAPPED_FUTEX
+#endif
+#endif
+
 #if defined(__APPLE__) && defined(__MACH__)
 #define INSERT_OFFSET   16
 #endif
@@ -265,6 +274,40 @@ void MappedMemory::create(const char *fn, size_t len)
         __THROW_ALLOC();
 }
 
+void MappedMemory::attach(const char *fn)
+{
+    assert(fn != NULL && *fn != 0);
+
+    MEMORY_BASIC_INFORMATION info;
+
+    size = 0;
+    used = 0;
+    map = NULL;
+
+    if(!use_mapping)
+        return;
+
+    if(*fn == '/')
+        ++fn;
+
+    fd = OpenFileMapping(FILE_MAP_ALL_ACCESS, FALSE, fn);
+    if(fd == INVALID_HANDLE_VALUE || fd == NULL)
+        return;
+
+    map = (caddr_t)MapViewOfFile(fd, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+    if(!map || !VirtualQuery(map, &info, sizeof(info))) {
+        if(map)
+            UnmapViewOfFile(map);
+        CloseHandle(fd);
+        fd = INVALID_HANDLE_VALUE;
+        map = NULL;
+        return;
+    }
+
+    size = info.RegionSize;
+    VirtualLock(map, size);
+}
+
 MappedMemory::~MappedMemory()
 {
     release();
@@ -367,6 +410,51 @@ void MappedMemory::create(const char *fn, size_t len)
     }
 }
 
+void MappedMemory::attach(const char *fn)
+{
+    assert(fn != NULL && *fn != 0);
+
+    struct stat ino;
+    char fbuf[80];
+    size_t len;
+
+    size = 0;
+    used = 0;
+
+    if(!use_mapping) {
+        map = NULL;
+        return;
+    }
+
+    if(*fn != '/') {
+        snprintf(fbuf, sizeof(fbuf), "/%s", fn);
+        fn = fbuf;
+    }
+
+    fd = shm_open(fn, O_RDWR, 0664);
+    if(fd < 0)
+        return;
+
+    if(fstat(fd, &ino) || !ino.st_size) {
+        ::close(fd);
+        fd = -1;
+        return;
+    }
+
+    len = ino.st_size;
+    map = (caddr_t)mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if(map == (caddr_t)MAP_FAILED)
+        return;
+
+    size = mapsize = len;
+    mlock(map, mapsize);
+#if INSERT_OFFSET > 0
+    size = atol(map);
+    map += INSERT_OFFSET;
+#endif
+}
+
 MappedMemory::~MappedMemory()
 {
     release();
@@ -479,6 +567,12 @@ remake:
 #endif
 }
 
+void MappedMemory::attach(const char *name)
+{
+    // attached shared memory segments are always writable...
+    create(name, 0);
+}
+
 MappedMemory::~MappedMemory()
 {
     release();
@@ -506,6 +600,39 @@ void MappedMemory::release(void)
 
 #endif
 
+// a versioned record starts with a sequence number that is odd while the
+// record is being written, and its data is padded to keep the records that
+// follow aligned...
+#define RECORD_HEADER   8
+
+static void store(caddr_t record, const void *buffer, size_t size)
+{
+    volatile atomic_t *sequence = (volatile atomic_t *)record;
+    unsigned version = (unsigned)*sequence;
+
+    *sequence = (atomic_t)(version + 1);
+    Atomic::fence();
+    memcpy(record + RECORD_HEADER, buffer, size);
+    Atomic::fence();
+    *sequence = (atomic_t)(version + 2);
+}
+
+// one try at a consistent copy, which fails if the record was written
+// before or while being copied...
+static bool fetch(caddr_t record, void *buffer, size_t size)
+{
+    volatile atomic_t *sequence = (volatile atomic_t *)record;
+    atomic_t version = *sequence;
+
+    if(version & 1)
+        return false;
+
+    Atomic::fence();
+    memcpy(buffer, record + RECORD_HEADER, size);
+    Atomic::fence();
+    return *sequence == version;
+}
+
 void *MappedMemory::sbrk(size_t len)
 {
     assert(len > 0);
@@ -532,6 +659,93 @@ bool MappedMemory::copy(size_t offset, void *buffer, size_t bufsize) const
     return true;
 }
 
+size_t MappedMemory::record(size_t len)
+{
+    return RECORD_HEADER + ((len + RECORD_HEADER - 1) & ~((size_t)RECORD_HEADER - 1));
+}
+
+size_t MappedMemory::ring(size_t len, unsigned slots)
+{
+    return RECORD_HEADER + slots * record(len);
+}
+
+void MappedMemory::update(size_t offset, const void *buffer, size_t bufsize)
+{
+    if(!map || (offset + record(bufsize) > size)) {
+        __THROW_RANGE("Outside mapped memory");
+        return;
+    }
+
+    store(map + offset, buffer, bufsize);
+}
+
+bool MappedMemory::snapshot(size_t offset, void *buffer, size_t bufsize) const
+{
+    if(!map || (offset + record(bufsize) > size)) {
+        __THROW_RANGE("Outside mapped memory");
+        return false;
+    }
+
+    while(!fetch(map + offset, buffer, bufsize))
+        Thread::yield();
+
+    return true;
+}
+
+// the header of a ring holds the latest generation, and after it the
+// number of slots, so readers need not work that out from a map size that
+// may have been rounded up to whole pages...
+
+void MappedMemory::publish(size_t offset, const void *buffer, size_t bufsize, unsigned slots)
+{
+    if(!map || !slots || (offset + ring(bufsize, slots) > size)) {
+        __THROW_RANGE("Outside mapped memory");
+        return;
+    }
+
+    volatile atomic_t *generation = (volatile atomic_t *)(map + offset);
+    volatile uint32_t *count = (volatile uint32_t *)(map + offset + sizeof(atomic_t));
+    unsigned next = (unsigned)*generation + 1;
+
+    // a generation of 0 means nothing was published yet...
+    if(!next)
+        ++next;
+
+    *count = (uint32_t)slots;
+    store(map + offset + RECORD_HEADER + (next % slots) * record(bufsize), buffer, bufsize);
+    Atomic::fence();
+    *generation = (atomic_t)next;
+}
+
+bool MappedMemory::latest(size_t offset, void *buffer, size_t bufsize, unsigned slots) const
+{
+    if(!map || (offset + ring(bufsize, slots) > size)) {
+        __THROW_RANGE("Outside mapped memory");
+        return false;
+    }
+
+    volatile atomic_t *generation = (volatile atomic_t *)(map + offset);
+    volatile uint32_t *count = (volatile uint32_t *)(map + offset + sizeof(atomic_t));
+
+    // if the writer laps us, start over from its newest slot...
+    for(;;) {
+        unsigned current = (unsigned)*generation;
+        if(!current)
+            return false;
+        Atomic::fence();
+        if(!slots) {
+            slots = (unsigned)*count;
+            if(!slots || (offset + ring(bufsize, slots) > size)) {
+                __THROW_RANGE("Outside mapped memory");
+                return false;
+            }
+        }
+        if(fetch(map + offset + RECORD_HEADER + (current % slots) * record(bufsize), buffer, bufsize))
+            return true;
+        Thread::yield();
+    }
+}
+
 void *MappedMemory::offset(size_t offset) const
 {
     if(offset >= size)
@@ -644,4 +858,280 @@ ReusableObject *MappedReuse::getTimed(timeout_t timeout)
     return obj;
 }
 
+// the ring control block is shared by every process using the ring.  The
+// producer and consumer positions, and each side's wakeup, are kept on
+// lines of their own so the two sides do not contend on the same line.
+#define RING_LINE       64
+#define RING_MAGIC      0x52696e67
+
+// without futexes, a waiting side polls this often...
+#define RING_POLL       10
+
+class __LOCAL MappedRing::control
+{
+private:
+    __DELETE_COPY(control);
+
+public:
+    unsigned magic, objsize, count, multiple;
+    char pad1[RING_LINE - 4 * sizeof(unsigned)];
+    Atomic::counter head;
+    char pad2[RING_LINE - sizeof(Atomic::counter)];
+    Atomic::counter tail;
+    char pad3[RING_LINE - sizeof(Atomic::counter)];
+    Atomic::counter readable, readers;
+    char pad4[RING_LINE - 2 * sizeof(Atomic::counter)];
+    Atomic::counter writable, writers;
+    char pad5[RING_LINE - 2 * sizeof(Atomic::counter)];
+
+    inline control(size_t size, unsigned limit, bool many) :
+    head(0), tail(0), readable(0), readers(0), writable(0), writers(0) {
+        magic = 0;
+        objsize = (unsigned)size;
+        count = limit;
+        multiple = many;
+    }
+};
+
+// a side that must wait sleeps on a wakeup counter, which the other side
+// bumps before waking it.  The futex is the value held by the counter.
+#if defined(MAPPED_FUTEX)
+
+static void sleep_on(Atomic::counter *word, atomic_t value, timeout_t timeout)
+{
+    struct timespec ts, *tp = NULL;
+
+    if(timeout != Timer::inf) {
+        ts.tv_sec = timeout / 1000l;
+        ts.tv_nsec = (timeout % 1000l) * 1000000l;
+        tp = &ts;
+    }
+    syscall(SYS_futex, (volatile int *)word, FUTEX_WAIT, value, tp, NULL, 0);
+}
+
+static void wake_all(Atomic::counter *word)
+{
+    syscall(SYS_futex, (volatile int *)word, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
+
+#else
+
+static void sleep_on(Atomic::counter *word, atomic_t value, timeout_t timeout)
+{
+    if(word->get() == value)
+        Thread::sleep(timeout < RING_POLL ? timeout : RING_POLL);
+}
+
+static void wake_all(Atomic::counter *word)
+{
+    __UNUSED(word);
+}
+
+#endif
+
+MappedRing::MappedRing(const char *name, size_t osize, unsigned count, bool multiple) :
+MappedMemory()
+{
+    assert(name != NULL && *name != 0);
+    assert(osize > 0 && count > 0);
+
+    unsigned limit = 1;
+
+    while(limit < count)
+        limit <<= 1;
+
+    ring = NULL;
+    slots = NULL;
+    objsize = osize;
+    stride = record(osize);
+    erase = true;
+    String::set(idname, sizeof(idname), name);
+    create(name, sizeof(control) + limit * stride);
+    if(!size)
+        return;
+
+    // each slot starts with the position it will next be filled at, which
+    // is bumped once filled, and again by the ring size once emptied...
+    ring = new(addr()) control(osize, limit, multiple);
+    slots = addr() + sizeof(control);
+    for(unsigned pos = 0; pos < limit; ++pos)
+        new(slots + pos * stride) Atomic::counter((atomic_t)pos);
+
+    Atomic::fence();
+    ring->magic = RING_MAGIC;
+}
+
+MappedRing::MappedRing(const char *name, size_t osize) :
+MappedMemory()
+{
+    assert(name != NULL && *name != 0);
+    assert(osize > 0);
+
+    control *cb;
+
+    ring = NULL;
+    slots = NULL;
+    objsize = osize;
+    stride = record(osize);
+    attach(name);
+    if(size < sizeof(control)) {
+        release();
+        return;
+    }
+
+    cb = (control *)addr();
+    if(cb->magic != RING_MAGIC || cb->objsize != osize || size < sizeof(control) + cb->count * stride) {
+        release();
+        return;
+    }
+
+    Atomic::fence();
+    ring = cb;
+    slots = addr() + sizeof(control);
+}
+
+bool MappedRing::push(const void *data)
+{
+    unsigned mask = ring->count - 1;
+    atomic_t pos = ring->head.get();
+    Atomic::counter *seq;
+
+    for(;;) {
+        seq = (Atomic::counter *)(slots + ((unsigned)pos & mask) * stride);
+        atomic_t diff = (atomic_t)((unsigned)seq->get() - (unsigned)pos);
+
+        // a slot not yet emptied since the last time around means full...
+        if(diff < 0)
+            return false;
+
+        if(!diff) {
+            if(!ring->multiple) {
+                ring->head.fetch_add(1);
+                break;
+            }
+            if(ring->head.compare_exchange(pos, (atomic_t)((unsigned)pos + 1)))
+                break;
+        }
+        pos = ring->head.get();
+    }
+
+    memcpy((caddr_t)seq + RECORD_HEADER, data, objsize);
+    seq->fetch_add(1);
+    return true;
+}
+
+bool MappedRing::pull(void *data)
+{
+    atomic_t pos = ring->tail.get();
+    Atomic::counter *seq = (Atomic::counter *)(slots + ((unsigned)pos & (ring->count - 1)) * stride);
+
+    if(seq->get() != (atomic_t)((unsigned)pos + 1))
+        return false;
+
+    memcpy(data, (caddr_t)seq + RECORD_HEADER, objsize);
+    seq->fetch_add((atomic_t)(ring->count - 1));
+    ring->tail.fetch_add(1);
+    return true;
+}
+
+bool MappedRing::put(const void *data, timeout_t timeout)
+{
+    Timer expires;
+    timeout_t remains = Timer::inf;
+    atomic_t seen;
+
+    if(!ring)
+        return false;
+
+    if(timeout && timeout != Timer::inf)
+        expires.set(timeout);
+
+    while(!push(data)) {
+        if(!timeout)
+            return false;
+
+        if(timeout != Timer::inf) {
+            remains = expires.get();
+            if(!remains)
+                return false;
+        }
+
+        // the consumer checks for waiting producers after emptying a slot,
+        // so either it sees us or we see the slot it emptied...
+        seen = ring->writable.get();
+        ring->writers.fetch_add(1);
+        Atomic::fence();
+        if(push(data)) {
+            ring->writers.fetch_sub(1);
+            break;
+        }
+        sleep_on(&ring->writable, seen, remains);
+        ring->writers.fetch_sub(1);
+    }
+
+    Atomic::fence();
+    if(ring->readers.get()) {
+        ring->readable.fetch_add(1);
+        wake_all(&ring->readable);
+    }
+    return true;
+}
+
+bool MappedRing::get(void *data, timeout_t timeout)
+{
+    Timer expires;
+    timeout_t remains = Timer::inf;
+    atomic_t seen;
+
+    if(!ring)
+        return false;
+
+    if(timeout && timeout != Timer::inf)
+        expires.set(timeout);
+
+    while(!pull(data)) {
+        if(!timeout)
+            return false;
+
+        if(timeout != Timer::inf) {
+            remains = expires.get();
+            if(!remains)
+                return false;
+        }
+
+        seen = ring->readable.get();
+        ring->readers.fetch_add(1);
+        Atomic::fence();
+        if(pull(data)) {
+            ring->readers.fetch_sub(1);
+            break;
+        }
+        sleep_on(&ring->readable, seen, remains);
+        ring->readers.fetch_sub(1);
+    }
+
+    Atomic::fence();
+    if(ring->writers.get()) {
+        ring->writable.fetch_add(1);
+        wake_all(&ring->writable);
+    }
+    return true;
+}
+
+unsigned MappedRing::pending(void) const
+{
+    if(!ring)
+        return 0;
+
+    return (unsigned)ring->head.get() - (unsigned)ring->tail.get();
+}
+
+unsigned MappedRing::max(void) const
+{
+    if(!ring)
+        return 0;
+
+    return ring->count;
+}
+
 } // namespace ucommon
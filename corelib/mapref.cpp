@@ -23,37 +23,109 @@
 #include <ucommon/linked.h>
 #include <ucommon/mapref.h>
 #include <cstdlib>
+#include <cstring>
 
 namespace ucommon {
 
+// prior index lists migrated for each change while a map grows
+#define MAP_MIGRATE 2
+
 MapRef::Index::Index() :
 LinkedObject()
 {
     key = value = NULL;
+    path = 0;
 }
 
 MapRef::Index::Index(LinkedObject **origin) :
 LinkedObject(origin)
 {
     key = value = NULL;
+    path = 0;
 }
 
-MapRef::Map::Map(void *addr, size_t indexes, size_t paging) :
+MapRef::Map::Map(void *addr, size_t indexes, size_t paging, hash_t mode) :
 Counted(addr, indexes), pool(paging)
 {
     size_t index = 0;
     LinkedObject **list = get();
     free = last = NULL;
     count = alloc = 0;
+    table = list;
+    prior = NULL;
+    buckets = indexes;
+    previous = migrate = 0;
+    hashing = mode;
 
     while(index < indexes) {
         list[index++] = NULL;
     }
 }
 
+LinkedObject *MapRef::Map::first(size_t path)
+{
+    if(path < previous)
+        return prior[path];
+
+    path -= previous;
+    if(path < buckets)
+        return table[path];
+
+    return NULL;
+}
+
+LinkedObject **MapRef::Map::root(size_t path)
+{
+    if(prior && (path % previous) >= migrate)
+        return &prior[path % previous];
+
+    return &table[path % buckets];
+}
+
+void MapRef::Map::rehash(void)
+{
+    LinkedObject *node, *next;
+    unsigned moved = 0;
+
+    if(!prior) {
+        // grow when the load factor exceeds one key per index...
+        if(count <= buckets)
+            return;
+
+        size_t resize = buckets * 2 + 1;
+        LinkedObject **list = (LinkedObject **)::malloc(resize * sizeof(LinkedObject *));
+        if(!list)
+            return;
+
+        memset(list, 0, resize * sizeof(LinkedObject *));
+        prior = table;
+        previous = buckets;
+        migrate = 0;
+        table = list;
+        buckets = resize;
+    }
+
+    while(migrate < previous && moved++ < MAP_MIGRATE) {
+        node = prior[migrate];
+        prior[migrate++] = NULL;
+        while(node) {
+            next = node->getNext();
+            node->enlist(&table[(static_cast<Index *>(node))->path % buckets]);
+            node = next;
+        }
+    }
+
+    if(migrate < previous)
+        return;
+
+    if(prior != get())
+        ::free(prior);
+    prior = NULL;
+    previous = migrate = 0;
+}
+
 MapRef::Index *MapRef::Map::create(size_t key)
 {
-    LinkedObject **list = get();
     caddr_t p = (caddr_t)(free);
     if(free)
         free = free->getNext();
@@ -62,12 +134,14 @@ MapRef::Index *MapRef::Map::create(size_t key)
         p = (caddr_t)pool.alloc(sizeof(Index));
     }
     ++count;
-    return new(p) Index(&list[key % size]);
+    rehash();
+    Index *ind = new(p) Index(root(key));
+    ind->path = key;
+    return ind;
 }
 
 MapRef::Index *MapRef::Map::append()
 {
-    LinkedObject **list = get();
     caddr_t p = (caddr_t)(free);
     if(free)
         free = free->getNext();
@@ -82,7 +156,7 @@ MapRef::Index *MapRef::Map::append()
         lp->Next = ip;
     }
     else
-        list[0] = ip;
+        table[0] = ip;
     last = ip;
     ip->Next = NULL;
     return ip;
@@ -99,12 +173,11 @@ void MapRef::Map::remove(Index *index, size_t path)
     if(index->value)
         index->value->release();
 
-    LinkedObject **root = get();
-    root = &root[path % size];
+    LinkedObject **list = root(path);
 
     --count;
     if(last && index == last) {
-        last = *(root);
+        last = *(list);
         if(last == index)
             last = NULL;
         else {
@@ -113,33 +186,34 @@ void MapRef::Map::remove(Index *index, size_t path)
             }
         }
     }
-    index->delist(root);
+    index->delist(list);
     index->enlist(&free);
+    if(prior)
+        rehash();
 }
 
 LinkedObject *MapRef::Map::access(size_t key)
 {
     lock.access();
-	return (get())[key % size];
+	return *(root(key));
 }
 
 LinkedObject *MapRef::Map::modify(size_t key)
 {
     lock.modify();
-    return (get())[key % size];
+    return *(root(key));
 }
 
 void MapRef::Map::dealloc()
 {
     size_t index = 0;
-    LinkedObject **list = get();
     linked_pointer<Index> ip;
 
     if(!size)
         return;
 
-    while(index < size) {
-		ip = list[index];
+    while(index < paths()) {
+		ip = first(index);
 		while(ip) {
 			if(ip->key)
 				ip->key->release();
@@ -149,6 +223,13 @@ void MapRef::Map::dealloc()
 		}
 		++index;
 	}
+    if(prior && prior != get())
+        ::free(prior);
+    if(table != get())
+        ::free(table);
+    table = get();
+    prior = NULL;
+    buckets = previous = migrate = 0;
     size = 0;
 	free = last = NULL;
 	pool.purge();
@@ -244,7 +325,7 @@ void MapRef::Instance::rewind()
         return;
 
     path = 0;
-    index = (map->get())[0];
+    index = map->first(0);
     if(!index)
         next();
 }
@@ -257,7 +338,7 @@ bool MapRef::Instance::top()
     if(path > 0)
         return false;
 
-    if(index != (map->get())[0])
+    if(index != map->first(0))
         return false;
 
     return true;
@@ -284,7 +365,7 @@ bool MapRef::Instance::eol()
     if(!map)
         return false;
 
-    if(path < map->size)
+    if(path < map->paths())
         return false;
 
     return true;
@@ -301,8 +382,8 @@ bool MapRef::Instance::next()
     if(index)
         return true;
 
-    while(++path < map->size) {
-        index = (map->get())[path];
+    while(++path < map->paths()) {
+        index = map->first(path);
         if(index)
             return true;
     }
@@ -319,9 +400,18 @@ TypeRef(copy)
 {
 }
 
-MapRef::MapRef(size_t indexes, size_t paging) :
-TypeRef(create(indexes, paging))
+MapRef::MapRef(size_t indexes, size_t paging, hash_t mode) :
+TypeRef(create(indexes, paging, mode))
+{
+}
+
+MapRef::hash_t MapRef::hashing(void)
 {
+    Map *m = polydynamic_cast<Map *>(ref);
+    if(!m)
+        return MIX;
+
+    return m->hashing;
 }
 
 size_t MapRef::used()
@@ -351,14 +441,14 @@ void MapRef::remove(Index *ind, size_t path)
     m->remove(ind, path);
 }
 
-MapRef::Map *MapRef::create(size_t indexes, size_t paging)
+MapRef::Map *MapRef::create(size_t indexes, size_t paging, hash_t mode)
 {
     if(!indexes)
         return NULL;
 
     size_t s = sizeof(Map) + (indexes * sizeof(Index *));
     caddr_t p = auto_release.allocate(s);
-    return new(mem(p)) Map(p, indexes, paging);
+    return new(mem(p)) Map(p, indexes, paging, mode);
 }
 
 void MapRef::update(Index *ind, TypeRef& value)
@@ -463,4 +553,56 @@ size_t MapRef::index(size_t& key, const uint8_t *addr, size_t len)
 	return key;
 }
 
+size_t MapRef::index(size_t& key, const uint8_t *addr, size_t len, hash_t mode)
+{
+    if(mode == SHIFT)
+        return index(key, addr, len);
+
+    if(addr)
+        key = hash(addr, len, key);
+    return key;
+}
+
+static inline uint64_t rotate(uint64_t value, unsigned bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+size_t MapRef::hash(const uint8_t *addr, size_t len, size_t seed)
+{
+    const uint64_t m1 = 0x87c37b91114253d5ULL;
+    const uint64_t m2 = 0x4cf5ad432745937fULL;
+    uint64_t h = (uint64_t)seed ^ ((uint64_t)len * 0x9e3779b97f4a7c15ULL);
+    uint64_t word;
+
+    while(len >= 8) {
+        memcpy(&word, addr, 8);
+        word *= m1;
+        word = rotate(word, 31);
+        word *= m2;
+        h ^= word;
+        h = rotate(h, 27) * 5 + 0x52dce729;
+        addr += 8;
+        len -= 8;
+    }
+
+    if(len) {
+        word = 0;
+        while(len--)
+            word = (word << 8) | addr[len];
+        word *= m1;
+        word = rotate(word, 31);
+        word *= m2;
+        h ^= word;
+    }
+
+    // final avalanche so every input bit affects the low index bits...
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return (size_t)h;
+}
+
 } // namespace
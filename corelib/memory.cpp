@@ -38,6 +38,14 @@
 #define aligned_alloc(a, s) _aligned_malloc(s, a)
 #endif
 
+// size class of a slab object, with the thread cache it came from above
+#define SLAB_CLASS(id)  ((id) & 0xffff)
+#define SLAB_ORIGIN(id) ((id) >> 16)
+#define SLAB_CLASSES    0xffff
+
+#define PAGER_CACHES    32
+#define PAGER_CHUNK     256
+
 namespace ucommon {
 
 extern "C" {
@@ -52,6 +60,188 @@ extern "C" {
     }
 }
 
+// each thread is given a serial number the first time it uses a cache
+class cache_thread : public Thread::Local
+{
+private:
+    Atomic::counter serial;
+
+    virtual void release(void *instance) __FINAL {
+        __UNUSED(instance);
+    }
+
+    virtual void *allocate() __FINAL {
+        return (void *)(uintptr_t)(++serial);
+    }
+
+public:
+    inline cache_thread() : serial(0) {}
+};
+
+// made on first use, since pagers may be static objects of other modules...
+static cache_thread& cache_local(void)
+{
+    static cache_thread local;
+    return local;
+}
+
+/**
+ * Per-thread caches of free objects.  Threads are mapped to cache slots
+ * by serial number, so each thread has a slot of it's own until there are
+ * more threads than slots.  Each slot is protected by a spinlock that is
+ * normally only used by the owning thread.  Free memory is linked through
+ * it's first word while it is held in a cache, so pools of objects keep a
+ * link word in front of each object.
+ */
+class PagerCache
+{
+private:
+    __DELETE_COPY(PagerCache);
+
+public:
+    typedef struct {
+        void *list;
+        unsigned count;
+    } list_t;
+
+    typedef struct {
+        Atomic::spinlock lock;
+        list_t *lists;
+        pagerstats_t stats;
+        char pad[64];
+    } slot_t;
+
+    unsigned classes, batch;
+    slot_t slots[PAGER_CACHES];
+
+    PagerCache(unsigned count, unsigned size);
+    ~PagerCache();
+
+    inline unsigned origin(void) {
+        return (unsigned)((uintptr_t)(*cache_local()) % PAGER_CACHES) + 1;
+    }
+
+    inline slot_t *slot(void) {
+        return &slots[origin() - 1];
+    }
+
+    void *get(unsigned id);
+    void fill(unsigned id, void *chain);
+    void *put(unsigned id, void *mem, unsigned from);
+    void clear(void);
+    pagerstats_t stats(void);
+};
+
+PagerCache::PagerCache(unsigned count, unsigned size)
+{
+    classes = count;
+    batch = size;
+    for(unsigned pos = 0; pos < PAGER_CACHES; ++pos) {
+        slots[pos].lists = new list_t[classes];
+        memset(slots[pos].lists, 0, sizeof(list_t) * classes);
+        memset(&slots[pos].stats, 0, sizeof(pagerstats_t));
+    }
+}
+
+PagerCache::~PagerCache()
+{
+    for(unsigned pos = 0; pos < PAGER_CACHES; ++pos)
+        delete[] slots[pos].lists;
+}
+
+void *PagerCache::get(unsigned id)
+{
+    slot_t *sp = slot();
+    list_t *lp = &sp->lists[id];
+    void *mem;
+
+    sp->lock.wait();
+    mem = lp->list;
+    if(mem) {
+        lp->list = *((void **)mem);
+        --lp->count;
+        ++sp->stats.hits;
+    }
+    else
+        ++sp->stats.misses;
+    sp->lock.release();
+    return mem;
+}
+
+void PagerCache::fill(unsigned id, void *chain)
+{
+    if(!chain)
+        return;
+
+    slot_t *sp = slot();
+    list_t *lp = &sp->lists[id];
+    void *next;
+
+    sp->lock.wait();
+    while(chain) {
+        next = *((void **)chain);
+        *((void **)chain) = lp->list;
+        lp->list = chain;
+        ++lp->count;
+        chain = next;
+    }
+    ++sp->stats.refills;
+    sp->lock.release();
+}
+
+void *PagerCache::put(unsigned id, void *mem, unsigned from)
+{
+    unsigned current = origin();
+    slot_t *sp = &slots[current - 1];
+    list_t *lp = &sp->lists[id];
+    void *chain = NULL, *tail;
+
+    sp->lock.wait();
+    if(from && from != current)
+        ++sp->stats.remote;
+    *((void **)mem) = lp->list;
+    lp->list = mem;
+
+    // an overfull cache returns a batch to the shared pool...
+    if(++lp->count > batch * 2) {
+        chain = tail = lp->list;
+        for(unsigned pos = 1; pos < batch; ++pos)
+            tail = *((void **)tail);
+        lp->list = *((void **)tail);
+        *((void **)tail) = NULL;
+        lp->count -= batch;
+        ++sp->stats.returns;
+    }
+    sp->lock.release();
+    return chain;
+}
+
+void PagerCache::clear(void)
+{
+    for(unsigned pos = 0; pos < PAGER_CACHES; ++pos) {
+        slots[pos].lock.wait();
+        memset(slots[pos].lists, 0, sizeof(list_t) * classes);
+        slots[pos].lock.release();
+    }
+}
+
+pagerstats_t PagerCache::stats(void)
+{
+    pagerstats_t total;
+
+    memset(&total, 0, sizeof(total));
+    for(unsigned pos = 0; pos < PAGER_CACHES; ++pos) {
+        slots[pos].lock.wait();
+        total.hits += slots[pos].stats.hits;
+        total.misses += slots[pos].stats.misses;
+        total.refills += slots[pos].stats.refills;
+        total.returns += slots[pos].stats.returns;
+        total.remote += slots[pos].stats.remote;
+        slots[pos].lock.release();
+    }
+    return total;
+}
+
 void memalloc::assign(memalloc& source)
 {
     memalloc::purge();
@@ -60,11 +250,28 @@ void memalloc::assign(memalloc& source)
     count = source.count;
     page = source.page;
     limit = source.limit;
+    if(classes != source.classes) {
+        if(slabs)
+            ::free(slabs);
+        slabs = NULL;
+        classes = source.classes;
+        if(classes) {
+            slabs = (slab_t **)malloc(sizeof(slab_t *) * classes);
+            if(!slabs) {
+                classes = 0;
+                __THROW_ALLOC();
+            }
+        }
+    }
+    if(slabs)
+        memcpy(slabs, source.slabs, sizeof(slab_t *) * classes);
+    if(source.slabs)
+        memset(source.slabs, 0, sizeof(slab_t *) * source.classes);
     source.count = 0;
     source.page = NULL;
 }
 
-memalloc::memalloc(size_t ps)
+memalloc::memalloc(size_t ps, size_t slab)
 {
 #ifdef  HAVE_SYSCONF
     size_t paging = sysconf(_SC_PAGESIZE);
@@ -101,6 +308,16 @@ memalloc::memalloc(size_t ps)
     count = 0;
     limit = 0;
     page = NULL;
+    slabs = NULL;
+    classes = (unsigned)((slab + sizeof(void *) - 1) / sizeof(void *));
+    if(classes > SLAB_CLASSES)
+        classes = SLAB_CLASSES;
+    if(classes) {
+        slabs = (slab_t **)malloc(sizeof(slab_t *) * classes);
+        if(!slabs)
+            __THROW_ALLOC();
+        memset(slabs, 0, sizeof(slab_t *) * classes);
+    }
 }
 
 memalloc::memalloc(const memalloc& copy)
@@ -110,11 +327,21 @@ memalloc::memalloc(const memalloc& copy)
     page = NULL;
     pagesize = copy.pagesize;
     align = copy.align;
+    slabs = NULL;
+    classes = copy.classes;
+    if(classes) {
+        slabs = (slab_t **)malloc(sizeof(slab_t *) * classes);
+        if(!slabs)
+            __THROW_ALLOC();
+        memset(slabs, 0, sizeof(slab_t *) * classes);
+    }
 }
 
 memalloc::~memalloc()
 {
     memalloc::purge();
+    if(slabs)
+        ::free(slabs);
 }
 
 unsigned memalloc::utilization(void) const
@@ -152,6 +379,8 @@ void memalloc::purge(void)
         page = next;
     }
     count = 0;
+    if(slabs)
+        memset(slabs, 0, sizeof(slab_t *) * classes);
 }
 
 memalloc::page_t *memalloc::pager(void)
@@ -195,6 +424,61 @@ memalloc::page_t *memalloc::pager(void)
     return npage;
 }
 
+void *memalloc::_slab(size_t size)
+{
+    size_t id = (size + sizeof(void *) - 1) / sizeof(void *);
+    slab_t *node;
+    page_t *p = page;
+
+    if(!id) {
+        __THROW_SIZE("Empty object");
+        return NULL;
+    }
+
+    // a recycled object of the same size class is always used first...
+    if(id <= classes && slabs[id - 1]) {
+        node = slabs[id - 1];
+        slabs[id - 1] = node->next;
+        node->id = id;
+        return node + 1;
+    }
+
+    size = sizeof(slab_t) + id * sizeof(void *);
+    if(size > (pagesize - sizeof(page_t))) {
+        __THROW_SIZE("Larger than pagesize");
+        return NULL;
+    }
+
+    // objects are only cut from the current page, so no page walk...
+    if(!p || size > pagesize - p->used)
+        p = pager();
+
+    node = (slab_t *)(((caddr_t)(p)) + p->used);
+    p->used += (unsigned)size;
+
+    // larger objects are marked so they are never recycled...
+    if(id > classes)
+        node->id = 0;
+    else
+        node->id = id;
+    return node + 1;
+}
+
+void memalloc::dealloc(void *mem)
+{
+    if(!mem || !slabs)
+        return;
+
+    slab_t *node = ((slab_t *)mem) - 1;
+    size_t id = SLAB_CLASS(node->id);
+
+    if(!id || id > classes)
+        return;
+
+    node->next = slabs[id - 1];
+    slabs[id - 1] = node;
+}
+
 void *memalloc::_alloc(size_t size)
 {
     assert(size > 0);
@@ -202,6 +486,9 @@ void *memalloc::_alloc(size_t size)
     caddr_t mem;
     page_t *p = page;
 
+    if(slabs)
+        return _slab(size);
+
     if(size > (pagesize - sizeof(page_t))) {
         __THROW_SIZE("Larger than pagesize");
         return NULL;
@@ -223,22 +510,30 @@ void *memalloc::_alloc(size_t size)
     return mem;
 }
 
-mempager::mempager(size_t ps) :
-memalloc(ps)
+mempager::mempager(size_t ps, size_t slab, unsigned cache) :
+memalloc(ps, slab)
 {
     pthread_mutex_init(&mutex, NULL);
+    caches = NULL;
+    if(cache && classes)
+        caches = new PagerCache(classes, cache);
 }
 
 mempager::mempager(const mempager& copy) :
 memalloc(copy)
 {
     pthread_mutex_init(&mutex, NULL);
+    caches = NULL;
+    if(copy.caches)
+        caches = new PagerCache(classes, copy.caches->batch);
 }
 
 mempager::~mempager()
 {
     memalloc::purge();
     pthread_mutex_destroy(&mutex);
+    if(caches)
+        delete caches;
 }
 
 void mempager::_lock(void)
@@ -264,19 +559,78 @@ unsigned mempager::utilization(void)
 void mempager::purge(void)
 {
     pthread_mutex_lock(&mutex);
+    if(caches)
+        caches->clear();
     memalloc::purge();
     pthread_mutex_unlock(&mutex);
 }
 
 void mempager::dealloc(void *mem)
 {
+    if(!mem || !slabs)
+        return;
+
+    slab_t *node = ((slab_t *)mem) - 1;
+    unsigned id = (unsigned)SLAB_CLASS(node->id);
+    void *chain, *next;
+
+    if(caches && id && id <= caches->classes) {
+        chain = caches->put(id - 1, mem, (unsigned)SLAB_ORIGIN(node->id));
+        if(!chain)
+            return;
+
+        pthread_mutex_lock(&mutex);
+        while(chain) {
+            next = *((void **)chain);
+            memalloc::dealloc(chain);
+            chain = next;
+        }
+        pthread_mutex_unlock(&mutex);
+        return;
+    }
+
+    pthread_mutex_lock(&mutex);
+    memalloc::dealloc(mem);
+    pthread_mutex_unlock(&mutex);
+}
+
+pagerstats_t mempager::stats(void) const
+{
+    pagerstats_t result;
+
+    if(caches)
+        return caches->stats();
+
+    memset(&result, 0, sizeof(result));
+    return result;
 }
 
 void *mempager::_alloc(size_t size)
 {
     assert(size > 0);
 
-    void *mem;
+    void *mem, *next, *chain = NULL;
+    unsigned id = (unsigned)((size + sizeof(void *) - 1) / sizeof(void *));
+
+    if(caches && id <= caches->classes) {
+        mem = caches->get(id - 1);
+
+        // refill thread cache from the pager in one locked batch...
+        if(!mem) {
+            pthread_mutex_lock(&mutex);
+            mem = memalloc::_slab(size);
+            for(unsigned pos = 1; pos < caches->batch; ++pos) {
+                next = memalloc::_slab(size);
+                *((void **)next) = chain;
+                chain = next;
+            }
+            pthread_mutex_unlock(&mutex);
+            caches->fill(id - 1, chain);
+        }
+        (((slab_t *)mem) - 1)->id = id | (caches->origin() << 16);
+        return mem;
+    }
+
     pthread_mutex_lock(&mutex);
     mem = memalloc::_alloc(size);
     pthread_mutex_unlock(&mutex);
@@ -287,12 +641,192 @@ void mempager::assign(mempager& source)
 {
     pthread_mutex_lock(&source.mutex);
     pthread_mutex_lock(&mutex);
+    if(caches)
+        caches->clear();
+    if(source.caches)
+        source.caches->clear();
     memalloc::assign(source);
     pthread_mutex_unlock(&mutex);
     pthread_mutex_unlock(&source.mutex);
 }
 
 
+/*
+ * Chunked index of the members of an object or string pager list, so
+ * members may be found by position without walking the list.  Members
+ * are held in fixed blocks of pointers, with an offset to the first so
+ * members may be pushed and pulled from the front as well as added and
+ * popped from the back.  Blocks emptied from the front are rotated to
+ * the back for reuse.  Gathered lists are kept until the pager is
+ * cleared, since callers may still hold older ones.
+ */
+class PagerIndex
+{
+private:
+    __DELETE_COPY(PagerIndex);
+
+    LinkedObject ***blocks;
+    unsigned size, first, used;
+    void **flat, **lists;
+    unsigned limit;
+
+    void grow(void);
+    void rotate(bool front);
+
+public:
+    PagerIndex();
+    ~PagerIndex();
+
+    inline LinkedObject *get(unsigned ind) const {
+        ind += first;
+        return blocks[ind / PAGER_CHUNK][ind % PAGER_CHUNK];
+    }
+
+    inline void set(unsigned ind, LinkedObject *node) {
+        ind += first;
+        blocks[ind / PAGER_CHUNK][ind % PAGER_CHUNK] = node;
+    }
+
+    void **table(unsigned count);
+    void **gather(unsigned count);
+    void add(LinkedObject *node);
+    void push(LinkedObject *node);
+    void pull(void);
+    void pop(void);
+    void clear(void);
+};
+
+PagerIndex::PagerIndex()
+{
+    blocks = NULL;
+    size = first = used = 0;
+    flat = lists = NULL;
+    limit = 0;
+}
+
+PagerIndex::~PagerIndex()
+{
+    clear();
+    while(size)
+        ::free(blocks[--size]);
+    if(blocks)
+        ::free(blocks);
+    if(flat)
+        ::free(flat);
+}
+
+void PagerIndex::clear(void)
+{
+    void **next;
+
+    first = used = 0;
+    while(lists) {
+        next = (void **)lists[0];
+        ::free(lists);
+        lists = next;
+    }
+}
+
+// a scratch table reused for sorting members, never handed to callers
+void **PagerIndex::table(unsigned count)
+{
+    if(count + 1 > limit) {
+        void **list = (void **)::realloc(flat, (count + 1) * sizeof(void *));
+        if(!list)
+            __THROW_ALLOC();
+        flat = list;
+        limit = count + 1;
+    }
+    return flat;
+}
+
+// a list table for callers, linked to older ones through a leading word
+void **PagerIndex::gather(unsigned count)
+{
+    void **list = (void **)::malloc((count + 2) * sizeof(void *));
+    if(!list)
+        __THROW_ALLOC();
+
+    list[0] = lists;
+    lists = list;
+    return list + 1;
+}
+
+void PagerIndex::grow(void)
+{
+    unsigned resize = size ? size * 2 : 4;
+    LinkedObject ***list = (LinkedObject ***)::realloc(blocks, resize * sizeof(LinkedObject **));
+    if(!list)
+        __THROW_ALLOC();
+
+    blocks = list;
+    while(size < resize) {
+        blocks[size] = (LinkedObject **)::malloc(PAGER_CHUNK * sizeof(LinkedObject *));
+        if(!blocks[size])
+            __THROW_ALLOC();
+        ++size;
+    }
+}
+
+void PagerIndex::rotate(bool front)
+{
+    LinkedObject **block;
+
+    if(front) {
+        block = blocks[size - 1];
+        memmove(&blocks[1], &blocks[0], (size - 1) * sizeof(LinkedObject **));
+        blocks[0] = block;
+        first += PAGER_CHUNK;
+    }
+    else {
+        block = blocks[0];
+        memmove(&blocks[0], &blocks[1], (size - 1) * sizeof(LinkedObject **));
+        blocks[size - 1] = block;
+        first -= PAGER_CHUNK;
+    }
+}
+
+void PagerIndex::add(LinkedObject *node)
+{
+    if(first + used >= size * PAGER_CHUNK)
+        grow();
+    set(used++, node);
+}
+
+void PagerIndex::push(LinkedObject *node)
+{
+    if(!first) {
+        // need a free block at the back to move to the front...
+        if(used + PAGER_CHUNK > size * PAGER_CHUNK)
+            grow();
+        rotate(true);
+    }
+    --first;
+    ++used;
+    set(0, node);
+}
+
+void PagerIndex::pull(void)
+{
+    if(!used)
+        return;
+
+    ++first;
+    if(!--used)
+        first = 0;
+    else if(first >= PAGER_CHUNK)
+        rotate(false);
+}
+
+void PagerIndex::pop(void)
+{
+    if(!used)
+        return;
+
+    if(!--used)
+        first = 0;
+}
+
 ObjectPager::member::member(LinkedObject **root) :
 LinkedObject(root)
 {
@@ -313,35 +847,41 @@ memalloc(size)
     last = NULL;
     index = NULL;
     typesize = objsize;
+    chunks = new PagerIndex();
+}
+
+ObjectPager::~ObjectPager()
+{
+    delete chunks;
 }
 
 void ObjectPager::assign(ObjectPager& source)
 {
+    PagerIndex *swap = chunks;
+
     members = source.members;
     root = source.root;
     last = source.last;
     index = source.index;
     typesize = source.typesize;
+    chunks = source.chunks;
 
     memalloc::assign(source);
 
+    swap->clear();
     source.members = 0;
     source.root = NULL;
     source.last = NULL;
     source.index = NULL;
+    source.chunks = swap;
 }
 
 void *ObjectPager::get(unsigned ind) const
 {
-    linked_pointer<member> list = root;
-
     if(ind >= members)
         return invalid();
 
-    while(ind--)
-        list.next();
-
-    return list->mem;
+    return (static_cast<member *>(chunks->get(ind)))->mem;
 }
 
 void ObjectPager::clear(void)
@@ -351,6 +891,7 @@ void ObjectPager::clear(void)
     root = NULL;
     last = NULL;
     index = NULL;
+    chunks->clear();
 }
 
 void *ObjectPager::pull(void)
@@ -368,6 +909,7 @@ void *ObjectPager::pull(void)
     else
         root = mem->Next;
     index = NULL;
+    chunks->pull();
     return result;
 }
 
@@ -385,6 +927,7 @@ void *ObjectPager::push(void)
     ++members;
     node->mem = memalloc::_alloc(typesize);
     index = NULL;
+    chunks->push(node);
     return node->mem;
 }
 
@@ -396,25 +939,17 @@ void *ObjectPager::pop(void)
         return invalid();
 
     index = NULL;
+    out = last->mem;
+    chunks->pop();
 
     if(root == last) {
-        out = last->mem;
         root = last = NULL;
         members = 0;
         return out;
     }
 
-    linked_pointer<member> np = root;
-    while(is(np)) {
-        if(np->Next == last) {
-            out = last->mem;
-            last = *np;
-            np->Next = NULL;
-            --members;
-            break;
-        }
-        np.next();
-    }
+    last = static_cast<member *>(chunks->get(--members - 1));
+    last->Next = NULL;
     return out;
 }
 
@@ -436,6 +971,7 @@ void *ObjectPager::add(void)
     else
         node = new(mem) member(&root);
     last = node;
+    chunks->add(node);
     node->mem = memalloc::_alloc(typesize);
     return node->mem;
 }
@@ -447,11 +983,10 @@ void **ObjectPager::list(void)
         return dp;
 
     unsigned pos = 0;
-    index = (void **)memalloc::_alloc(sizeof(void *) * (members + 1));
-    linked_pointer<member> mp = root;
-    while(is(mp)) {
-        index[pos++] = mp->mem;
-        mp.next();
+    index = chunks->gather(members);
+    while(pos < members) {
+        index[pos] = (static_cast<member *>(chunks->get(pos)))->mem;
+        ++pos;
     }
     index[pos] = NULL;
     return index;
@@ -476,21 +1011,32 @@ memalloc(size)
     root = NULL;
     last = NULL;
     index = NULL;
+    chunks = new PagerIndex();
+}
+
+StringPager::~StringPager()
+{
+    delete chunks;
 }
 
 void StringPager::assign(StringPager& source)
 {
+    PagerIndex *swap = chunks;
+
     members = source.members;
     root = source.root;
     last = source.last;
     index = source.index;
+    chunks = source.chunks;
 
     memalloc::assign(source);
 
+    swap->clear();
     source.members = 0;
     source.root = NULL;
     source.last = NULL;
     source.index = NULL;
+    source.chunks = swap;
 }
 
 StringPager::StringPager(char **list, size_t size) :
@@ -499,6 +1045,8 @@ memalloc(size)
     members = 0;
     root = NULL;
     last = NULL;
+    index = NULL;
+    chunks = new PagerIndex();
     add(list);
 }
 
@@ -553,24 +1101,19 @@ unsigned StringPager::split(const char *text, const char *string, unsigned flags
     strdup_t tmp = String::dup(string);
     char *match = tmp;
     char *prior = tmp;
+    char *end;
     size_t tcl = strlen(text);
     unsigned count = 0;
     bool found = false;
 
+    if(!tcl || !prior)
+        return 0;
+
+    end = prior + strlen(prior);
+
     // until end of string or end of matches...
     while(prior && *prior && match) {
-#if defined(_MSWINDOWS_)
-        if((flags & 0x01) == String::INSENSITIVE)
-            match = strstr(prior, text);
-#elif  defined(HAVE_STRICMP)
-        if((flags & 0x01) == String::INSENSITIVE)
-            match = stristr(prior, text);
-#else
-        if((flags & 0x01) == String::INSENSITIVE)
-            match = strcasestr(prior, text);
-#endif
-        else
-            match = strstr(prior, text);
+        match = (char *)String::search(prior, (size_t)(end - prior), text, tcl, flags);
 
         if(match)
             found = true;
@@ -596,13 +1139,12 @@ unsigned StringPager::split(const char *text, const char *string, unsigned flags
 
 void StringPager::set(unsigned ind, const char *text)
 {
-    linked_pointer<member> list = root;
-
-    if(ind >= members)
-
-    while(ind--)
-        list.next();
+    if(ind >= members) {
+        __THROW_RANGE("stringpager outside range");
+        return;
+    }
 
+    member *node = static_cast<member *>(chunks->get(ind));
     size_t size = strlen(text) + 1;
     char *str = (char *)memalloc::_alloc(size);
 #ifdef  HAVE_STRLCPY
@@ -610,22 +1152,18 @@ void StringPager::set(unsigned ind, const char *text)
 #else
     strcpy(str, text);
 #endif
-    list->text = str;
+    node->text = str;
+    index = NULL;
 }
 
 const char *StringPager::get(unsigned ind) const
 {
-    linked_pointer<member> list = root;
-
     if(ind >= members) {
         __THROW_RANGE("stringpager outside range");
         return NULL;
     }
 
-    while(ind--)
-        list.next();
-
-    return list->get();
+    return (static_cast<member *>(chunks->get(ind)))->get();
 }
 
 void StringPager::clear(void)
@@ -635,6 +1173,7 @@ void StringPager::clear(void)
     root = NULL;
     last = NULL;
     index = NULL;
+    chunks->clear();
 }
 
 const char *StringPager::pull(void)
@@ -654,6 +1193,7 @@ const char *StringPager::pull(void)
     else
         root = mem->Next;
     index = NULL;
+    chunks->pull();
     return result;
 }
 
@@ -678,6 +1218,7 @@ void StringPager::push(const char *text)
         last = node;
     ++members;
     index = NULL;
+    chunks->push(node);
 }
 
 const char *StringPager::pop(void)
@@ -690,25 +1231,17 @@ const char *StringPager::pop(void)
     }
 
     index = NULL;
+    out = last->text;
+    chunks->pop();
 
     if(root == last) {
-        out = last->text;
         root = last = NULL;
         members = 0;
         return out;
     }
 
-    linked_pointer<member> np = root;
-    while(is(np)) {
-        if(np->Next == last) {
-            out = last->text;
-            last = *np;
-            np->Next = NULL;
-            --members;
-            break;
-        }
-        np.next();
-    }
+    last = static_cast<member *>(chunks->get(--members - 1));
+    last->Next = NULL;
     return out;
 }
 
@@ -736,6 +1269,7 @@ void StringPager::add(const char *text)
     else
         node = new(mem) member(&root, str);
     last = node;
+    chunks->add(node);
 }
 
 void StringPager::set(char **list)
@@ -773,22 +1307,22 @@ void StringPager::sort(void)
     if(!members)
         return;
 
-	unsigned count = members;
-    member **list = new member*[members];
+    member **list = (member **)chunks->table(members);
     unsigned pos = 0;
-    linked_pointer<member> mp = root;
 
-    while(is(mp) && count--) {
-        list[pos++] = *mp;
-        mp.next();
+    while(pos < members) {
+        list[pos] = static_cast<member *>(chunks->get(pos));
+        ++pos;
     }
 
     qsort(static_cast<void *>(list), members, sizeof(member *), &ncompare);
     root = NULL;
-    while(pos)
+    while(pos) {
         list[--pos]->enlist(&root);
+        chunks->set(pos, list[pos]);
+    }
 
-    delete[] list;
+    last = list[members - 1];
     index = NULL;
 }
 
@@ -798,11 +1332,10 @@ char **StringPager::list(void)
         return index;
 
     unsigned pos = 0;
-    index = (char **)memalloc::_alloc(sizeof(char *) * (members + 1));
-    linked_pointer<member> mp = root;
-    while(is(mp)) {
-        index[pos++] = (char *)mp->text;
-        mp.next();
+    index = (char **)chunks->gather(members);
+    while(pos < members) {
+        index[pos] = (char *)(static_cast<member *>(chunks->get(pos)))->text;
+        ++pos;
     }
     index[pos] = NULL;
     return index;
@@ -894,7 +1427,7 @@ void autorelease::operator+=(LinkedObject *obj)
 }
 
 PagerObject::PagerObject() :
-LinkedObject(nullptr), CountedObject()
+LinkedObject(), CountedObject()
 {
 }
 
@@ -919,21 +1452,70 @@ void PagerObject::retain(void)
     CountedObject::retain();
 }
 
-PagerPool::PagerPool()
+PagerPool::PagerPool(unsigned cache)
 {
     freelist = NULL;
+    caches = NULL;
     pthread_mutex_init(&mutex, NULL);
+    if(cache)
+        caches = new PagerCache(1, cache);
 }
 
 PagerPool::~PagerPool()
 {
     pthread_mutex_destroy(&mutex);
+    if(caches)
+        delete caches;
+}
+
+pagerstats_t PagerPool::stats(void) const
+{
+    pagerstats_t result;
+
+    if(caches)
+        return caches->stats();
+
+    memset(&result, 0, sizeof(result));
+    return result;
+}
+
+// objects of a pool with thread caches are allocated after a link word,
+// which chains them while they are cached, so no part of the object itself,
+// such as it's virtual table, is overwritten...
+
+static inline void *pager_link(PagerObject *object)
+{
+    return ((void **)object) - 1;
+}
+
+static inline PagerObject *pager_object(void *link)
+{
+    return (PagerObject *)(((void **)link) + 1);
 }
 
 void PagerPool::put(PagerObject *ptr)
 {
     assert(ptr != NULL);
 
+    PagerObject *node;
+    void *chain;
+
+    if(caches) {
+        chain = caches->put(0, pager_link(ptr), ptr->origin);
+        if(!chain)
+            return;
+
+        pthread_mutex_lock(&mutex);
+        while(chain) {
+            node = pager_object(chain);
+            chain = *((void **)chain);
+            node->Next = freelist;
+            freelist = node;
+        }
+        pthread_mutex_unlock(&mutex);
+        return;
+    }
+
     pthread_mutex_lock(&mutex);
     ptr->enlist(&freelist);
     pthread_mutex_unlock(&mutex);
@@ -943,20 +1525,44 @@ PagerObject *PagerPool::get(size_t size)
 {
     assert(size > 0);
 
-    PagerObject *ptr;
-    pthread_mutex_lock(&mutex);
-    ptr = static_cast<PagerObject *>(freelist);
-    if(ptr)
-        freelist = ptr->Next;
+    PagerObject *ptr, *node;
+    void *chain = NULL;
 
-    pthread_mutex_unlock(&mutex);
+    if(caches && (chain = caches->get(0)) != NULL) {
+        ptr = pager_object(chain);
+        chain = NULL;
+    }
+    else
+        ptr = NULL;
+
+    // a thread cache miss also takes a batch from the shared free list...
+    if(!ptr) {
+        pthread_mutex_lock(&mutex);
+        ptr = static_cast<PagerObject *>(freelist);
+        if(ptr)
+            freelist = ptr->Next;
+
+        for(unsigned pos = 1; caches && freelist && pos < caches->batch; ++pos) {
+            node = static_cast<PagerObject *>(freelist);
+            freelist = node->Next;
+            *((void **)pager_link(node)) = chain;
+            chain = pager_link(node);
+        }
+        pthread_mutex_unlock(&mutex);
+        if(caches)
+            caches->fill(0, chain);
+    }
 
-    if(!ptr)
+    if(!ptr && caches)
+        ptr = new(pager_object(_alloc(size + sizeof(void *)))) PagerObject;
+    else if(!ptr)
         ptr = new((_alloc(size))) PagerObject;
     else
         ptr->reset();
-	if (ptr)
-		ptr->pager = this;
+    if(ptr) {
+        ptr->pager = this;
+        ptr->origin = caches ? caches->origin() : 0;
+    }
     return ptr;
 }
 
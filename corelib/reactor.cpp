@@ -0,0 +1,509 @@
+// Copyright (C) 2015-2020 Cherokees of Idaho.
+//
+// This file is part of GNU uCommon C++.
+//
+// GNU uCommon C++ is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// GNU uCommon C++ is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with GNU uCommon C++.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <ucommon-config.h>
+#include <ucommon/export.h>
+#include <ucommon/timers.h>
+#include <ucommon/thread.h>
+#include <ucommon/socket.h>
+#include <ucommon/fsys.h>
+#include <ucommon/reactor.h>
+
+#ifndef _MSWINDOWS_
+
+#include <cstdlib>
+#include <climits>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#if defined(HAVE_SYS_EPOLL_H)
+#include <sys/epoll.h>
+#define REACTOR_EPOLL
+#elif defined(HAVE_POLL_H)
+#include <poll.h>
+#elif defined(HAVE_SYS_POLL_H)
+#include <sys/poll.h>
+#endif
+
+namespace ucommon {
+
+// attached sources are kept in a list so the reactor can detach them all
+// when destroyed; poll also keeps a pollfd for each at the same index,
+// after the wakeup pipe at index 0...
+class Reactor::Backend
+{
+private:
+    __DELETE_COPY(Backend);
+
+public:
+    Reactor::source **list;
+    Reactor::source *active;
+    size_t count, limit;
+#ifdef  REACTOR_EPOLL
+    int epfd;
+    struct epoll_event *ready;
+    int pending, size;
+#else
+    struct pollfd *fds;
+#endif
+
+    Backend(size_t hint);
+    ~Backend();
+
+    bool grow(void);
+};
+
+Reactor::Backend::Backend(size_t hint)
+{
+    if(hint < 8)
+        hint = 8;
+
+    count = 0;
+    limit = hint;
+    active = NULL;
+    list = (Reactor::source **)::malloc(sizeof(Reactor::source *) * limit);
+
+#ifdef  REACTOR_EPOLL
+#ifdef  EPOLL_CLOEXEC
+    epfd = epoll_create1(EPOLL_CLOEXEC);
+#else
+    epfd = epoll_create((int)hint);
+#endif
+    pending = 0;
+    size = (int)(hint < 1024 ? hint : 1024);
+    ready = (struct epoll_event *)::malloc(sizeof(struct epoll_event) * size);
+#else
+    fds = (struct pollfd *)::malloc(sizeof(struct pollfd) * (limit + 1));
+#endif
+
+    if(!list)
+        __THROW_ALLOC();
+
+#ifdef  REACTOR_EPOLL
+    if(!ready)
+        __THROW_ALLOC();
+#else
+    if(!fds)
+        __THROW_ALLOC();
+#endif
+}
+
+Reactor::Backend::~Backend()
+{
+    ::free(list);
+#ifdef  REACTOR_EPOLL
+    if(epfd > -1)
+        ::close(epfd);
+    ::free(ready);
+#else
+    ::free(fds);
+#endif
+}
+
+bool Reactor::Backend::grow(void)
+{
+    size_t resize = limit * 2;
+
+    Reactor::source **expand = (Reactor::source **)::realloc(list, sizeof(Reactor::source *) * resize);
+    if(!expand)
+        return false;
+
+    list = expand;
+#ifndef REACTOR_EPOLL
+    struct pollfd *pfd = (struct pollfd *)::realloc(fds, sizeof(struct pollfd) * (resize + 1));
+    if(!pfd)
+        return false;
+    fds = pfd;
+#endif
+    limit = resize;
+    return true;
+}
+
+Reactor::source::source()
+{
+    reactor = NULL;
+    fd = INVALID_SOCKET;
+    mask = 0;
+    index = 0;
+}
+
+Reactor::source::~source()
+{
+    detach();
+}
+
+void Reactor::source::readable(void)
+{
+}
+
+void Reactor::source::writable(void)
+{
+}
+
+bool Reactor::source::wait(unsigned events)
+{
+    if(!reactor)
+        return false;
+
+    return reactor->wait(this, events);
+}
+
+void Reactor::source::detach(void)
+{
+    if(reactor)
+        reactor->detach(this);
+}
+
+Reactor::Reactor(size_t hint) :
+TimerQueue()
+{
+    backend = new Backend(hint);
+    owner = Thread::self();
+    running = stopped = false;
+    sources = 0;
+    wake[0] = wake[1] = -1;
+
+    if(fsys::pipe(wake[0], wake[1]))
+        return;
+
+    fsys::inherit(wake[0], false);
+    fsys::inherit(wake[1], false);
+    ::fcntl(wake[0], F_SETFL, ::fcntl(wake[0], F_GETFL) | O_NONBLOCK);
+    ::fcntl(wake[1], F_SETFL, ::fcntl(wake[1], F_GETFL) | O_NONBLOCK);
+
+#ifdef  REACTOR_EPOLL
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.ptr = backend;
+    epoll_ctl(backend->epfd, EPOLL_CTL_ADD, wake[0], &ev);
+#else
+    backend->fds[0].fd = wake[0];
+    backend->fds[0].events = POLLIN;
+    backend->fds[0].revents = 0;
+#endif
+}
+
+Reactor::~Reactor()
+{
+    while(backend->count)
+        detach(backend->list[backend->count - 1]);
+
+    if(wake[0] > -1)
+        ::close(wake[0]);
+    if(wake[1] > -1)
+        ::close(wake[1]);
+
+    delete backend;
+}
+
+void Reactor::modify(void)
+{
+    lock.acquire();
+}
+
+void Reactor::update(void)
+{
+    bool remote = running && !Thread::equal(owner, Thread::self());
+
+    lock.release();
+    if(remote)
+        wakeup();
+}
+
+void Reactor::wakeup(void)
+{
+    char byte = 0;
+
+    // only one wakeup byte is outstanding until the loop drains it...
+    if(wake[1] > -1 && waking.compare_exchange(0, 1)) {
+        if(::write(wake[1], &byte, 1) < 1)
+            waking.clear();
+    }
+}
+
+void Reactor::drain(void)
+{
+    char buf[64];
+
+    waking.clear();
+    while(::read(wake[0], buf, sizeof(buf)) > 0)
+        ;
+}
+
+void Reactor::stop(void)
+{
+    lock.acquire();
+    stopped = true;
+    lock.release();
+    wakeup();
+}
+
+bool Reactor::attach(source *object, socket_t so, unsigned events)
+{
+    if(!object || so == INVALID_SOCKET)
+        return false;
+
+    if(object->reactor)
+        object->reactor->detach(object);
+
+    lock.acquire();
+    if(backend->count >= backend->limit && !backend->grow()) {
+        lock.release();
+        return false;
+    }
+
+#ifdef  REACTOR_EPOLL
+    struct epoll_event ev;
+    ev.events = 0;
+    if(events & READ)
+        ev.events |= EPOLLIN;
+    if(events & WRITE)
+        ev.events |= EPOLLOUT;
+    ev.data.ptr = object;
+    if(epoll_ctl(backend->epfd, EPOLL_CTL_ADD, so, &ev)) {
+        lock.release();
+        return false;
+    }
+#else
+    struct pollfd *pfd = &backend->fds[backend->count + 1];
+    pfd->fd = so;
+    pfd->events = 0;
+    pfd->revents = 0;
+    if(events & READ)
+        pfd->events |= POLLIN;
+    if(events & WRITE)
+        pfd->events |= POLLOUT;
+#endif
+
+    object->reactor = this;
+    object->fd = so;
+    object->mask = events;
+    object->index = backend->count;
+    backend->list[backend->count++] = object;
+    ++sources;
+
+    // poll only sees a changed descriptor set on its next call...
+#ifndef REACTOR_EPOLL
+    bool remote = running && !Thread::equal(owner, Thread::self());
+    lock.release();
+    if(remote)
+        wakeup();
+#else
+    lock.release();
+#endif
+    return true;
+}
+
+bool Reactor::wait(source *object, unsigned events)
+{
+    if(!object || object->reactor != this)
+        return false;
+
+    lock.acquire();
+#ifdef  REACTOR_EPOLL
+    struct epoll_event ev;
+    ev.events = 0;
+    if(events & READ)
+        ev.events |= EPOLLIN;
+    if(events & WRITE)
+        ev.events |= EPOLLOUT;
+    ev.data.ptr = object;
+    if(epoll_ctl(backend->epfd, EPOLL_CTL_MOD, object->fd, &ev)) {
+        lock.release();
+        return false;
+    }
+#else
+    struct pollfd *pfd = &backend->fds[object->index + 1];
+    pfd->events = 0;
+    if(events & READ)
+        pfd->events |= POLLIN;
+    if(events & WRITE)
+        pfd->events |= POLLOUT;
+#endif
+    object->mask = events;
+
+#ifndef REACTOR_EPOLL
+    bool remote = running && !Thread::equal(owner, Thread::self());
+    lock.release();
+    if(remote)
+        wakeup();
+#else
+    lock.release();
+#endif
+    return true;
+}
+
+void Reactor::detach(source *object)
+{
+    if(!object || object->reactor != this)
+        return;
+
+    lock.acquire();
+#ifdef  REACTOR_EPOLL
+    struct epoll_event ev;
+    ev.events = 0;
+    ev.data.ptr = object;
+    epoll_ctl(backend->epfd, EPOLL_CTL_DEL, object->fd, &ev);
+
+    // a source may still be in the ready list of the current dispatch...
+    for(int pos = 0; pos < backend->pending; ++pos) {
+        if(backend->ready[pos].data.ptr == object)
+            backend->ready[pos].data.ptr = NULL;
+    }
+#endif
+
+    size_t last = --backend->count;
+    if(object->index != last) {
+        backend->list[object->index] = backend->list[last];
+        backend->list[object->index]->index = object->index;
+#ifndef REACTOR_EPOLL
+        backend->fds[object->index + 1] = backend->fds[last + 1];
+#endif
+    }
+
+    if(backend->active == object)
+        backend->active = NULL;
+
+    object->reactor = NULL;
+    object->fd = INVALID_SOCKET;
+    object->mask = 0;
+    object->index = 0;
+    --sources;
+    lock.release();
+}
+
+unsigned Reactor::dispatch(timeout_t timeout)
+{
+    unsigned calls = 0;
+    timeout_t next;
+    source *object;
+    int wait, pos, result;
+    bool input, output;
+
+    lock.acquire();
+    owner = Thread::self();
+    running = true;
+    if(stopped)
+        timeout = 0;
+    lock.release();
+
+    next = expire();
+    if(next < timeout)
+        timeout = next;
+
+    if(timeout == Timer::inf)
+        wait = -1;
+    else if(timeout > (timeout_t)INT_MAX)
+        wait = INT_MAX;
+    else
+        wait = (int)timeout;
+
+#ifdef  REACTOR_EPOLL
+    result = epoll_wait(backend->epfd, backend->ready, backend->size, wait);
+    if(result < 0)
+        result = 0;
+
+    lock.acquire();
+    backend->pending = result;
+    for(pos = 0; pos < backend->pending; ++pos) {
+        if(backend->ready[pos].data.ptr == (void *)backend) {
+            drain();
+            continue;
+        }
+        object = (source *)backend->ready[pos].data.ptr;
+        if(!object)
+            continue;
+        unsigned events = backend->ready[pos].events;
+        input = (events & (EPOLLIN | EPOLLHUP | EPOLLERR)) != 0;
+        output = (events & EPOLLOUT) != 0;
+#else
+    result = ::poll(backend->fds, (nfds_t)(backend->count + 1), wait);
+    if(result < 0)
+        result = 0;
+
+    lock.acquire();
+    if(result && backend->fds[0].revents) {
+        backend->fds[0].revents = 0;
+        drain();
+    }
+
+    // sources detached by callbacks swap the last entry into their place,
+    // which may then be skipped until the next dispatch...
+    for(pos = 0; result && (size_t)pos < backend->count; ++pos) {
+        short events = backend->fds[pos + 1].revents;
+        if(!events)
+            continue;
+        backend->fds[pos + 1].revents = 0;
+        object = backend->list[pos];
+        input = (events & (POLLIN | POLLHUP | POLLERR)) != 0;
+        output = (events & POLLOUT) != 0;
+#endif
+        // a failed descriptor is reported to the callback it waits on...
+        if(input && !(object->mask & READ)) {
+            input = false;
+            output = true;
+        }
+
+        backend->active = object;
+        lock.release();
+        ++calls;
+        if(input)
+            object->readable();
+        lock.acquire();
+        if(output && backend->active == object) {
+            lock.release();
+            object->writable();
+            lock.acquire();
+        }
+        backend->active = NULL;
+    }
+
+#ifdef  REACTOR_EPOLL
+    backend->pending = 0;
+    if(result == backend->size && (size_t)backend->size < backend->limit) {
+        struct epoll_event *expand = (struct epoll_event *)::realloc(backend->ready, sizeof(struct epoll_event) * backend->size * 2);
+        if(expand) {
+            backend->ready = expand;
+            backend->size *= 2;
+        }
+    }
+#endif
+    lock.release();
+    return calls;
+}
+
+void Reactor::run(void)
+{
+    bool done = false;
+
+    while(!done) {
+        dispatch();
+        lock.acquire();
+        done = stopped;
+        lock.release();
+    }
+
+    lock.acquire();
+    stopped = false;
+    running = false;
+    lock.release();
+}
+
+} // namespace ucommon
+
+#endif
@@ -0,0 +1,598 @@
+// Copyright (C) 2015-2020 Cherokees of Idaho.
+//
+// This file is part of GNU uCommon C++.
+//
+// GNU uCommon C++ is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// GNU uCommon C++ is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with GNU uCommon C++.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <ucommon-config.h>
+#include <ucommon/export.h>
+#include <ucommon/linked.h>
+#include <ucommon/timers.h>
+#include <ucommon/thread.h>
+#include <ucommon/condition.h>
+#include <ucommon/socket.h>
+#include <ucommon/resolver.h>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+
+#ifndef AI_NUMERICSERV
+#define AI_NUMERICSERV 0
+#endif
+
+namespace ucommon {
+
+// lookups through sockets share the installed resolver, so it cannot be
+// removed or destroyed while they are using it...
+static RWLock hooked;
+static Resolver *installed = NULL;
+
+static int lookup_hook(const char *host, const char *svc, const struct addrinfo *hint, struct addrinfo **result)
+{
+    int error;
+
+    hooked.access();
+    if(installed)
+        error = installed->lookup(host, svc, hint, result);
+    else
+        error = getaddrinfo(host, svc, hint, result);
+    hooked.release();
+    return error;
+}
+
+// a remembered lookup, kept both in its hash bucket and in age order so
+// the oldest may be dropped when the cache is full...
+class __LOCAL record
+{
+private:
+    __DELETE_COPY(record);
+
+public:
+    typedef struct {
+        int socktype;
+        int protocol;
+        socklen_t len;
+        struct sockaddr_storage address;
+    } entry_t;
+
+    record *next, *older, *newer;
+    unsigned path;
+    char *key;
+    int err;
+    Timer expires;
+    unsigned count;
+    entry_t *entries;
+
+    record(const char *id, unsigned hash, int error, timeout_t ttl, unsigned size);
+    ~record();
+
+    struct addrinfo *copy(void) const;
+};
+
+record::record(const char *id, unsigned hash, int error, timeout_t ttl, unsigned size) :
+expires(ttl)
+{
+    next = older = newer = NULL;
+    path = hash;
+    key = ::strdup(id);
+    err = error;
+    count = size;
+    entries = NULL;
+    if(count)
+        entries = new entry_t[count];
+    if(!key)
+        __THROW_ALLOC();
+}
+
+record::~record()
+{
+    ::free(key);
+    if(entries)
+        delete[] entries;
+}
+
+// a numeric lookup of an any address allocates each node the way the
+// system getaddrinfo does, so the list may be released with freeaddrinfo;
+// the cached address is then copied over it...
+struct addrinfo *record::copy(void) const
+{
+    struct addrinfo hint, *list = NULL, *last = NULL, *node;
+    const char *any;
+
+    for(unsigned pos = 0; pos < count; ++pos) {
+        const entry_t *ep = &entries[pos];
+        memset(&hint, 0, sizeof(hint));
+        hint.ai_family = ep->address.ss_family;
+        hint.ai_socktype = ep->socktype;
+        hint.ai_protocol = ep->protocol;
+        hint.ai_flags = AI_NUMERICHOST | AI_NUMERICSERV;
+        if(hint.ai_family == AF_INET)
+            any = "0.0.0.0";
+        else
+            any = "::";
+
+        node = NULL;
+        if(getaddrinfo(any, NULL, &hint, &node) || !node || (socklen_t)node->ai_addrlen != ep->len) {
+            if(node)
+                freeaddrinfo(node);
+            if(list)
+                freeaddrinfo(list);
+            return NULL;
+        }
+
+        if(node->ai_next) {
+            freeaddrinfo(node->ai_next);
+            node->ai_next = NULL;
+        }
+
+        node->ai_socktype = ep->socktype;
+        node->ai_protocol = ep->protocol;
+        memcpy(node->ai_addr, &ep->address, ep->len);
+        if(last)
+            last->ai_next = node;
+        else
+            list = node;
+        last = node;
+    }
+    return list;
+}
+
+class __LOCAL Resolver::Backend : public Conditional
+{
+private:
+    __DELETE_COPY(Backend);
+
+public:
+    class worker : public JoinableThread
+    {
+    private:
+        __DELETE_COPY(worker);
+
+        Backend *backend;
+
+        void run(void) __OVERRIDE;
+
+    public:
+        inline worker(Backend *server) : JoinableThread(), backend(server) {}
+
+        inline ~worker() {
+            join();
+        }
+    };
+
+    Resolver *resolver;
+    Mutex cache;
+    record **index;
+    record *oldest, *newest;
+    unsigned buckets;
+    size_t cached, limit;
+    timeout_t ttl, negative;
+    Resolver::request *first, *last;
+    worker **threads;
+    unsigned workers;
+    bool stopping;
+
+    Backend(Resolver *owner, unsigned count, timeout_t positive, timeout_t failed, unsigned size);
+    ~Backend();
+
+    bool keyed(char *key, size_t size, const char *host, const char *svc, const struct addrinfo *hint);
+    bool find(const char *key, unsigned hash, struct addrinfo **result, int *error);
+    void save(const char *key, unsigned hash, int error, const struct addrinfo *list);
+    void remove(record *rp);
+    void clear(void);
+    void queue(Resolver::request *object);
+    void serve(void);
+};
+
+Resolver::Backend::Backend(Resolver *owner, unsigned count, timeout_t positive, timeout_t failed, unsigned size) :
+Conditional()
+{
+    resolver = owner;
+    oldest = newest = NULL;
+    cached = 0;
+    limit = size;
+    ttl = positive;
+    negative = failed;
+    first = last = NULL;
+    stopping = false;
+    workers = 0;
+    threads = NULL;
+
+    buckets = size / 4;
+    if(buckets < 16)
+        buckets = 16;
+    index = new record *[buckets];
+    memset(index, 0, sizeof(record *) * buckets);
+
+    if(!count)
+        return;
+
+    threads = new worker *[count];
+    while(workers < count) {
+        threads[workers] = new worker(this);
+        threads[workers++]->start();
+    }
+}
+
+Resolver::Backend::~Backend()
+{
+    Resolver::request *pending, *object;
+
+    lock();
+    stopping = true;
+    pending = first;
+    first = last = NULL;
+    broadcast();
+    unlock();
+
+    while(workers)
+        delete threads[--workers];
+
+    if(threads)
+        delete[] threads;
+
+    // requests still queued are called back as failed, so nobody waits...
+    while(pending) {
+        object = pending;
+        pending = object->next;
+        object->err = EAI_AGAIN;
+        object->completed();
+        object->busy.clear();
+    }
+
+    clear();
+    delete[] index;
+}
+
+// lookups are only cached by their complete hint and names, and those not
+// worth caching or too long for the key are passed through...
+bool Resolver::Backend::keyed(char *key, size_t size, const char *host, const char *svc, const struct addrinfo *hint)
+{
+    int len;
+
+    if(!host || !*host || !limit || (!ttl && !negative))
+        return false;
+
+    if(hint && (hint->ai_flags & (AI_CANONNAME | AI_NUMERICHOST)))
+        return false;
+
+    if(!svc)
+        svc = "";
+
+    if(hint)
+        len = snprintf(key, size, "%d/%d/%d/%d/%s/%s", hint->ai_family, hint->ai_socktype, hint->ai_protocol, hint->ai_flags, host, svc);
+    else
+        len = snprintf(key, size, "*/%s/%s", host, svc);
+
+    return len > 0 && (size_t)len < size;
+}
+
+void Resolver::Backend::remove(record *rp)
+{
+    record **bp = &index[rp->path];
+
+    while(*bp != rp)
+        bp = &((*bp)->next);
+    *bp = rp->next;
+
+    if(rp->older)
+        rp->older->newer = rp->newer;
+    else
+        oldest = rp->newer;
+
+    if(rp->newer)
+        rp->newer->older = rp->older;
+    else
+        newest = rp->older;
+
+    --cached;
+    delete rp;
+}
+
+bool Resolver::Backend::find(const char *key, unsigned hash, struct addrinfo **result, int *error)
+{
+    record *rp;
+    struct addrinfo *list = NULL;
+    bool found = false;
+
+    cache.acquire();
+    rp = index[hash];
+    while(rp && strcmp(rp->key, key))
+        rp = rp->next;
+
+    if(rp && !rp->expires.get())
+        remove(rp);
+    else if(rp && rp->err) {
+        *error = rp->err;
+        found = true;
+    }
+    else if(rp) {
+        list = rp->copy();
+        if(list) {
+            *error = 0;
+            found = true;
+        }
+    }
+    cache.release();
+
+    *result = list;
+    return found;
+}
+
+void Resolver::Backend::save(const char *key, unsigned hash, int error, const struct addrinfo *list)
+{
+    const struct addrinfo *node;
+    unsigned count = 0;
+    timeout_t expires = ttl;
+
+    // failures of the local system rather than of the lookup are not kept...
+    switch(error) {
+    case 0:
+        break;
+    case EAI_MEMORY:
+#ifdef  EAI_SYSTEM
+    case EAI_SYSTEM:
+#endif
+        return;
+    default:
+        expires = negative;
+        list = NULL;
+    }
+
+    if(!expires)
+        return;
+
+    for(node = list; node; node = node->ai_next) {
+        if(!node->ai_addr || (node->ai_family != AF_INET && node->ai_family != AF_INET6))
+            return;
+        if((size_t)node->ai_addrlen > sizeof(struct sockaddr_storage))
+            return;
+        ++count;
+    }
+
+    if(!error && !count)
+        return;
+
+    record *rp = new record(key, hash, error, expires, count);
+    count = 0;
+    for(node = list; node; node = node->ai_next) {
+        record::entry_t *ep = &rp->entries[count++];
+        ep->socktype = node->ai_socktype;
+        ep->protocol = node->ai_protocol;
+        ep->len = (socklen_t)node->ai_addrlen;
+        memcpy(&ep->address, node->ai_addr, node->ai_addrlen);
+    }
+
+    cache.acquire();
+    record *prior = index[hash];
+    while(prior && strcmp(prior->key, key))
+        prior = prior->next;
+    if(prior)
+        remove(prior);
+
+    while(cached >= limit && oldest)
+        remove(oldest);
+
+    rp->next = index[hash];
+    index[hash] = rp;
+    rp->older = newest;
+    if(newest)
+        newest->newer = rp;
+    else
+        oldest = rp;
+    newest = rp;
+    ++cached;
+    cache.release();
+}
+
+void Resolver::Backend::clear(void)
+{
+    cache.acquire();
+    while(oldest)
+        remove(oldest);
+    cache.release();
+}
+
+void Resolver::Backend::queue(Resolver::request *object)
+{
+    lock();
+    if(last)
+        last->next = object;
+    else
+        first = object;
+    last = object;
+    signal();
+    unlock();
+}
+
+void Resolver::Backend::serve(void)
+{
+    Resolver::request *object;
+    struct addrinfo *list;
+    int error;
+
+    lock();
+    while(!stopping) {
+        if(!first) {
+            wait();
+            continue;
+        }
+
+        object = first;
+        first = object->next;
+        if(!first)
+            last = NULL;
+        unlock();
+
+        list = NULL;
+        error = resolver->lookup(object->host, object->service, &object->hint, &list);
+        object->list = list;
+        object->err = error;
+
+        // the request is the caller's again once it is no longer busy, so
+        // that is only published after the callback is done with it...
+        object->completed();
+        object->busy.clear();
+
+        lock();
+    }
+    unlock();
+}
+
+void Resolver::Backend::worker::run(void)
+{
+    backend->serve();
+}
+
+Resolver::request::request()
+{
+    next = NULL;
+    host = service = NULL;
+    list = NULL;
+    err = 0;
+    memset(&hint, 0, sizeof(hint));
+}
+
+Resolver::request::~request()
+{
+    if(list)
+        freeaddrinfo(list);
+    ::free(host);
+    ::free(service);
+}
+
+void Resolver::request::completed(void)
+{
+}
+
+bool Resolver::request::is_busy(void) const
+{
+    return busy.get() != 0;
+}
+
+struct addrinfo *Resolver::request::release(void)
+{
+    struct addrinfo *result = list;
+
+    list = NULL;
+    return result;
+}
+
+Resolver::Resolver(unsigned threads, timeout_t ttl, timeout_t negative, unsigned limit)
+{
+    backend = new Backend(this, threads, ttl, negative, limit);
+}
+
+Resolver::~Resolver()
+{
+    hooked.modify();
+    if(installed == this) {
+        Socket::resolver(NULL);
+        installed = NULL;
+    }
+    hooked.release();
+
+    delete backend;
+}
+
+int Resolver::lookup(const char *host, const char *svc, const struct addrinfo *hint, struct addrinfo **result)
+{
+    char key[512];
+    unsigned hash;
+    int error;
+
+    *result = NULL;
+    if(!backend->keyed(key, sizeof(key), host, svc, hint))
+        return getaddrinfo(host, svc, hint, result);
+
+    hash = NamedObject::keyindex(key, backend->buckets);
+    if(backend->find(key, hash, result, &error))
+        return error;
+
+    error = getaddrinfo(host, svc, hint, result);
+    backend->save(key, hash, error, *result);
+    return error;
+}
+
+bool Resolver::lookup(request *object, const char *host, const char *svc, const struct addrinfo *hint)
+{
+    char key[512];
+
+    if(!object || object->busy.get() || !host || !*host)
+        return false;
+
+    if(object->list) {
+        freeaddrinfo(object->list);
+        object->list = NULL;
+    }
+    ::free(object->host);
+    ::free(object->service);
+    object->host = ::strdup(host);
+    object->service = NULL;
+    if(svc)
+        object->service = ::strdup(svc);
+    if(!object->host || (svc && !object->service))
+        __THROW_ALLOC();
+
+    memset(&object->hint, 0, sizeof(object->hint));
+    if(hint) {
+        object->hint.ai_flags = hint->ai_flags;
+        object->hint.ai_family = hint->ai_family;
+        object->hint.ai_socktype = hint->ai_socktype;
+        object->hint.ai_protocol = hint->ai_protocol;
+    }
+    object->err = 0;
+    object->next = NULL;
+
+    // cached and synchronous lookups are called back right away...
+    if(!backend->workers || (backend->keyed(key, sizeof(key), host, svc, &object->hint) &&
+      backend->find(key, NamedObject::keyindex(key, backend->buckets), &object->list, &object->err))) {
+        if(!backend->workers)
+            object->err = lookup(host, svc, &object->hint, &object->list);
+        object->completed();
+        return true;
+    }
+
+    object->busy.compare_exchange(0, 1);
+    backend->queue(object);
+    return true;
+}
+
+void Resolver::clear(void)
+{
+    backend->clear();
+}
+
+size_t Resolver::count(void) const
+{
+    return backend->cached;
+}
+
+void Resolver::install(void)
+{
+    hooked.modify();
+    installed = this;
+    Socket::resolver(&lookup_hook);
+    hooked.release();
+}
+
+void Resolver::release(void)
+{
+    hooked.modify();
+    Socket::resolver(NULL);
+    installed = NULL;
+    hooked.release();
+}
+
+} // namespace ucommon
@@ -56,6 +56,208 @@ void SharedRef::put(TypeRef& ptr)
 	lock.release();
 }
 
+// per-thread read section record, padded to keep threads apart...
+typedef struct rcu_record {
+	Atomic::counter epoch;
+	unsigned nesting;
+	bool used;
+	struct rcu_record *next;
+	char pad[64];
+} rcu_record_t;
+
+typedef struct rcu_retired {
+	TypeRef::Counted *object;
+	atomic_t epoch;
+	struct rcu_retired *next;
+} rcu_retired_t;
+
+// a spinlock has no destructor, so retiring still works during exit
+static Atomic::spinlock rcu_lock;
+static rcu_record_t *rcu_records = NULL;
+static rcu_retired_t *rcu_retired = NULL;
+
+// made on first use, so that objects retired or read while other statics
+// are still being constructed find them ready...
+static Atomic::counter& rcu_epoch(void)
+{
+	static Atomic::counter epoch(1);
+	return epoch;
+}
+
+// epochs wrap, so they are compared by difference
+static inline bool rcu_before(atomic_t epoch, atomic_t other)
+{
+	return (atomic_t)((unsigned)epoch - (unsigned)other) < 0;
+}
+
+static void rcu_retire(TypeRef::Counted *object)
+{
+	rcu_lock.wait();
+	rcu_retired_t *node = new rcu_retired_t;
+	node->object = object;
+	node->epoch = ++rcu_epoch();
+	if(!node->epoch)
+		node->epoch = ++rcu_epoch();
+	node->next = rcu_retired;
+	rcu_retired = node;
+	rcu_lock.release();
+	RCURef::reclaim();
+}
+
+// objects are otherwise only reclaimed when another is retired, so the
+// last ones retired are reclaimed as threads leave and at exit...
+class rcu_thread : public Thread::Local
+{
+private:
+	virtual void release(void *instance) __FINAL {
+		rcu_record_t *record = static_cast<rcu_record_t *>(instance);
+		rcu_lock.wait();
+		record->epoch.clear();
+		record->nesting = 0;
+		record->used = false;
+		rcu_lock.release();
+		RCURef::reclaim();
+	}
+
+	virtual void *allocate() __FINAL {
+		rcu_lock.wait();
+		rcu_record_t *record = rcu_records;
+		while(record && record->used)
+			record = record->next;
+		if(!record) {
+			record = new rcu_record_t;
+			record->nesting = 0;
+			record->next = rcu_records;
+			rcu_records = record;
+		}
+		record->used = true;
+		rcu_lock.release();
+		return record;
+	}
+
+public:
+	~rcu_thread() {
+		RCURef::reclaim();
+	}
+};
+
+static rcu_thread& rcu_local(void)
+{
+	static rcu_thread local;
+	return local;
+}
+
+RCURef::Reader::Reader(RCURef& from)
+{
+	rcu_record_t *rec = static_cast<rcu_record_t *>(*rcu_local());
+	record = rec;
+	if(!rec->nesting++) {
+		// 0 marks a thread outside read sections, so if the epoch is
+		// seen as it wraps, enter as older than any retired object...
+		atomic_t epoch = rcu_epoch().get();
+		if(!epoch)
+			epoch = -1;
+		rec->epoch.compare_exchange(0, epoch);
+	}
+	object = from.read();
+}
+
+RCURef::Reader::~Reader()
+{
+	rcu_record_t *rec = static_cast<rcu_record_t *>(record);
+	if(!--rec->nesting)
+		rec->epoch.clear();
+}
+
+RCURef::RCURef() : TypeRef()
+{
+}
+
+RCURef::~RCURef()
+{
+	Counted *old = ref;
+	ref = NULL;
+	if(old)
+		rcu_retire(old);
+}
+
+TypeRef::Counted *RCURef::read(void)
+{
+	Counted *object;
+	atomic_t current;
+
+	// the version is odd while a writer changes the reference...
+	for(;;) {
+		current = version.get();
+		if(current & 1)
+			continue;
+		object = ref;
+		if(version.get() == current)
+			return object;
+	}
+}
+
+void RCURef::get(TypeRef& ptr)
+{
+	lock.acquire();
+	Counted *old = ref;
+	if(ptr.ref)
+		ptr.ref->retain();
+	++version;
+	ref = ptr.ref;
+	++version;
+	lock.release();
+
+	if(old)
+		rcu_retire(old);
+}
+
+void RCURef::put(TypeRef& ptr)
+{
+	Reader section(*this);
+	ptr.set(section.object);
+}
+
+unsigned RCURef::reclaim(void)
+{
+	rcu_retired_t *node, *next, *list = NULL, **prior;
+	rcu_record_t *record;
+	atomic_t oldest = 0, epoch;
+	unsigned count = 0;
+
+	rcu_lock.wait();
+	for(record = rcu_records; record; record = record->next) {
+		// a full barrier exchange, so a reader entering later syncs
+		// with the retire, and one that left syncs with us...
+		if(record->epoch.compare_exchange(0, 0))
+			continue;
+		epoch = record->epoch.get();
+		if(epoch && (!oldest || rcu_before(epoch, oldest)))
+			oldest = epoch;
+	}
+
+	prior = &rcu_retired;
+	while(NULL != (node = *prior)) {
+		if(oldest && rcu_before(oldest, node->epoch)) {
+			prior = &node->next;
+			continue;
+		}
+		*prior = node->next;
+		node->next = list;
+		list = node;
+	}
+	rcu_lock.release();
+
+	while(list) {
+		next = list->next;
+		list->object->release();
+		delete list;
+		list = next;
+		++count;
+	}
+	return count;
+}
+
 MappedPointer::Index::Index(LinkedObject **origin) :
 LinkedObject(origin)
 {
@@ -46,6 +46,10 @@
 #include <sys/filio.h>
 #endif
 
+#if defined(HAVE_SYS_SENDFILE_H)
+#include <sys/sendfile.h>
+#endif
+
 #if defined(HAVE_POLL) && defined(POLLRDNORM)
 #define USE_POLL
 #endif
@@ -54,6 +58,22 @@
 #define IP_MTU 14
 #endif
 
+#if defined(__linux__)
+#ifndef SOL_UDP
+#define SOL_UDP 17
+#endif
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+#ifndef UDP_GRO
+#define UDP_GRO 104
+#endif
+#endif
+
+#if defined(HAVE_RECVMMSG) || defined(HAVE_SENDMMSG)
+#define BATCH_LIMIT 64
+#endif
+
 #ifndef MSG_DONTWAIT
 #define MSG_DONTWAIT 0
 #endif
@@ -110,6 +130,7 @@ typedef uint8_t   bit_t;
 
 static int query_family = 0;
 static int v6only = 0;
+static Socket::resolver_t lookup = NULL;
 
 static void socket_mapping(int family, socket_t so)
 {
@@ -652,6 +673,266 @@ const cidr *cidr::container(const policy *policy, const struct sockaddr *s)
 }
 
 
+// each family has its own root in one array of nodes, and a node is
+// only made where a prefix ends or where prefixes part...
+class cidr::index::table
+{
+private:
+    __DELETE_COPY(table);
+
+public:
+    typedef struct {
+        bit_t key[16];
+        unsigned bits;
+        unsigned child[2];
+        const cidr *entry;
+    } node_t;
+
+    node_t *nodes;
+    unsigned count, limit;
+
+    table(const policy *list);
+    ~table();
+
+    unsigned alloc(const bit_t *key, unsigned bits, const cidr *entry);
+    void insert(unsigned root, const bit_t *key, unsigned bits, const cidr *entry);
+    const cidr *lookup(const struct sockaddr *address, bool longest) const;
+
+    static inline unsigned bit(const bit_t *key, unsigned pos) {
+        return (key[pos >> 3] >> (7 - (pos & 7))) & 1;
+    }
+
+    static unsigned common(const bit_t *a, const bit_t *b, unsigned bits);
+};
+
+unsigned cidr::index::table::common(const bit_t *a, const bit_t *b, unsigned bits)
+{
+    unsigned pos = 0;
+    while(pos + 8 <= bits && a[pos >> 3] == b[pos >> 3])
+        pos += 8;
+
+    while(pos < bits && bit(a, pos) == bit(b, pos))
+        ++pos;
+
+    return pos;
+}
+
+cidr::index::table::table(const policy *list)
+{
+    count = 2;
+    limit = 64;
+    nodes = (node_t *)::malloc(sizeof(node_t) * limit);
+    if(!nodes)
+        __THROW_ALLOC();
+
+    // node 0 is the ipv4 root and node 1 the ipv6 root...
+    memset(nodes, 0, sizeof(node_t) * 2);
+
+    // entries are indexed in policy order, so the first of equal
+    // prefixes is kept just as cidr::find would select...
+    linked_pointer<const cidr> cp = list;
+    while(cp) {
+        struct hostaddr_internet network = cp->getNetwork();
+        struct hostaddr_internet netmask = cp->getNetmask();
+        bit_t *key = NULL, *mask = NULL;
+        unsigned size = 0, root = 0;
+
+        switch(cp->getFamily()) {
+        case AF_INET:
+            key = (bit_t *)&network.ipv4;
+            mask = (bit_t *)&netmask.ipv4;
+            size = sizeof(struct in_addr);
+            break;
+#ifdef  AF_INET6
+        case AF_INET6:
+            key = (bit_t *)&network.ipv6;
+            mask = (bit_t *)&netmask.ipv6;
+            size = sizeof(struct in6_addr);
+            root = 1;
+            break;
+#endif
+        default:
+            break;
+        }
+
+        if(size) {
+            bitmask(key, mask, size);
+            insert(root, key, bitcount(mask, size), *cp);
+        }
+        cp.next();
+    }
+}
+
+cidr::index::table::~table()
+{
+    ::free(nodes);
+}
+
+unsigned cidr::index::table::alloc(const bit_t *key, unsigned bits, const cidr *entry)
+{
+    if(count >= limit) {
+        node_t *expand = (node_t *)::realloc(nodes, sizeof(node_t) * limit * 2);
+        if(!expand)
+            __THROW_ALLOC();
+        nodes = expand;
+        limit *= 2;
+    }
+
+    node_t *node = &nodes[count];
+    memset(node, 0, sizeof(node_t));
+    memcpy(node->key, key, (bits + 7) / 8);
+    if(bits & 7)
+        node->key[bits >> 3] &= (bit_t)(0xff << (8 - (bits & 7)));
+    node->bits = bits;
+    node->entry = entry;
+    return count++;
+}
+
+void cidr::index::table::insert(unsigned root, const bit_t *key, unsigned bits, const cidr *entry)
+{
+    unsigned pos = root;
+
+    for(;;) {
+        if(nodes[pos].bits == bits) {
+            if(!nodes[pos].entry)
+                nodes[pos].entry = entry;
+            return;
+        }
+
+        unsigned dir = bit(key, nodes[pos].bits);
+        unsigned next = nodes[pos].child[dir];
+        if(!next) {
+            unsigned leaf = alloc(key, bits, entry);
+            nodes[pos].child[dir] = leaf;
+            return;
+        }
+
+        unsigned span = nodes[next].bits;
+        if(bits < span)
+            span = bits;
+        unsigned same = common(nodes[next].key, key, span);
+        if(same == nodes[next].bits) {
+            pos = next;
+            continue;
+        }
+
+        // split the edge where the new prefix leaves it...
+        unsigned split = alloc(key, same, NULL);
+        nodes[split].child[bit(nodes[next].key, same)] = next;
+        nodes[pos].child[dir] = split;
+        if(same == bits)
+            nodes[split].entry = entry;
+        else {
+            unsigned leaf = alloc(key, bits, entry);
+            nodes[split].child[bit(key, same)] = leaf;
+        }
+        return;
+    }
+}
+
+const cidr *cidr::index::table::lookup(const struct sockaddr *s, bool longest) const
+{
+    const struct sockaddr_internet *addr = (const struct sockaddr_internet *)s;
+    const bit_t *key;
+    unsigned size, pos = 0;
+    const cidr *match = NULL;
+
+    switch(s->sa_family) {
+    case AF_INET:
+        key = (const bit_t *)&addr->ipv4.sin_addr;
+        size = 32;
+        break;
+#ifdef  AF_INET6
+    case AF_INET6:
+        key = (const bit_t *)&addr->ipv6.sin6_addr;
+        size = 128;
+        pos = 1;
+        break;
+#endif
+    default:
+        return match;
+    }
+
+    for(;;) {
+        const node_t *node = &nodes[pos];
+        if(common(node->key, key, node->bits) < node->bits)
+            break;
+        if(node->entry) {
+            match = node->entry;
+            if(!longest)
+                return match;
+        }
+        if(node->bits >= size)
+            break;
+        pos = node->child[bit(key, node->bits)];
+        if(!pos)
+            break;
+    }
+    return match;
+}
+
+cidr::index::index()
+{
+    current = NULL;
+    lock = new RWLock();
+}
+
+cidr::index::index(const policy *list)
+{
+    current = NULL;
+    lock = new RWLock();
+    update(list);
+}
+
+cidr::index::~index()
+{
+    delete current;
+    delete lock;
+}
+
+void cidr::index::update(const policy *list)
+{
+    table *prior, *compiled = NULL;
+
+    if(list)
+        compiled = new table(list);
+
+    lock->modify();
+    prior = current;
+    current = compiled;
+    lock->release();
+
+    delete prior;
+}
+
+const cidr *cidr::index::find(const struct sockaddr *s) const
+{
+    assert(s != NULL);
+
+    const cidr *member = NULL;
+
+    lock->access();
+    if(current) {
+        member = current->lookup(s, true);
+    }
+    lock->release();
+    return member;
+}
+
+const cidr *cidr::index::container(const struct sockaddr *s) const
+{
+    assert(s != NULL);
+
+    const cidr *member = NULL;
+
+    lock->access();
+    if(current) {
+        member = current->lookup(s, false);
+    }
+    lock->release();
+    return member;
+}
+
 bool cidr::is_member(const struct sockaddr *s) const
 {
     assert(s != NULL);
@@ -883,7 +1164,7 @@ Socket::address::address(int family, const char *host, const char *svc)
     list = NULL;
     memset(&hint, 0, sizeof(hint));
     hint.ai_family = family;
-    getaddrinfo(host, svc, &hint, &list);
+    resolve(host, svc, &hint, &list);
 }
 
 Socket::address::address(const in_addr& address, in_port_t port) : list(NULL)
@@ -953,6 +1234,22 @@ void Socket::release(struct addrinfo *list)
     }
 }
 
+void Socket::resolver(resolver_t handler)
+{
+    lookup = handler;
+}
+
+int Socket::resolve(const char *host, const char *svc, const struct addrinfo *hint, struct addrinfo **result)
+{
+    resolver_t handler = lookup;
+
+    *result = NULL;
+    if(handler)
+        return handler(host, svc, hint, result);
+
+    return getaddrinfo(host, svc, hint, result);
+}
+
 struct ::addrinfo *Socket::query(const char *hp, const char *svc, int type, int protocol)
 {
     assert(hp != NULL && *hp != 0);
@@ -1022,7 +1319,7 @@ struct ::addrinfo *Socket::query(const char *hp, const char *svc, int type, int
 #endif
 
     struct addrinfo *result = NULL;
-    getaddrinfo(host, svc, &hint, &result);
+    resolve(host, svc, &hint, &result);
     return result;
 }
 
@@ -1113,7 +1410,7 @@ proc:
         hint.ai_flags |= AI_V4MAPPED;
 #endif
 
-    getaddrinfo(host, svc, &hint, &list);
+    resolve(host, svc, &hint, &list);
 	strfree(addr);
 }
 
@@ -1583,10 +1880,12 @@ Socket::Socket(const Socket &s)
 #endif
     iowait = s.iowait;
     ioerr = 0;
+    input = NULL;
 }
 
 Socket::Socket()
 {
+    input = NULL;
     so = INVALID_SOCKET;
     iowait = Timer::inf;
     ioerr = 0;
@@ -1594,6 +1893,7 @@ Socket::Socket()
 
 Socket::Socket(const socket_t s)
 {
+    input = NULL;
     so = s;
     iowait = Timer::inf;
     ioerr = 0;
@@ -1606,6 +1906,10 @@ Socket::Socket(const struct addrinfo *addr)
 #endif
     assert(addr != NULL);
 
+    input = NULL;
+    iowait = Timer::inf;
+    ioerr = 0;
+
     while(addr) {
         so = ::socket(addr->ai_family, addr->ai_socktype, addr->ai_protocol);
         socket_mapping(addr->ai_family, so);
@@ -1622,6 +1926,7 @@ Socket::Socket(const struct addrinfo *addr)
 
 Socket::Socket(int family, int type, int protocol)
 {
+    input = NULL;
     so = create(family, type, protocol);
     iowait = Timer::inf;
     ioerr = 0;
@@ -1629,6 +1934,7 @@ Socket::Socket(int family, int type, int protocol)
 
 Socket::Socket(const char *iface, const char *port, int family, int type, int protocol)
 {
+    input = NULL;
     assert(iface != NULL && *iface != 0);
     assert(port != NULL && *port != 0);
 
@@ -1703,7 +2009,7 @@ socket_t Socket::create(const char *iface, const char *port, int family, int typ
     if(iface && !strcmp(iface, "*"))
         iface = NULL;
 
-    getaddrinfo(iface, port, &hint, &res);
+    resolve(iface, port, &hint, &res);
     if(res == NULL)
         return INVALID_SOCKET;
 
@@ -1726,6 +2032,10 @@ socket_t Socket::create(const char *iface, const char *port, int family, int typ
 Socket::~Socket()
 {
     release();
+    if(input) {
+        delete input;
+        input = NULL;
+    }
 }
 
 socket_t Socket::create(int family, int type, int protocol)
@@ -1772,6 +2082,8 @@ void Socket::release(void)
 #endif
         so = INVALID_SOCKET;
     }
+    if(input)
+        input->clear();
     iowait = Timer::inf;
     ioerr = 0;
 }
@@ -1901,6 +2213,16 @@ size_t Socket::readfrom(void *data, size_t len, struct sockaddr_storage *from)
     assert(data != NULL);
     assert(len > 0);
 
+    // buffered stream input has no peer address to report...
+    if(input && (input->pending() || !from)) {
+        ssize_t result = input->read(so, data, len, iowait);
+        if(result < 0) {
+            ioerr = Socket::error();
+            return 0;
+        }
+        return (size_t)result;
+    }
+
     // wait for input by timer if possible...
     if(iowait && iowait != Timer::inf && !Socket::wait(so, iowait))
         return 0;
@@ -1945,6 +2267,264 @@ ssize_t Socket::sendto(socket_t so, const void *data, size_t dlen, int flags, co
     return ::sendto(so, (caddr_t)data, (socksize_t)dlen, MSG_NOSIGNAL | flags, dest, (socklen_t)slen);
 }
 
+ssize_t Socket::recvbatch(socket_t so, datagram_t *list, unsigned count, int flags)
+{
+    assert(list != NULL);
+
+    unsigned total = 0;
+    unsigned pos;
+
+#ifdef  HAVE_RECVMMSG
+    struct mmsghdr msgs[BATCH_LIMIT];
+    struct iovec iov[BATCH_LIMIT];
+    union {
+        char buf[CMSG_SPACE(sizeof(int))];
+        struct cmsghdr align;
+    } control[BATCH_LIMIT];
+
+    while(total < count) {
+        unsigned chunk = count - total;
+        if(chunk > BATCH_LIMIT)
+            chunk = BATCH_LIMIT;
+
+        // only the first datagram may be waited for, and without
+        // MSG_WAITFORONE it is waited for alone...
+        int mode = flags | MSG_DONTWAIT;
+        if(!total) {
+#ifdef  MSG_WAITFORONE
+            mode = flags | MSG_WAITFORONE;
+#else
+            mode = flags;
+            chunk = 1;
+#endif
+        }
+
+        memset(msgs, 0, sizeof(struct mmsghdr) * chunk);
+        for(pos = 0; pos < chunk; ++pos) {
+            datagram_t *dg = &list[total + pos];
+            iov[pos].iov_base = dg->data;
+            iov[pos].iov_len = dg->size;
+            msgs[pos].msg_hdr.msg_iov = &iov[pos];
+            msgs[pos].msg_hdr.msg_iovlen = 1;
+            msgs[pos].msg_hdr.msg_name = dg->address;
+            if(dg->address)
+                msgs[pos].msg_hdr.msg_namelen = sizeof(struct sockaddr_storage);
+            msgs[pos].msg_hdr.msg_control = control[pos].buf;
+            msgs[pos].msg_hdr.msg_controllen = sizeof(control[pos].buf);
+        }
+
+        int result = ::recvmmsg(so, msgs, chunk, mode, NULL);
+        if(result < 0) {
+            if(total)
+                break;
+            return -1;
+        }
+
+        for(pos = 0; pos < (unsigned)result; ++pos) {
+            datagram_t *dg = &list[total + pos];
+            dg->length = msgs[pos].msg_len;
+            dg->segment = 0;
+#ifdef  __linux__
+            struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msgs[pos].msg_hdr);
+            while(cmsg) {
+                if(cmsg->cmsg_level == SOL_UDP && cmsg->cmsg_type == UDP_GRO) {
+                    int segment;
+                    memcpy(&segment, CMSG_DATA(cmsg), sizeof(segment));
+                    dg->segment = (size_t)segment;
+                }
+                cmsg = CMSG_NXTHDR(&msgs[pos].msg_hdr, cmsg);
+            }
+#endif
+        }
+
+        total += (unsigned)result;
+        if((unsigned)result < chunk)
+            break;
+    }
+#else
+    for(pos = 0; pos < count; ++pos) {
+        datagram_t *dg = &list[pos];
+
+        // only the first datagram may be waited for...
+        if(pos && !pending(so))
+            break;
+
+        socklen_t slen = sizeof(struct sockaddr_storage);
+        ssize_t result = ::recvfrom(so, (caddr_t)dg->data, (socksize_t)dg->size, flags, (struct sockaddr *)dg->address, dg->address ? &slen : NULL);
+        if(result < 0) {
+            if(total)
+                break;
+            return -1;
+        }
+
+        dg->length = (size_t)result;
+        dg->segment = 0;
+        ++total;
+    }
+#endif
+    return (ssize_t)total;
+}
+
+ssize_t Socket::sendbatch(socket_t so, const datagram_t *list, unsigned count, int flags)
+{
+    assert(list != NULL);
+
+    unsigned total = 0;
+    unsigned pos;
+
+#ifdef  HAVE_SENDMMSG
+    struct mmsghdr msgs[BATCH_LIMIT];
+    struct iovec iov[BATCH_LIMIT];
+#ifdef  __linux__
+    union {
+        char buf[CMSG_SPACE(sizeof(uint16_t))];
+        struct cmsghdr align;
+    } control[BATCH_LIMIT];
+#endif
+
+    while(total < count) {
+        unsigned chunk = count - total;
+        if(chunk > BATCH_LIMIT)
+            chunk = BATCH_LIMIT;
+
+        memset(msgs, 0, sizeof(struct mmsghdr) * chunk);
+        for(pos = 0; pos < chunk; ++pos) {
+            const datagram_t *dg = &list[total + pos];
+            iov[pos].iov_base = dg->data;
+            iov[pos].iov_len = dg->size;
+            msgs[pos].msg_hdr.msg_iov = &iov[pos];
+            msgs[pos].msg_hdr.msg_iovlen = 1;
+            if(dg->address) {
+                msgs[pos].msg_hdr.msg_name = dg->address;
+                msgs[pos].msg_hdr.msg_namelen = len((const struct sockaddr *)dg->address);
+            }
+#ifdef  __linux__
+            // have the kernel split the data into segment sized datagrams...
+            if(dg->segment && dg->segment < dg->size) {
+                uint16_t segment = (uint16_t)dg->segment;
+                memset(&control[pos], 0, sizeof(control[pos]));
+                msgs[pos].msg_hdr.msg_control = control[pos].buf;
+                msgs[pos].msg_hdr.msg_controllen = sizeof(control[pos].buf);
+                struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msgs[pos].msg_hdr);
+                cmsg->cmsg_level = SOL_UDP;
+                cmsg->cmsg_type = UDP_SEGMENT;
+                cmsg->cmsg_len = CMSG_LEN(sizeof(segment));
+                memcpy(CMSG_DATA(cmsg), &segment, sizeof(segment));
+            }
+#endif
+        }
+
+        int result = ::sendmmsg(so, msgs, chunk, MSG_NOSIGNAL | flags);
+        if(result < 0) {
+            if(total)
+                break;
+            return -1;
+        }
+
+        total += (unsigned)result;
+        if((unsigned)result < chunk)
+            break;
+    }
+#else
+    for(pos = 0; pos < count; ++pos) {
+        const datagram_t *dg = &list[pos];
+        const struct sockaddr *dest = (const struct sockaddr *)dg->address;
+        socklen_t slen = 0;
+        if(dest)
+            slen = len(dest);
+
+        // without segment offload each segment is sent on its own...
+        size_t segment = dg->size;
+        if(dg->segment && dg->segment < dg->size)
+            segment = dg->segment;
+
+        size_t offset = 0;
+        do {
+            size_t part = dg->size - offset;
+            if(part > segment)
+                part = segment;
+            ssize_t result = ::sendto(so, (caddr_t)((const char *)dg->data + offset), (socksize_t)part, MSG_NOSIGNAL | flags, dest, slen);
+            if(result < 0) {
+                if(total)
+                    return (ssize_t)total;
+                return -1;
+            }
+            offset += part;
+        } while(offset < dg->size);
+        ++total;
+    }
+#endif
+    return (ssize_t)total;
+}
+
+ssize_t Socket::sendfile(socket_t so, fd_t fd, off_t offset, size_t size)
+{
+    size_t total = 0;
+
+#if defined(HAVE_SYS_SENDFILE_H)
+    while(total < size) {
+        ssize_t result = ::sendfile(so, fd, offset < 0 ? NULL : &offset, size - total);
+        if(result < 0 && errno == EINTR)
+            continue;
+        // a file the kernel cannot send from is read instead...
+        if(result < 0 && !total && (errno == EINVAL || errno == ENOSYS))
+            break;
+        if(result < 0)
+            return total ? (ssize_t)total : -1;
+        if(!result)
+            return (ssize_t)total;
+        total += (size_t)result;
+    }
+    if(total)
+        return (ssize_t)total;
+#endif
+
+    char buf[16384];
+    while(total < size) {
+        size_t count = size - total;
+        if(count > sizeof(buf))
+            count = sizeof(buf);
+
+#ifdef  _MSWINDOWS_
+        DWORD got = 0;
+        OVERLAPPED at;
+        memset(&at, 0, sizeof(at));
+        at.Offset = (DWORD)offset;
+        at.OffsetHigh = (DWORD)((uint64_t)offset >> 32);
+        ssize_t result = -1;
+        if(ReadFile(fd, buf, (DWORD)count, &got, offset < 0 ? NULL : &at))
+            result = (ssize_t)got;
+#else
+        ssize_t result;
+        if(offset < 0)
+            result = ::read(fd, buf, count);
+        else
+            result = ::pread(fd, buf, count, offset);
+        if(result < 0 && errno == EINTR)
+            continue;
+#endif
+        if(result < 0)
+            return total ? (ssize_t)total : -1;
+        if(!result)
+            break;
+
+        if(offset >= 0)
+            offset += result;
+
+        size_t pos = 0;
+        while(pos < (size_t)result) {
+            ssize_t sent = ::send(so, buf + pos, (socksize_t)(result - pos), MSG_NOSIGNAL);
+            if(sent < 0 && Socket::error() == EINTR)
+                continue;
+            if(sent < 0)
+                return total ? (ssize_t)total : -1;
+            pos += (size_t)sent;
+            total += (size_t)sent;
+        }
+    }
+    return (ssize_t)total;
+}
+
 size_t Socket::writes(const char *str)
 {
     if(!str)
@@ -1956,6 +2536,193 @@ size_t Socket::writes(const char *str)
     return writeto(str, strlen(str), NULL);
 }
 
+Socket::buffer::buffer(size_t bufsize)
+{
+    if(bufsize < 2)
+        bufsize = 2;
+
+    // one more byte so a line at the end can always be null terminated...
+    data = (char *)::malloc(bufsize + 1);
+    if(!data)
+        __THROW_ALLOC();
+
+    size = bufsize;
+    head = tail = scan = 0;
+}
+
+Socket::buffer::~buffer()
+{
+    if(data) {
+        ::free(data);
+        data = NULL;
+    }
+}
+
+ssize_t Socket::buffer::fill(socket_t so)
+{
+    if(head == tail)
+        head = tail = scan = 0;
+    else if(tail == size && head) {
+        memmove(data, data + head, tail - head);
+        tail -= head;
+        scan -= head;
+        head = 0;
+    }
+
+    if(tail == size)
+        return 0;
+
+    ssize_t result = ::recv(so, data + tail, (socksize_t)(size - tail), 0);
+    if(result > 0)
+        tail += (size_t)result;
+    return result;
+}
+
+ssize_t Socket::buffer::locate(socket_t so, size_t limit, timeout_t timeout, bool& found)
+{
+    size_t end;
+    ssize_t result;
+    char *nl;
+
+    found = false;
+    if(scan < head)
+        scan = head;
+
+    for(;;) {
+        end = tail;
+        if(end - head > limit)
+            end = head + limit;
+
+        if(scan < end) {
+            nl = (char *)memchr(data + scan, '\n', end - scan);
+            if(nl) {
+                found = true;
+                return (ssize_t)(nl - (data + head) + 1);
+            }
+            scan = end;
+        }
+
+        if(tail - head >= limit)
+            return (ssize_t)limit;
+
+        // a partial line stays buffered if we time out waiting for more...
+        if(timeout && !Socket::wait(so, timeout))
+            return 0;
+
+        result = fill(so);
+        if(result < 0)
+            return -1;
+
+        if(result == 0)
+            return (ssize_t)(tail - head);
+    }
+}
+
+ssize_t Socket::buffer::read(socket_t so, void *buf, size_t len, timeout_t timeout)
+{
+    assert(buf != NULL);
+    assert(len > 0);
+
+    if(head == tail) {
+        if(timeout && !Socket::wait(so, timeout))
+            return 0;
+
+        if(len >= size)
+            return ::recv(so, (caddr_t)buf, (socksize_t)len, 0);
+
+        ssize_t result = fill(so);
+        if(result < 1)
+            return result;
+    }
+
+    if(len > tail - head)
+        len = tail - head;
+
+    memcpy(buf, data + head, len);
+    head += len;
+    return (ssize_t)len;
+}
+
+ssize_t Socket::buffer::readline(socket_t so, char *line, size_t max, timeout_t timeout)
+{
+    assert(line != NULL);
+    assert(max > 0);
+
+    bool found;
+    size_t len;
+    char *start;
+
+    if(max < 1)
+        return -1;
+
+    line[0] = 0;
+    ssize_t result = locate(so, max - 1, timeout, found);
+    if(result < 1)
+        return result;
+
+    start = data + head;
+    len = (size_t)result;
+    head += len;
+
+    // crlf is counted as one byte, as the unbuffered readline does...
+    if(found) {
+        --len;
+        if(len && start[len - 1] == '\r') {
+            --len;
+            --result;
+        }
+    }
+
+    memcpy(line, start, len);
+    line[len] = 0;
+    return result;
+}
+
+const char *Socket::buffer::getline(socket_t so, size_t& len, timeout_t timeout)
+{
+    bool found;
+    char *line;
+
+    len = 0;
+    ssize_t result = locate(so, size, timeout, found);
+    if(result < 1)
+        return NULL;
+
+    line = data + head;
+    len = (size_t)result;
+    head += len;
+    if(found) {
+        --len;
+        if(len && line[len - 1] == '\r')
+            --len;
+    }
+    line[len] = 0;
+    return line;
+}
+
+bool Socket::buffering(size_t size)
+{
+    if(input) {
+        delete input;
+        input = NULL;
+    }
+
+    if(!size)
+        return true;
+
+    input = new buffer(size);
+    return true;
+}
+
+const char *Socket::getline(size_t& len)
+{
+    len = 0;
+    if(!input)
+        buffering();
+
+    return input->getline(so, len, iowait);
+}
+
 size_t Socket::readline(char *data, size_t max)
 {
     assert(data != NULL);
@@ -1963,7 +2730,11 @@ size_t Socket::readline(char *data, size_t max)
 
     *data = 0;
 
-    ssize_t result = Socket::readline(so, data, max, iowait);
+    ssize_t result;
+    if(input)
+        result = input->readline(so, data, max, iowait);
+    else
+        result = Socket::readline(so, data, max, iowait);
     if(result < 0) {
         ioerr = Socket::error();
         return 0;
@@ -1976,7 +2747,11 @@ size_t Socket::readline(String& s)
     if(!s.data())
         return 0;
 
-    ssize_t result = Socket::readline(so, s.data(), s.size() + 1, iowait);
+    ssize_t result;
+    if(input)
+        result = input->readline(so, s.data(), s.size() + 1, iowait);
+    else
+        result = Socket::readline(so, s.data(), s.size() + 1, iowait);
     if(result < 0) {
         ioerr = Socket::error();
         s.clear();
@@ -1992,7 +2767,11 @@ stringref_t Socket::readline(size_t size)
 	if(!buf)
 		return stringref_t();
 
-	ssize_t result = Socket::readline(so, buf->get(), buf->max() + 1, iowait);
+	ssize_t result;
+	if(input)
+		result = input->readline(so, buf->get(), buf->max() + 1, iowait);
+	else
+		result = Socket::readline(so, buf->get(), buf->max() + 1, iowait);
 	if(result < 0)
 		return stringref_t();
 
@@ -2176,6 +2955,24 @@ int Socket::broadcast(socket_t so, bool enable)
     return err;
 }
 
+int Socket::coalesce(socket_t so, bool enable)
+{
+    if(so == INVALID_SOCKET)
+        return EBADF;
+#if defined(__linux__)
+    int opt = (enable ? 1 : 0);
+    if(!::setsockopt(so, SOL_UDP, UDP_GRO,
+              (char *)&opt, (socklen_t)sizeof(opt)))
+        return 0;
+#else
+    return ENOSYS;
+#endif
+    int err = Socket::error();
+    if(!err)
+        err = EIO;
+    return err;
+}
+
 int Socket::nodelay(socket_t so)
 {
     if(so == INVALID_SOCKET)
@@ -2664,6 +3461,9 @@ socket_t Socket::acceptfrom(socket_t so, struct sockaddr_storage *addr)
 
 bool Socket::wait(timeout_t timeout) const
 {
+    if(input && input->pending())
+        return true;
+
     return wait(so, timeout);
 }
 
@@ -2966,7 +3766,7 @@ socklen_t Socket::query(socket_t so, struct sockaddr_storage *sa, const char *ho
     if(!hinting(so, &hint) || !svc)
         return 0;
 
-    if(getaddrinfo(host, svc, &hint, &res) || !res)
+    if(resolve(host, svc, &hint, &res) || !res)
         goto exit;
 
     memcpy(sa, res->ai_addr, res->ai_addrlen);
@@ -350,6 +350,25 @@ void tcpstream::close(void)
     Socket::disconnect(so);
 }
 
+ssize_t tcpstream::sendfile(fd_t file, off_t offset, size_t size)
+{
+    if(so == INVALID_SOCKET)
+        return -1;
+
+    // a partial write rebuffers the remainder, so flush until empty...
+    while(bufsize > 1 && pbase() && pptr() > pbase()) {
+        ssize_t pending = (ssize_t)(pptr() - pbase());
+        overflow(EOF);
+        if(!bufsize || (ssize_t)(pptr() - pbase()) >= pending)
+            return -1;
+    }
+
+    ssize_t result = Socket::sendfile(so, file, offset, size);
+    if(result < 0)
+        clear(ios::failbit | rdstate());
+    return result;
+}
+
 void tcpstream::allocate(unsigned mss)
 {
     unsigned size = mss;
@@ -27,8 +27,417 @@
 #endif
 #include <limits.h>
 
+// vector kernels are built for x86 with compilers that can target an
+// instruction set per function, and are picked by what the processor
+// running us supports...
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__clang__) || __GNUC_PREREQ__(4, 9))
+#include <immintrin.h>
+#define STRING_VECTORS
+#endif
+
 namespace ucommon {
 
+typedef const char *(*search_t)(const char *text, size_t size, const char *key, size_t len, bool icase);
+typedef const char *(*scan_t)(const uint8_t *map, const char *text, size_t size, bool member, bool reverse);
+typedef size_t (*span_t)(const uint8_t *map, const char *text, bool member);
+
+// case insensitive searches fold ascii letters, which is what vector
+// compares can do...
+static inline unsigned char fold(unsigned char ch)
+{
+    return (ch >= 'A' && ch <= 'Z') ? (unsigned char)(ch + 32) : ch;
+}
+
+static inline bool letter(unsigned char ch)
+{
+    ch = fold(ch);
+    return ch >= 'a' && ch <= 'z';
+}
+
+static inline bool same(const char *s1, const char *s2, size_t len, bool icase)
+{
+    if(!icase)
+        return !memcmp(s1, s2, len);
+
+    while(len--) {
+        if(fold(*(s1++)) != fold(*(s2++)))
+            return false;
+    }
+    return true;
+}
+
+static inline bool member(const uint8_t *map, char ch)
+{
+    unsigned char code = (unsigned char)ch;
+    return ((map[((code >> 3) & 0x10) | (code & 0x0f)] >> ((code >> 4) & 0x07)) & 1) != 0;
+}
+
+static const char *search_scalar(const char *text, size_t size, const char *key, size_t len, bool icase)
+{
+    const char *last = text + size - len;
+    unsigned char first = fold(*key);
+
+    if(!icase) {
+        while(text <= last) {
+            text = (const char *)memchr(text, *key, (size_t)(last - text) + 1);
+            if(!text)
+                return NULL;
+            if(!memcmp(text + 1, key + 1, len - 1))
+                return text;
+            ++text;
+        }
+        return NULL;
+    }
+
+    while(text <= last) {
+        if(fold(*text) == first && same(text + 1, key + 1, len - 1, true))
+            return text;
+        ++text;
+    }
+    return NULL;
+}
+
+static const char *scan_scalar(const uint8_t *map, const char *text, size_t size, bool want, bool reverse)
+{
+    if(reverse) {
+        while(size--) {
+            if(member(map, text[size]) == want)
+                return text + size;
+        }
+        return NULL;
+    }
+
+    for(size_t pos = 0; pos < size; ++pos) {
+        if(member(map, text[pos]) == want)
+            return text + pos;
+    }
+    return NULL;
+}
+
+static size_t span_scalar(const uint8_t *map, const char *text, bool want)
+{
+    size_t pos = 0;
+
+    while(text[pos] && member(map, text[pos]) == want)
+        ++pos;
+    return pos;
+}
+
+#ifdef  STRING_VECTORS
+
+// substrings are found by comparing the first and last character of the
+// key at every position of a block at once, and comparing the whole key
+// only where both match.  Letters are compared with the case bit set when
+// insensitive, which passes some other characters too, but the whole key
+// compare weeds those out.
+
+__attribute__((target("sse2")))
+static const char *search_sse2(const char *text, size_t size, const char *key, size_t len, bool icase)
+{
+    unsigned char first = (unsigned char)key[0], last = (unsigned char)key[len - 1];
+    char fcase = (icase && letter(first)) ? 0x20 : 0;
+    char lcase = (icase && letter(last)) ? 0x20 : 0;
+    const __m128i fmask = _mm_set1_epi8(fcase), lmask = _mm_set1_epi8(lcase);
+    const __m128i fchar = _mm_set1_epi8((char)(first | fcase)), lchar = _mm_set1_epi8((char)(last | lcase));
+    size_t pos = 0;
+
+    while(pos + len + 15 <= size) {
+        __m128i head = _mm_loadu_si128((const __m128i *)(text + pos));
+        __m128i tail = _mm_loadu_si128((const __m128i *)(text + pos + len - 1));
+        unsigned mask = (unsigned)_mm_movemask_epi8(_mm_and_si128(
+            _mm_cmpeq_epi8(_mm_or_si128(head, fmask), fchar),
+            _mm_cmpeq_epi8(_mm_or_si128(tail, lmask), lchar)));
+        while(mask) {
+            unsigned bit = (unsigned)__builtin_ctz(mask);
+            if(same(text + pos + bit, key, len, icase))
+                return text + pos + bit;
+            mask &= mask - 1;
+        }
+        pos += 16;
+    }
+    return search_scalar(text + pos, size - pos, key, len, icase);
+}
+
+__attribute__((target("avx2")))
+static const char *search_avx2(const char *text, size_t size, const char *key, size_t len, bool icase)
+{
+    unsigned char first = (unsigned char)key[0], last = (unsigned char)key[len - 1];
+    char fcase = (icase && letter(first)) ? 0x20 : 0;
+    char lcase = (icase && letter(last)) ? 0x20 : 0;
+    const __m256i fmask = _mm256_set1_epi8(fcase), lmask = _mm256_set1_epi8(lcase);
+    const __m256i fchar = _mm256_set1_epi8((char)(first | fcase)), lchar = _mm256_set1_epi8((char)(last | lcase));
+    size_t pos = 0;
+
+    // blocks are tested in pairs, since most of them have no candidates...
+    while(pos + len + 63 <= size) {
+        __m256i h1 = _mm256_loadu_si256((const __m256i *)(text + pos));
+        __m256i h2 = _mm256_loadu_si256((const __m256i *)(text + pos + 32));
+        __m256i t1 = _mm256_loadu_si256((const __m256i *)(text + pos + len - 1));
+        __m256i t2 = _mm256_loadu_si256((const __m256i *)(text + pos + len + 31));
+        __m256i m1 = _mm256_and_si256(
+            _mm256_cmpeq_epi8(_mm256_or_si256(h1, fmask), fchar),
+            _mm256_cmpeq_epi8(_mm256_or_si256(t1, lmask), lchar));
+        __m256i m2 = _mm256_and_si256(
+            _mm256_cmpeq_epi8(_mm256_or_si256(h2, fmask), fchar),
+            _mm256_cmpeq_epi8(_mm256_or_si256(t2, lmask), lchar));
+        if(!_mm256_testz_si256(_mm256_or_si256(m1, m2), _mm256_or_si256(m1, m2)))
+            break;
+        pos += 64;
+    }
+
+    while(pos + len + 31 <= size) {
+        __m256i head = _mm256_loadu_si256((const __m256i *)(text + pos));
+        __m256i tail = _mm256_loadu_si256((const __m256i *)(text + pos + len - 1));
+        unsigned mask = (unsigned)_mm256_movemask_epi8(_mm256_and_si256(
+            _mm256_cmpeq_epi8(_mm256_or_si256(head, fmask), fchar),
+            _mm256_cmpeq_epi8(_mm256_or_si256(tail, lmask), lchar)));
+        while(mask) {
+            unsigned bit = (unsigned)__builtin_ctz(mask);
+            if(same(text + pos + bit, key, len, icase))
+                return text + pos + bit;
+            mask &= mask - 1;
+        }
+        pos += 32;
+    }
+    return search_sse2(text + pos, size - pos, key, len, icase);
+}
+
+// set members are looked up with byte shuffles.  The low half of each
+// character picks a row of the table, from the first half of the table for
+// characters below 128 and the second half for the rest, since a shuffle
+// gives 0 for an index with the top bit set.  The high half of the
+// character then picks the bit of that row.
+
+__attribute__((target("ssse3")))
+static inline unsigned members_ssse3(__m128i text, __m128i lower, __m128i upper)
+{
+    const __m128i bits = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+    const __m128i index = _mm_set1_epi8((char)0x8f);
+    const __m128i nibble = _mm_set1_epi8(0x0f);
+    __m128i row = _mm_or_si128(
+        _mm_shuffle_epi8(lower, _mm_and_si128(text, index)),
+        _mm_shuffle_epi8(upper, _mm_and_si128(_mm_xor_si128(text, _mm_set1_epi8((char)0x80)), index)));
+    __m128i bit = _mm_shuffle_epi8(bits, _mm_and_si128(_mm_srli_epi16(text, 4), nibble));
+    return (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(row, bit), bit));
+}
+
+__attribute__((target("avx2")))
+static inline unsigned members_avx2(__m256i text, __m256i lower, __m256i upper)
+{
+    const __m256i bits = _mm256_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128,
+        1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+    const __m256i index = _mm256_set1_epi8((char)0x8f);
+    const __m256i nibble = _mm256_set1_epi8(0x0f);
+    __m256i row = _mm256_or_si256(
+        _mm256_shuffle_epi8(lower, _mm256_and_si256(text, index)),
+        _mm256_shuffle_epi8(upper, _mm256_and_si256(_mm256_xor_si256(text, _mm256_set1_epi8((char)0x80)), index)));
+    __m256i bit = _mm256_shuffle_epi8(bits, _mm256_and_si256(_mm256_srli_epi16(text, 4), nibble));
+    return (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_and_si256(row, bit), bit));
+}
+
+__attribute__((target("ssse3")))
+static const char *scan_ssse3(const uint8_t *map, const char *text, size_t size, bool want, bool reverse)
+{
+    const __m128i lower = _mm_loadu_si128((const __m128i *)map);
+    const __m128i upper = _mm_loadu_si128((const __m128i *)(map + 16));
+    unsigned flip = want ? 0 : 0xffff, mask;
+
+    if(reverse) {
+        while(size >= 16) {
+            size -= 16;
+            mask = members_ssse3(_mm_loadu_si128((const __m128i *)(text + size)), lower, upper) ^ flip;
+            if(mask)
+                return text + size + 31 - __builtin_clz(mask);
+        }
+        return scan_scalar(map, text, size, want, true);
+    }
+
+    size_t pos = 0;
+    while(pos + 16 <= size) {
+        mask = members_ssse3(_mm_loadu_si128((const __m128i *)(text + pos)), lower, upper) ^ flip;
+        if(mask)
+            return text + pos + __builtin_ctz(mask);
+        pos += 16;
+    }
+    return scan_scalar(map, text + pos, size - pos, want, false);
+}
+
+__attribute__((target("avx2")))
+static const char *scan_avx2(const uint8_t *map, const char *text, size_t size, bool want, bool reverse)
+{
+    const __m256i lower = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)map));
+    const __m256i upper = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)(map + 16)));
+    unsigned flip = want ? 0 : 0xffffffff, mask;
+
+    if(reverse) {
+        while(size >= 32) {
+            size -= 32;
+            mask = members_avx2(_mm256_loadu_si256((const __m256i *)(text + size)), lower, upper) ^ flip;
+            if(mask)
+                return text + size + 31 - __builtin_clz(mask);
+        }
+        return scan_scalar(map, text, size, want, true);
+    }
+
+    size_t pos = 0;
+    while(pos + 32 <= size) {
+        mask = members_avx2(_mm256_loadu_si256((const __m256i *)(text + pos)), lower, upper) ^ flip;
+        if(mask)
+            return text + pos + __builtin_ctz(mask);
+        pos += 32;
+    }
+    return scan_scalar(map, text + pos, size - pos, want, false);
+}
+
+// null terminated text is read in aligned blocks, which cannot cross into
+// a page past the end of the text, though they may read past it within
+// the page; that is why these are not checked by address sanitizers.
+
+__attribute__((target("ssse3"), no_sanitize_address))
+static size_t span_ssse3(const uint8_t *map, const char *text, bool want)
+{
+    const __m128i lower = _mm_loadu_si128((const __m128i *)map);
+    const __m128i upper = _mm_loadu_si128((const __m128i *)(map + 16));
+    const __m128i zero = _mm_setzero_si128();
+    unsigned skew = (unsigned)((uintptr_t)text & 15);
+    const char *block = text - skew;
+    unsigned flip = want ? 0xffff : 0, stop;
+
+    for(;;) {
+        __m128i chars = _mm_load_si128((const __m128i *)block);
+        stop = (members_ssse3(chars, lower, upper) ^ flip) | (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(chars, zero));
+        stop &= 0xffffu << skew;
+        if(stop)
+            return (size_t)(block + __builtin_ctz(stop) - text);
+        block += 16;
+        skew = 0;
+    }
+}
+
+__attribute__((target("avx2"), no_sanitize_address))
+static size_t span_avx2(const uint8_t *map, const char *text, bool want)
+{
+    const __m256i lower = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)map));
+    const __m256i upper = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)(map + 16)));
+    const __m256i zero = _mm256_setzero_si256();
+    unsigned skew = (unsigned)((uintptr_t)text & 31);
+    const char *block = text - skew;
+    unsigned flip = want ? 0xffffffff : 0, stop;
+
+    for(;;) {
+        __m256i chars = _mm256_load_si256((const __m256i *)block);
+        stop = (members_avx2(chars, lower, upper) ^ flip) | (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(chars, zero));
+        stop &= 0xffffffffu << skew;
+        if(stop)
+            return (size_t)(block + __builtin_ctz(stop) - text);
+        block += 32;
+        skew = 0;
+    }
+}
+
+#endif
+
+// kernels are picked for the processor once, on first use, and the
+// choice is published to every thread by the static initialization...
+
+typedef struct {
+    search_t search;
+    scan_t scan;
+    span_t span;
+} kernels_t;
+
+static kernels_t select_kernels(void)
+{
+    kernels_t chosen;
+
+    chosen.search = &search_scalar;
+    chosen.scan = &scan_scalar;
+    chosen.span = &span_scalar;
+
+#ifdef  STRING_VECTORS
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("sse2"))
+        chosen.search = &search_sse2;
+    if(__builtin_cpu_supports("ssse3")) {
+        chosen.scan = &scan_ssse3;
+        chosen.span = &span_ssse3;
+    }
+    if(__builtin_cpu_supports("avx2")) {
+        chosen.search = &search_avx2;
+        chosen.scan = &scan_avx2;
+        chosen.span = &span_avx2;
+    }
+#endif
+
+    return chosen;
+}
+
+static const kernels_t& kernels(void)
+{
+    static const kernels_t chosen = select_kernels();
+    return chosen;
+}
+
+String::charset::charset(const char *list)
+{
+    unsigned char code;
+
+    memset(map, 0, sizeof(map));
+    while(list && *list) {
+        code = (unsigned char)*(list++);
+        map[((code >> 3) & 0x10) | (code & 0x0f)] |= (uint8_t)(1 << ((code >> 4) & 0x07));
+    }
+}
+
+const char *String::charset::find(const char *text, size_t size) const
+{
+    return kernels().scan(map, text, size, true, false);
+}
+
+const char *String::charset::skip(const char *text, size_t size) const
+{
+    return kernels().scan(map, text, size, false, false);
+}
+
+const char *String::charset::rfind(const char *text, size_t size) const
+{
+    return kernels().scan(map, text, size, true, true);
+}
+
+const char *String::charset::rskip(const char *text, size_t size) const
+{
+    return kernels().scan(map, text, size, false, true);
+}
+
+size_t String::charset::span(const char *text) const
+{
+    return kernels().span(map, text, true);
+}
+
+size_t String::charset::cspan(const char *text) const
+{
+    return kernels().span(map, text, false);
+}
+
+const char *String::search(const char *text, size_t size, const char *substring, size_t length, unsigned flags)
+{
+    bool icase = ((flags & 0x01) == INSENSITIVE);
+
+    if(!text || !substring)
+        return NULL;
+
+    if(!length)
+        return text;
+
+    if(length > size)
+        return NULL;
+
+    if(length == 1 && !icase)
+        return (const char *)memchr(text, *substring, size);
+
+    return kernels().search(text, size, substring, length, icase);
+}
+
 String::cstring::cstring(size_t size) :
 CountedObject()
 {
@@ -369,12 +778,7 @@ const char *String::skip(const char *clist, size_t offset) const
     if(!str || !clist || !*clist || !str->len || offset > str->len)
         return NULL;
 
-    while(offset < str->len) {
-        if(!strchr(clist, str->text[offset]))
-            return str->text + offset;
-        ++offset;
-    }
-    return NULL;
+    return charset(clist).skip(str->text + offset, str->len - offset);
 }
 
 const char *String::rskip(const char *clist, size_t offset) const
@@ -388,11 +792,7 @@ const char *String::rskip(const char *clist, size_t offset) const
     if(offset > str->len)
         offset = str->len;
 
-    while(offset--) {
-        if(!strchr(clist, str->text[offset]))
-            return str->text + offset;
-    }
-    return NULL;
+    return charset(clist).rskip(str->text, offset);
 }
 
 const char *String::rfind(const char *clist, size_t offset) const
@@ -406,16 +806,13 @@ const char *String::rfind(const char *clist, size_t offset) const
     if(offset > str->len)
         offset = str->len;
 
-    while(offset--) {
-        if(strchr(clist, str->text[offset]))
-            return str->text + offset;
-    }
-    return NULL;
+    return charset(clist).rfind(str->text, offset);
 }
 
 void String::chop(const char *clist)
 {
-    size_t offset;
+    size_t offset = 0;
+    const char *last;
 
     if(!str)
         return;
@@ -423,12 +820,9 @@ void String::chop(const char *clist)
     if(!str->len)
         return;
 
-    offset = str->len;
-    while(offset) {
-        if(!strchr(clist, str->text[offset - 1]))
-            break;
-        --offset;
-    }
+    last = charset(clist).rskip(str->text, str->len);
+    if(last)
+        offset = (size_t)(last - str->text) + 1;
 
     if(!offset) {
         clear();
@@ -450,16 +844,17 @@ void String::strip(const char *clist)
 
 void String::trim(const char *clist)
 {
-    unsigned offset = 0;
+    size_t offset;
+    const char *first;
 
     if(!str)
         return;
 
-    while(offset < str->len) {
-        if(!strchr(clist, str->text[offset]))
-            break;
-        ++offset;
-    }
+    first = charset(clist).skip(str->text, str->len);
+    if(first)
+        offset = (size_t)(first - str->text);
+    else
+        offset = str->len;
 
     if(!offset)
         return;
@@ -476,7 +871,7 @@ void String::trim(const char *clist)
 
 unsigned String::replace(const char *substring, const char *cp, unsigned flags)
 {
-    const char *result = "";
+    const char *result;
     unsigned count = 0;
     size_t cpl = 0;
 
@@ -490,29 +885,21 @@ unsigned String::replace(const char *substring, const char *cp, unsigned flags)
 
     size_t tcl = strlen(substring);
 
-    while(result) {
-        const char *text = str->text + offset;
-#if defined(_MSWINDOWS_)
-        if((flags & 0x01) == INSENSITIVE)
-            result = strstr(text, substring);
-#elif  defined(HAVE_STRICMP)
-        if((flags & 0x01) == INSENSITIVE)
-            result = stristr(text, substring);
-#else
-        if((flags & 0x01) == INSENSITIVE)
-            result = strcasestr(text, substring);
-#endif
-        else
-            result = strstr(text, substring);
+    if(!tcl)
+        return 0;
 
-        if(result) {
-            ++count;
-            offset = (size_t)(text - str->text);
-            cut(offset, tcl);
-            if(cpl) {
-                paste(offset, cp);
-                offset += cpl;
-            }
+    // the string may be copied by cut and paste, so we keep an offset...
+    while(offset < str->len) {
+        result = String::search(str->text + offset, str->len - offset, substring, tcl, flags);
+        if(!result)
+            break;
+
+        ++count;
+        offset = (size_t)(result - str->text);
+        cut(offset, tcl);
+        if(cpl) {
+            paste(offset, cp);
+            offset += cpl;
         }
     }
     return count;
@@ -526,25 +913,15 @@ const char *String::search(const char *substring, unsigned instance, unsigned fl
         return NULL;
 
     const char *text = str->text;
+    const char *end = str->text + str->len;
+    size_t tcl = strlen(substring);
 
     if(!instance)
         ++instance;
     while(instance-- && result) {
-#if defined(_MSWINDOWS_)
-        if((flags & 0x01) == INSENSITIVE)
-            result = strstr(text, substring);
-#elif  defined(HAVE_STRICMP)
-        if((flags & 0x01) == INSENSITIVE)
-            result = stristr(text, substring);
-#else
-        if((flags & 0x01) == INSENSITIVE)
-            result = strcasestr(text, substring);
-#endif
-        else
-            result = strstr(text, substring);
-
+        result = String::search(text, (size_t)(end - text), substring, tcl, flags);
         if(result)
-            text = result + strlen(result);
+            text = result + tcl;
     }
     return result;
 }
@@ -554,12 +931,7 @@ const char *String::find(const char *clist, size_t offset) const
     if(!str || !clist || !*clist || !str->len || offset > str->len)
         return NULL;
 
-    while(offset < str->len) {
-        if(strchr(clist, str->text[offset]))
-            return str->text + offset;
-        ++offset;
-    }
-    return NULL;
+    return charset(clist).find(str->text + offset, str->len - offset);
 }
 
 bool String::unquote(const char *clist)
@@ -1320,8 +1692,9 @@ char *String::token(char *text, char **token, const char *clist, const char *quo
         return NULL;
     }
 
-    while(**token && strchr(clist, **token))
-        ++*token;
+    charset separators(clist);
+
+    *token += separators.span(*token);
 
     result = *token;
 
@@ -1354,8 +1727,7 @@ char *String::token(char *text, char **token, const char *clist, const char *quo
         return result;
     }
 
-    while(**token && !strchr(clist, **token))
-        ++(*token);
+    *token += separators.cspan(*token);
 
     if(**token) {
         **token = 0;
@@ -1449,64 +1821,41 @@ size_t String::count(const char *cp)
     return strlen(cp);
 }
 
-const char *String::find(const char *str, const char *key, const char *delim)
+// keys in a delimited list are only matched at the start of an entry,
+// and must run to the end of it...
+static const char *field(const char *str, const char *key, const char *delim, unsigned flags)
 {
     size_t l1 = strlen(str);
     size_t l2 = strlen(key);
+    bool icase = ((flags & 0x01) == String::INSENSITIVE);
+    const char *end = str + l1;
 
-    if(!delim[0])
-        delim = NULL;
+    if(!delim || !delim[0])
+        return String::search(str, l1, key, l2, flags);
 
-    while(l1 >= l2) {
-        if(!strncmp(key, str, l2)) {
-            if(l1 == l2 || !delim || strchr(delim, str[l2]))
-                return str;
-        }
-        if(!delim) {
-            ++str;
-            --l1;
-            continue;
-        }
-        while(l1 >= l2 && !strchr(delim, *str)) {
-            ++str;
-            --l1;
-        }
-        while(l1 >= l2 && strchr(delim, *str)) {
-            ++str;
-            --l1;
-        }
+    String::charset separators(delim);
+
+    while((size_t)(end - str) >= l2) {
+        if(same(key, str, l2, icase) && (str + l2 == end || separators.test(str[l2])))
+            return str;
+
+        str = separators.find(str, (size_t)(end - str));
+        if(str)
+            str = separators.skip(str, (size_t)(end - str));
+        if(!str)
+            break;
     }
     return NULL;
 }
 
-const char *String::ifind(const char *str, const char *key, const char *delim)
+const char *String::find(const char *str, const char *key, const char *delim)
 {
-    size_t l1 = strlen(str);
-    size_t l2 = strlen(key);
-
-    if(!delim[0])
-        delim = NULL;
+    return field(str, key, delim, SENSITIVE);
+}
 
-    while(l1 >= l2) {
-        if(!strnicmp(key, str, l2)) {
-            if(l1 == l2 || !delim || strchr(delim, str[l2]))
-                return str;
-        }
-        if(!delim) {
-            ++str;
-            --l1;
-            continue;
-        }
-        while(l1 >= l2 && !strchr(delim, *str)) {
-            ++str;
-            --l1;
-        }
-        while(l1 >= l2 && strchr(delim, *str)) {
-            ++str;
-            --l1;
-        }
-    }
-    return NULL;
+const char *String::ifind(const char *str, const char *key, const char *delim)
+{
+    return field(str, key, delim, INSENSITIVE);
 }
 
 char *String::set(char *str, size_t size, const char *s, size_t len)
@@ -1550,8 +1899,11 @@ char *String::set(char *str, size_t size, const char *s)
     if(!str)
         return NULL;
 
-    if(size < 2)
+    if(size < 2) {
+        if(size)
+            *str = 0;
         return str;
+    }
 
     if(!s)
         s = "";
@@ -1613,10 +1965,7 @@ char *String::trim(char *str, const char *clist)
     if(!clist)
         return str;
 
-    while(*str && strchr(clist, *str))
-        ++str;
-
-    return str;
+    return str + charset(clist).span(str);
 }
 
 char *String::chop(char *str, const char *clist)
@@ -1628,8 +1977,11 @@ char *String::chop(char *str, const char *clist)
         return str;
 
     size_t offset = strlen(str);
-    while(offset && strchr(clist, str[offset - 1]))
-        str[--offset] = 0;
+    const char *last = charset(clist).rskip(str, offset);
+    if(last)
+        str[last - str + 1] = 0;
+    else
+        str[0] = 0;
     return str;
 }
 
@@ -1684,8 +2036,10 @@ void String::erase(char *str)
 unsigned String::ccount(const char *str, const char *clist)
 {
     unsigned count = 0;
+    charset members(clist);
+
     while(str && *str) {
-        if(strchr(clist, *(str++)))
+        if(members.test(*(str++)))
             ++count;
     }
     return count;
@@ -1696,8 +2050,7 @@ char *String::skip(char *str, const char *clist)
     if(!str || !clist)
         return NULL;
 
-    while(*str && strchr(clist, *str))
-        ++str;
+    str += charset(clist).span(str);
 
     if(*str)
         return str;
@@ -1712,29 +2065,18 @@ char *String::rskip(char *str, const char *clist)
     if(!len || !clist)
         return NULL;
 
-    while(len > 0) {
-        if(!strchr(clist, str[--len]))
-            return str;
-    }
-    return NULL;
+    return (char *)charset(clist).rskip(str, len);
 }
 
 size_t String::seek(char *str, const char *clist)
 {
-    size_t pos = 0;
-
     if(!str)
         return 0;
 
     if(!clist)
         return strlen(str);
 
-    while(str[pos]) {
-        if(strchr(clist, str[pos]))
-            return pos;
-        ++pos;
-    }
-    return pos;
+    return charset(clist).cspan(str);
 }
 
 char *String::find(char *str, const char *clist)
@@ -1745,10 +2087,10 @@ char *String::find(char *str, const char *clist)
     if(!clist)
         return str;
 
-    while(str && *str) {
-        if(strchr(clist, *str))
-            return str;
-    }
+    str += charset(clist).cspan(str);
+    if(*str)
+        return str;
+
     return NULL;
 }
 
@@ -1760,13 +2102,7 @@ char *String::rfind(char *str, const char *clist)
     if(!clist)
         return str + strlen(str);
 
-    char *s = str + strlen(str);
-
-    while(s > str) {
-        if(strchr(clist, *(--s)))
-            return s;
-    }
-    return NULL;
+    return (char *)charset(clist).rfind(str, strlen(str));
 }
 
 bool String::eq_case(const char *s1, const char *s2)
@@ -0,0 +1,518 @@
+// Copyright (C) 2015-2020 Cherokees of Idaho.
+//
+// This file is part of GNU uCommon C++.
+//
+// GNU uCommon C++ is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// GNU uCommon C++ is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with GNU uCommon C++.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <ucommon-config.h>
+#include <ucommon/export.h>
+#include <ucommon/atomic.h>
+#include <ucommon/timers.h>
+#include <ucommon/thread.h>
+#include <ucommon/condition.h>
+#include <ucommon/taskpool.h>
+
+namespace ucommon {
+
+// tasks a pool thread submits past a full deque go on the shared queue...
+#define DEQUE_SIZE      1024
+#define DEQUE_MASK      (DEQUE_SIZE - 1)
+
+// sleepers look for work again this often, in case a wakeup was missed
+// while going to sleep...
+#define PARK_TIMEOUT    100
+
+// deque positions only grow, and are compared by their distance so that
+// they may safely wrap...
+static inline atomic_t distance(atomic_t from, atomic_t to)
+{
+    return (atomic_t)((unsigned)to - (unsigned)from);
+}
+
+static inline atomic_t advance(atomic_t pos, int offset)
+{
+    return (atomic_t)((unsigned)pos + offset);
+}
+
+class __LOCAL TaskPool::Backend : public Conditional
+{
+private:
+    __DELETE_COPY(Backend);
+
+public:
+    // a pool thread and its Chase-Lev deque.  Only the owner pushes and
+    // takes at the bottom, while any thread may steal from the top.  The
+    // slots sit between top and bottom to keep them on separate lines.
+    class worker : public JoinableThread
+    {
+    private:
+        __DELETE_COPY(worker);
+
+        void run(void) __OVERRIDE;
+
+    public:
+        Backend *backend;
+        unsigned id;
+        int cpu;
+        Atomic::counter top;
+        TaskPool::task *volatile slots[DEQUE_SIZE];
+        Atomic::counter bottom;
+
+        inline worker(Backend *pool, unsigned index, int bind, size_t size) :
+        JoinableThread(size), backend(pool), id(index), cpu(bind), top(0), bottom(0) {}
+
+        inline ~worker() {
+            join();
+        }
+
+        inline void stop(void) {
+            join();
+        }
+
+        inline bool is_empty(void) {
+            return distance(top.get(), bottom.get()) <= 0;
+        }
+
+        bool push(TaskPool::task *object);
+        TaskPool::task *take(void);
+        TaskPool::task *steal(void);
+    };
+
+    worker **threads;
+    unsigned count;
+    TaskPool::task *first, *last;
+    Atomic::counter injected, active, idle, waiting;
+    volatile bool stopping;
+
+    Backend(unsigned size, bool affinity, size_t stack);
+    ~Backend();
+
+    worker *current(void);
+    bool ready(void);
+    TaskPool::task *find(worker *self);
+    void post(TaskPool::task *object);
+    void execute(TaskPool::task *object);
+    bool await(TaskPool::task *object, timeout_t timeout);
+    void serve(worker *self);
+};
+
+bool TaskPool::Backend::worker::push(TaskPool::task *object)
+{
+    atomic_t b = bottom.get();
+
+    if(distance(top.get(), b) >= DEQUE_SIZE)
+        return false;
+
+    slots[(unsigned)b & DEQUE_MASK] = object;
+    bottom.fetch_add(1);
+    return true;
+}
+
+TaskPool::task *TaskPool::Backend::worker::take(void)
+{
+    atomic_t prior = bottom.get();
+    atomic_t b = advance(prior, -1);
+    TaskPool::task *object;
+
+    // claim the bottom slot with a full barrier before looking at top, so
+    // a thief racing for the last task sees the claim...
+    bottom.compare_exchange(prior, b);
+    atomic_t t = top.get();
+    if(distance(t, b) < 0) {
+        bottom.fetch_add(1);
+        return NULL;
+    }
+
+    object = slots[(unsigned)b & DEQUE_MASK];
+    if(b != t)
+        return object;
+
+    if(!top.compare_exchange(t, advance(t, 1)))
+        object = NULL;
+    bottom.fetch_add(1);
+    return object;
+}
+
+TaskPool::task *TaskPool::Backend::worker::steal(void)
+{
+    atomic_t t = top.get();
+    TaskPool::task *object;
+
+    if(distance(t, bottom.get()) <= 0)
+        return NULL;
+
+    object = slots[(unsigned)t & DEQUE_MASK];
+    if(!top.compare_exchange(t, advance(t, 1)))
+        return NULL;
+
+    return object;
+}
+
+void TaskPool::Backend::worker::run(void)
+{
+    map();
+    if(cpu >= 0)
+        Thread::affinity((unsigned)cpu);
+    backend->serve(this);
+}
+
+TaskPool::Backend::Backend(unsigned size, bool affinity, size_t stack) :
+Conditional()
+{
+    unsigned cpus = Thread::cpus();
+
+    first = last = NULL;
+    stopping = false;
+
+    if(!size)
+        size = cpus;
+
+    // every worker exists before any starts, since they steal from each other
+    threads = new worker *[size];
+    for(count = 0; count < size; ++count)
+        threads[count] = new worker(this, count, affinity ? (int)(count % cpus) : -1, stack);
+
+    for(unsigned pos = 0; pos < count; ++pos)
+        threads[pos]->start();
+}
+
+TaskPool::Backend::~Backend()
+{
+    lock();
+    stopping = true;
+    broadcast();
+    unlock();
+
+    // pool threads steal from each other until all have stopped...
+    for(unsigned pos = 0; pos < count; ++pos)
+        threads[pos]->stop();
+
+    while(count)
+        delete threads[--count];
+
+    delete[] threads;
+}
+
+TaskPool::Backend::worker *TaskPool::Backend::current(void)
+{
+    Thread *self = Thread::get();
+
+    for(unsigned pos = 0; self && pos < count; ++pos) {
+        if(threads[pos] == self)
+            return threads[pos];
+    }
+    return NULL;
+}
+
+bool TaskPool::Backend::ready(void)
+{
+    if(injected.get() > 0)
+        return true;
+
+    for(unsigned pos = 0; pos < count; ++pos) {
+        if(!threads[pos]->is_empty())
+            return true;
+    }
+    return false;
+}
+
+TaskPool::task *TaskPool::Backend::find(worker *self)
+{
+    TaskPool::task *object = NULL;
+    unsigned start = 0;
+
+    if(self) {
+        object = self->take();
+        if(object)
+            return object;
+        start = self->id + 1;
+    }
+
+    if(injected.get() > 0) {
+        lock();
+        object = first;
+        if(object) {
+            first = object->next;
+            if(!first)
+                last = NULL;
+            injected.fetch_sub(1);
+        }
+        unlock();
+        if(object)
+            return object;
+    }
+
+    for(unsigned pos = 0; !object && pos < count; ++pos) {
+        worker *victim = threads[(start + pos) % count];
+        if(victim != self)
+            object = victim->steal();
+    }
+    return object;
+}
+
+void TaskPool::Backend::post(TaskPool::task *object)
+{
+    worker *self = current();
+
+    object->next = NULL;
+    if(!self || !self->push(object)) {
+        lock();
+        if(last)
+            last->next = object;
+        else
+            first = object;
+        last = object;
+        injected.fetch_add(1);
+        unlock();
+    }
+
+    // joiners sleep here too, so they may take a wakeup meant for a
+    // pool thread; if any are waiting, wake everyone...
+    if(idle.get() > 0) {
+        lock();
+        if(waiting.get() > 0)
+            broadcast();
+        else
+            signal();
+        unlock();
+    }
+}
+
+void TaskPool::Backend::execute(TaskPool::task *object)
+{
+    TaskPool::job *ref = NULL;
+
+    object->run();
+    if(object->counted)
+        ref = static_cast<TaskPool::job *>(object);
+
+    // a plain task may be deleted by its owner as soon as it is no longer
+    // busy, so it is not touched again after this...
+    active.fetch_sub(1);
+    object->busy.compare_exchange(1, 0);
+    if(waiting.get() > 0 || stopping) {
+        lock();
+        broadcast();
+        unlock();
+    }
+
+    if(ref)
+        ref->release();
+}
+
+bool TaskPool::Backend::await(TaskPool::task *object, timeout_t timeout)
+{
+    worker *self = current();
+    Timer expires;
+    timeout_t remains;
+
+    if(timeout != Timer::inf)
+        expires.set(timeout);
+
+    for(;;) {
+        if(object ? !object->busy.get() : !active.get())
+            return true;
+
+        // a pool thread runs other tasks while waiting, so that tasks
+        // joining tasks they submitted cannot starve the pool...
+        if(self) {
+            TaskPool::task *next = find(self);
+            if(next) {
+                execute(next);
+                continue;
+            }
+        }
+
+        remains = PARK_TIMEOUT;
+        if(timeout != Timer::inf) {
+            remains = expires.get();
+            if(!remains)
+                return false;
+            if(remains > PARK_TIMEOUT)
+                remains = PARK_TIMEOUT;
+        }
+
+        lock();
+        waiting.fetch_add(1);
+        idle.fetch_add(1);
+        if((object ? object->busy.get() : active.get()) && !(self && ready()))
+            Conditional::wait(remains);
+        idle.fetch_sub(1);
+        waiting.fetch_sub(1);
+        unlock();
+    }
+}
+
+void TaskPool::Backend::serve(worker *self)
+{
+    TaskPool::task *object;
+
+    for(;;) {
+        object = find(self);
+        if(object) {
+            execute(object);
+            continue;
+        }
+
+        lock();
+        if(stopping && !active.get()) {
+            unlock();
+            break;
+        }
+        idle.fetch_add(1);
+        if(!ready())
+            Conditional::wait(PARK_TIMEOUT);
+        idle.fetch_sub(1);
+        unlock();
+    }
+}
+
+TaskPool::task::task() :
+busy(0)
+{
+    next = NULL;
+    owner = NULL;
+    counted = false;
+}
+
+TaskPool::task::~task()
+{
+}
+
+bool TaskPool::task::is_busy(void) const
+{
+    return busy.get() != 0;
+}
+
+bool TaskPool::task::join(timeout_t timeout)
+{
+    if(!owner)
+        return true;
+
+    return owner->backend->await(this, timeout);
+}
+
+TaskPool::job::job() :
+task(), refs(0)
+{
+    counted = true;
+}
+
+void TaskPool::job::retain(void)
+{
+    refs.fetch_retain();
+}
+
+void TaskPool::job::release(void)
+{
+    if(refs.fetch_release() == 1)
+        delete this;
+}
+
+TaskPool::future::future()
+{
+    ref = NULL;
+}
+
+TaskPool::future::future(job *object)
+{
+    ref = object;
+    if(ref)
+        ref->retain();
+}
+
+TaskPool::future::future(const future& copy)
+{
+    ref = copy.ref;
+    if(ref)
+        ref->retain();
+}
+
+TaskPool::future::~future()
+{
+    clear();
+}
+
+TaskPool::future& TaskPool::future::operator=(const future& copy)
+{
+    if(copy.ref)
+        copy.ref->retain();
+    clear();
+    ref = copy.ref;
+    return *this;
+}
+
+void TaskPool::future::clear(void)
+{
+    if(ref)
+        ref->release();
+    ref = NULL;
+}
+
+bool TaskPool::future::join(timeout_t timeout)
+{
+    if(!ref)
+        return true;
+
+    return ref->join(timeout);
+}
+
+bool TaskPool::future::is_busy(void) const
+{
+    if(!ref)
+        return false;
+
+    return ref->is_busy();
+}
+
+TaskPool::TaskPool(unsigned threads, bool affinity, size_t stack)
+{
+    backend = new Backend(threads, affinity, stack);
+}
+
+TaskPool::~TaskPool()
+{
+    delete backend;
+}
+
+bool TaskPool::submit(task *object)
+{
+    if(!object || !object->busy.compare_exchange(0, 1))
+        return false;
+
+    object->owner = this;
+    if(object->counted)
+        static_cast<job *>(object)->retain();
+
+    backend->active.fetch_add(1);
+    backend->post(object);
+    return true;
+}
+
+void TaskPool::wait(void)
+{
+    backend->await(NULL, Timer::inf);
+}
+
+unsigned TaskPool::size(void) const
+{
+    return backend->count;
+}
+
+unsigned TaskPool::pending(void) const
+{
+    return (unsigned)backend->active.get();
+}
+
+} // namespace ucommon
@@ -1339,6 +1339,52 @@ size_t Thread::cache(void)
 #endif
 }
 
+unsigned Thread::cpus(void)
+{
+    static volatile unsigned count = 0;
+
+    if(count)
+        return count;
+
+#if defined(_MSWINDOWS_)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    count = info.dwNumberOfProcessors;
+#elif defined(HAVE_SYSCONF) && defined(_SC_NPROCESSORS_ONLN)
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    if(online > 0)
+        count = (unsigned)online;
+#elif defined(__APPLE__)
+    int ncpu = 0;
+    size_t sizeof_ncpu = sizeof(ncpu);
+    if(!sysctlbyname("hw.ncpu", &ncpu, &sizeof_ncpu, 0, 0) && ncpu > 0)
+        count = ncpu;
+#endif
+    if(!count)
+        count = 1;
+    return count;
+}
+
+bool Thread::affinity(unsigned cpu)
+{
+#if defined(_MSWINDOWS_)
+    if(cpu >= sizeof(DWORD_PTR) * 8)
+        return false;
+    return SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << cpu) != 0;
+#elif defined(HAVE_PTHREAD_SETAFFINITY_NP) && defined(CPU_SET)
+    cpu_set_t mask;
+
+    if(cpu >= CPU_SETSIZE)
+        return false;
+
+    CPU_ZERO(&mask);
+    CPU_SET(cpu, &mask);
+    return pthread_setaffinity_np(pthread_self(), sizeof(mask), &mask) == 0;
+#else
+    return false;
+#endif
+}
+
 pthread_t Thread::self(void)
 {
     return pthread_self();
@@ -60,15 +60,77 @@ static void adj(struct timeval *ts)
 }
 #endif
 
+// timer wheel levels; the first level has a slot for each millisecond,
+// and each later level a slot for a whole turn of the level below it...
+#define WHEEL_LEVELS    5
+#define WHEEL_FIRST     256
+#define WHEEL_SLOTS     64
+#define WHEEL_SHIFT(l)  (8 + ((l) - 1) * 6)
+#define WHEEL_INDEX(l)  (WHEEL_FIRST + ((l) - 1) * WHEEL_SLOTS)
+#define WHEEL_DUE       (WHEEL_FIRST + (WHEEL_LEVELS - 1) * WHEEL_SLOTS)
+#define WHEEL_NONE      ((unsigned)(-1))
+#define WHEEL_LEVEL(s)  ((s) < WHEEL_FIRST ? 0 : 1 + ((s) - WHEEL_FIRST) / WHEEL_SLOTS)
+#define WHEEL_RANGE     ((Timer::tick_t)0xffffffff)
+
+class TimerQueue::Wheel
+{
+private:
+    __DELETE_COPY(Wheel);
+
+public:
+    Mutex lock;
+    Timer::tick_t current;
+    TimerQueue::event *running;
+    TimerQueue::event *slots[WHEEL_DUE + 1];
+    unsigned count[WHEEL_LEVELS + 1];
+
+    Wheel();
+
+    inline unsigned pending(void) const {
+        unsigned total = 0;
+        for(unsigned level = 0; level < WHEEL_LEVELS; ++level)
+            total += count[level];
+        return total;
+    }
+};
+
+// millisecond clock from the same source the timers use...
+static Timer::tick_t _millis(void)
+{
+#if _POSIX_TIMERS > 0 && defined(POSIX_TIMERS)
+    struct timespec current;
+    clock_gettime(_posix_clocking, &current);
+    return (Timer::tick_t)current.tv_sec * 1000 + (Timer::tick_t)(current.tv_nsec / 1000000l);
+#else
+    struct timeval current;
+    gettimeofday(&current, NULL);
+    return (Timer::tick_t)current.tv_sec * 1000 + (Timer::tick_t)(current.tv_usec / 1000l);
+#endif
+}
+
+TimerQueue::Wheel::Wheel()
+{
+    current = _millis();
+    running = NULL;
+    memset(slots, 0, sizeof(slots));
+    memset(count, 0, sizeof(count));
+}
+
 TimerQueue::event::event(timeout_t timeout) :
 Timer(), DLinkedObject()
 {
+    slot_next = slot_prev = NULL;
+    deadline = 0;
+    slot = WHEEL_NONE;
     set(timeout);
 }
 
 TimerQueue::event::event(TimerQueue *tq, timeout_t timeout) :
 Timer(), DLinkedObject()
 {
+    slot_next = slot_prev = NULL;
+    deadline = 0;
+    slot = WHEEL_NONE;
     set(timeout);
     Timer::update();
     attach(tq);
@@ -148,6 +210,7 @@ void TimerQueue::event::attach(TimerQueue *tq)
     tq->modify();
     enlist(tq);
     Timer::update();
+    tq->schedule(this);
     tq->update();
 }
 
@@ -157,8 +220,10 @@ void TimerQueue::event::arm(timeout_t timeout)
     if(tq)
         tq->modify();
     set(timeout);
-    if(tq)
+    if(tq) {
+        tq->schedule(this);
         tq->update();
+    }
 }
 
 void TimerQueue::event::disarm(void)
@@ -169,8 +234,10 @@ void TimerQueue::event::disarm(void)
     if(tq && flag)
         tq->modify();
     clear();
-    if(tq && flag)
+    if(tq && flag) {
+        tq->cancel(this);
         tq->update();
+    }
 }
 
 void TimerQueue::event::update(void)
@@ -178,6 +245,7 @@ void TimerQueue::event::update(void)
     TimerQueue *tq = list();
     if(Timer::update() && tq) {
         tq->modify();
+        tq->schedule(this);
         tq->update();
     }
 }
@@ -188,6 +256,7 @@ void TimerQueue::event::detach(void)
     if(tq) {
         tq->modify();
         clear();
+        tq->cancel(this, true);
         delist();
         tq->update();
     }
@@ -425,26 +494,207 @@ timeout_t TQEvent::timeout(void)
 
 TimerQueue::TimerQueue() : OrderedIndex()
 {
+    wheel = new Wheel();
 }
 
 TimerQueue::~TimerQueue()
 {
+    delete wheel;
+}
+
+void TimerQueue::link(event *tp, unsigned slot)
+{
+    tp->slot = slot;
+    tp->slot_prev = NULL;
+    tp->slot_next = wheel->slots[slot];
+    if(tp->slot_next)
+        tp->slot_next->slot_prev = tp;
+    wheel->slots[slot] = tp;
+    ++wheel->count[WHEEL_LEVEL(slot)];
+}
+
+void TimerQueue::unlink(event *tp)
+{
+    if(tp->slot == WHEEL_NONE)
+        return;
+
+    if(tp->slot_prev)
+        tp->slot_prev->slot_next = tp->slot_next;
+    else
+        wheel->slots[tp->slot] = tp->slot_next;
+    if(tp->slot_next)
+        tp->slot_next->slot_prev = tp->slot_prev;
+
+    --wheel->count[WHEEL_LEVEL(tp->slot)];
+    tp->slot_next = tp->slot_prev = NULL;
+    tp->slot = WHEEL_NONE;
+}
+
+void TimerQueue::place(event *tp)
+{
+    Timer::tick_t when = tp->deadline, delta;
+    unsigned level;
+
+    if(when < wheel->current)
+        when = wheel->current;
+
+    delta = when - wheel->current;
+    if(delta < WHEEL_FIRST) {
+        link(tp, (unsigned)(when & (WHEEL_FIRST - 1)));
+        return;
+    }
+
+    // past the last level we cascade early and place again from there...
+    if(delta > WHEEL_RANGE) {
+        delta = WHEEL_RANGE;
+        when = wheel->current + WHEEL_RANGE;
+    }
+
+    for(level = 1; level < WHEEL_LEVELS - 1; ++level) {
+        if(delta < ((Timer::tick_t)1 << WHEEL_SHIFT(level + 1)))
+            break;
+    }
+    link(tp, WHEEL_INDEX(level) + (unsigned)((when >> WHEEL_SHIFT(level)) & (WHEEL_SLOTS - 1)));
+}
+
+void TimerQueue::advance(Timer::tick_t now)
+{
+    event *tp;
+    unsigned index, level, pos;
+
+    if(!wheel->pending()) {
+        if(now >= wheel->current)
+            wheel->current = now + 1;
+        return;
+    }
+
+    while(wheel->current <= now) {
+        index = (unsigned)(wheel->current & (WHEEL_FIRST - 1));
+        if(!index) {
+            for(level = 1; level < WHEEL_LEVELS; ++level) {
+                pos = (unsigned)((wheel->current >> WHEEL_SHIFT(level)) & (WHEEL_SLOTS - 1));
+                while((tp = wheel->slots[WHEEL_INDEX(level) + pos]) != NULL) {
+                    unlink(tp);
+                    place(tp);
+                }
+                if(pos)
+                    break;
+            }
+        }
+
+        while((tp = wheel->slots[index]) != NULL) {
+            unlink(tp);
+            link(tp, WHEEL_DUE);
+        }
+
+        // skip ahead to the next cascade when the first level is empty...
+        ++wheel->current;
+        if(!wheel->pending()) {
+            if(now >= wheel->current)
+                wheel->current = now + 1;
+        }
+        else if(!wheel->count[0] && (wheel->current & (WHEEL_FIRST - 1))) {
+            Timer::tick_t next = (wheel->current | (WHEEL_FIRST - 1)) + 1;
+            wheel->current = (next > now + 1) ? now + 1 : next;
+        }
+    }
+}
+
+timeout_t TimerQueue::first(Timer::tick_t now)
+{
+    Timer::tick_t when = 0, next, base;
+    unsigned level, pos, offset;
+
+    if(!wheel->pending())
+        return Timer::inf;
+
+    if(wheel->count[0]) {
+        for(offset = 0; offset < WHEEL_FIRST; ++offset) {
+            next = wheel->current + offset;
+            if(wheel->slots[next & (WHEEL_FIRST - 1)]) {
+                when = next;
+                break;
+            }
+        }
+    }
+
+    // later levels are woken for at the cascade of their first used slot...
+    for(level = 1; level < WHEEL_LEVELS; ++level) {
+        if(!wheel->count[level])
+            continue;
+        base = (wheel->current + ((Timer::tick_t)1 << WHEEL_SHIFT(level)) - 1) >> WHEEL_SHIFT(level);
+        for(offset = 0; offset < WHEEL_SLOTS; ++offset) {
+            pos = (unsigned)((base + offset) & (WHEEL_SLOTS - 1));
+            if(wheel->slots[WHEEL_INDEX(level) + pos]) {
+                next = (base + offset) << WHEEL_SHIFT(level);
+                if(!when || next < when)
+                    when = next;
+                break;
+            }
+        }
+    }
+
+    if(when <= now)
+        return 1;
+
+    if(when - now >= (Timer::tick_t)Timer::inf)
+        return Timer::inf - 1;
+
+    return (timeout_t)(when - now);
+}
+
+void TimerQueue::schedule(event *tp)
+{
+    Timer::tick_t now = _millis();
+
+    wheel->lock.acquire();
+    unlink(tp);
+    if(tp->is_active()) {
+        if(!wheel->pending() && now > wheel->current)
+            wheel->current = now;
+        tp->deadline = now + tp->get();
+        place(tp);
+    }
+    wheel->lock.release();
+}
+
+void TimerQueue::cancel(event *tp, bool detach)
+{
+    wheel->lock.acquire();
+    unlink(tp);
+    if(detach && wheel->running == tp)
+        wheel->running = NULL;
+    wheel->lock.release();
 }
 
 timeout_t TimerQueue::expire(void)
 {
-    timeout_t first = Timer::inf, next;
-    linked_pointer<TimerQueue::event> timer = begin();
+    timeout_t next;
     TimerQueue::event *tp;
 
-    while(timer) {
-        tp = *timer;
-        timer.next();
+    wheel->lock.acquire();
+    advance(_millis());
+
+    // due events are kept on their own list so they can still be
+    // disarmed or detached by the expired handlers of other events...
+    while((tp = wheel->slots[WHEEL_DUE]) != NULL) {
+        unlink(tp);
+        wheel->running = tp;
+        wheel->lock.release();
         next = tp->timeout();
-        if(next && next < first)
-            first = next;
+        wheel->lock.acquire();
+        if(wheel->running != tp)
+            continue;
+        wheel->running = NULL;
+        if(tp->slot == WHEEL_NONE && tp->is_active()) {
+            tp->deadline = _millis() + (next ? next : tp->get());
+            place(tp);
+        }
     }
-    return first;
+
+    next = first(_millis());
+    wheel->lock.release();
+    return next;
 }
 
 void TimerQueue::operator+=(event &te) { te.attach(this); }
@@ -304,6 +304,26 @@ class __EXPORT AppLog : protected streambuf, public ostream
      */
     void slogEnable(bool en = true);
 
+#ifndef _MSWINDOWS_
+    /**
+     * Enables asynchronous logging.  Messages are formatted by the
+     * calling thread into a lock free ring of fixed size records, and
+     * written to the log file in batches by a writer thread.  When the
+     * ring is full new messages are dropped rather than waited for.  This
+     * should be changed while no other thread is logging.
+     * @param en true to enable asynchronous logging.
+     * @param records size of ring, rounded up to a power of two.
+     */
+    void asyncEnable(bool en = true, unsigned records = 1024);
+
+    /**
+     * Number of messages dropped by asynchronous logging, either because
+     * the ring was full, or because the log file could not be written.
+     * @return dropped message count.
+     */
+    unsigned long asyncDropped(void);
+#endif
+
     /**
      * Sets the level for that ident.
      * @param ident ident (module name for instance).
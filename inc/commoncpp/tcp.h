@@ -513,6 +513,18 @@ public:
      */
     int sync(void) __OVERRIDE;
 
+    /**
+     * Send part of a file on the stream connection.  Pending output
+     * is written first, and the file data is then passed to the kernel
+     * directly rather than copied through the stream buffers.
+     *
+     * @return number of bytes sent, -1 on error.
+     * @param file descriptor to send from.
+     * @param offset in file to start from, or -1 for current position.
+     * @param size of data to send.
+     */
+    ssize_t sendFile(fd_t file, off_t offset, size_t size);
+
     /**
      * Print content into a socket.
      *
@@ -321,6 +321,8 @@ class __EXPORT Semaphore : protected ucommon::Semaphore
 public:
     inline Semaphore(unsigned size = 0) : ucommon::Semaphore(size) {}
 
+    inline Semaphore(unsigned size, unsigned avail) : ucommon::Semaphore(size, avail) {}
+
     inline bool wait(timeout_t timeout) {
         return ucommon::Semaphore::wait(timeout);
     }
@@ -874,8 +876,10 @@ public:
  * posting.  This class is derived from Mutex and maintains a linked
  * list.  A thread is used to dequeue data and pass it to a callback
  * method that is used in place of "run" for each item present on the
- * queue.  The conditional is used to signal the run thread when new
- * data is posted.
+ * queue.  The semaphore is used to wake the run thread when data is
+ * posted to an empty queue, and the run thread then processes every
+ * item waiting before it sleeps again.  Processed items are kept in a
+ * pool to be reused for later posts.
  *
  * This class was changed by Angelo Naselli to have a timeout on the queue
  *
@@ -893,6 +897,7 @@ protected:
     typedef struct _data {
         struct _data *next;
         unsigned len;
+        unsigned size;
         char data[1];
     }   data_t;
 
@@ -900,6 +905,8 @@ protected:
     bool started;
 
     data_t *first, *last;       // head/tail of list
+    data_t *pool;               // processed items kept for reuse
+    unsigned pooled, poolLimit, poolSize;
 
     String name;
 
@@ -956,14 +963,24 @@ public:
      * When the timer expires, the onTimer() method is called
      * for the thread
      *
-     * @param timeout timeout in milliseconds.
+     * @param timeout timeout in milliseconds, or 0 for none.
      */
     void setTimer(timeout_t timeout);
 
     /**
-     * Put some unspecified data into this queue.  A new qd
-     * structure is created and sized to contain a copy of
-     * the actual content.
+     * Set how many processed items are kept for reuse, and how large
+     * they are.  Posts that fit are then copied into a kept item rather
+     * than allocating a new one.  The items are allocated up front.
+     *
+     * @param count of items to keep, or 0 to keep none.
+     * @param size of data each kept item may hold.
+     */
+    void setPool(unsigned count, unsigned size = 256);
+
+    /**
+     * Put some unspecified data into this queue.  A qd structure
+     * sized to contain a copy of the actual content is taken from
+     * the pool, or created if none fit.
      *
      * @param data pointer to data.
      * @param len size of data.
@@ -110,6 +110,8 @@ protected:
     Family family;
 
 public:
+    typedef ucommon::Socket::datagram_t datagram_t;
+
     /**
      * Create an unbound UDP socket, mostly for internal use.
      */
@@ -214,6 +216,26 @@ public:
      */
     ssize_t receive(void *buf, size_t len, bool reply = false);
 
+    /**
+     * Send a batch of message packets.  Packets without an address of
+     * their own are sent to the peer host.
+     *
+     * @param list of packets to send.
+     * @param count of packets in list.
+     * @return number of packets sent, -1 on error.
+     */
+    ssize_t send(const datagram_t *list, unsigned count);
+
+    /**
+     * Receive a batch of messages from any host.  This waits for the
+     * first message, and then takes those already waiting up to count.
+     *
+     * @param list of packet buffers to receive into.
+     * @param count of packet buffers in list.
+     * @return number of packets received, -1 on error.
+     */
+    ssize_t receive(datagram_t *list, unsigned count);
+
     /**
      * Examine address of sender of next waiting packet.  This also
      * sets "peer" address to the sender so that the next "send"
@@ -420,6 +442,17 @@ public:
     inline ssize_t transmit(const char *buffer, size_t len)
         {return ::send(so, buffer, (socksize_t)len, MSG_DONTWAIT|MSG_NOSIGNAL);}
 
+    /**
+     * Transmit a batch of packets to the connected peer, or to the
+     * address each packet holds.
+     *
+     * @return number of packets sent.
+     * @param list of packets to send.
+     * @param count of packets in list.
+     */
+    inline ssize_t transmit(const datagram_t *list, unsigned count)
+        {return ucommon::Socket::sendbatch(so, list, count, MSG_DONTWAIT);}
+
     /**
      * See if output queue is empty for sending more packets.
      *
@@ -540,6 +573,16 @@ public:
     inline ssize_t receive(void *buf, size_t len)
         {return ::recv(so, (char *)buf, (socksize_t)len, 0);}
 
+    /**
+     * Receive a batch of data packets from the connected peer host.
+     *
+     * @return num of packets actually received.
+     * @param list of packet buffers to receive into.
+     * @param count of packet buffers in list.
+     */
+    inline ssize_t receive(datagram_t *list, unsigned count)
+        {return ucommon::Socket::recvbatch(so, list, count);}
+
     /**
      * See if input queue has data packets available.
      *
@@ -54,7 +54,7 @@ namespace ucommon {
 class __EXPORT ArrayRef : public TypeRef
 {
 protected:
-	typedef enum {ARRAY, STACK, QUEUE, FALLBACK} arraytype_t;
+	typedef enum {ARRAY, STACK, QUEUE, FALLBACK, RING} arraytype_t;
 
 	class __EXPORT Array : public Counted, public ConditionalAccess
 	{
@@ -64,12 +64,34 @@ protected:
 	protected:
 		friend class ArrayRef;
 
+		class Ring;
+
 		size_t head, tail;
 
 		arraytype_t type;
 
+		Ring *ring;
+
 		explicit Array(arraytype_t mode, void *addr, size_t size);
 
+		/**
+		 * Lockfree insert into a ring array.  Slots are claimed by
+		 * sequence number, and a thread only blocks when the ring is
+		 * full.  Waiting consumers are woken only if any are parked.
+		 * @param object to insert.
+		 * @param timeout to wait if full.
+		 * @return true if inserted.
+		 */
+		bool enqueue(Counted *object, timeout_t timeout);
+
+		/**
+		 * Lockfree removal from a ring array.  A thread only blocks
+		 * when the ring is empty.
+		 * @param timeout to wait if empty.
+		 * @return object removed, or NULL if none.
+		 */
+		Counted *dequeue(timeout_t timeout);
+
 		void assign(size_t index, Counted *object);
 
 		Counted *remove(size_t index);
@@ -259,6 +281,70 @@ public:
 	}
 };
 
+/**
+ * A bounded lockfree queue of typeref objects.  This may be used as a work
+ * queue between many producer and consumer threads.  Unlike queueref, slots
+ * are claimed by atomic sequence numbers rather than by locking, and
+ * threads only block when the queue is empty or full.  The size is rounded
+ * up to a power of two.  Objects in the ring cannot be accessed by index.
+ * @author David Sugar <dyfet@gnutelephony.org>
+ */
+template<typename T>
+class ringref : public ArrayRef
+{
+public:
+	inline ringref() :	ArrayRef() {};
+
+	inline ringref(const ringref& copy) : ArrayRef(copy) {};
+
+	inline ringref(size_t size) : ArrayRef(RING, size) {};
+
+	inline ringref& operator=(const ringref& copy) {
+		TypeRef::set(copy);
+		return *this;
+	}
+
+	inline void release(void) {
+		TypeRef::set(nullptr);
+	}
+
+	inline typeref<T> pull() {
+		typeref<T> obj;
+		ArrayRef::pull(obj);
+		return obj;
+	}
+
+	inline typeref<T> pull(timeout_t timeout) {
+		typeref<T> obj;
+		ArrayRef::pull(obj, timeout);
+		return obj;
+	}
+
+	inline ringref& operator>>(typeref<T>& target) {
+		ArrayRef::pull(target);
+		return *this;
+	}
+
+	inline void push(const typeref<T>& source) {
+		ArrayRef::push(source);
+	}
+
+	inline bool push(const typeref<T>& source, timeout_t timeout) {
+		return ArrayRef::push(source, timeout);
+	}
+
+	inline ringref& operator<<(const typeref<T>& source) {
+		ArrayRef::push(source);
+		return *this;
+	}
+
+	inline ringref& operator<<(T t) {
+		typeref<T> v(t);
+		ArrayRef::push(v);
+		return *this;
+	}
+};
+
 template<typename T>
 class arrayref : public ArrayRef
 {
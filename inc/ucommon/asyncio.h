@@ -0,0 +1,357 @@
+// Copyright (C) 2015-2020 Cherokees of Idaho.
+//
+// This file is part of GNU uCommon C++.
+//
+// GNU uCommon C++ is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// GNU uCommon C++ is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with GNU uCommon C++.  If not, see <http://www.gnu.org/licenses/>.
+
+/**
+ * Asynchronous i/o for files and sockets.  Operations are queued on an
+ * engine, submitted together, and completed later from the thread that
+ * drives the engine.  Linux io_uring is used where the kernel offers it,
+ * and otherwise file operations are performed when submitted and socket
+ * operations when poll finds them ready.
+ * @file ucommon/asyncio.h
+ */
+
+#ifndef _UCOMMON_ASYNCIO_H_
+#define _UCOMMON_ASYNCIO_H_
+
+#ifndef _UCOMMON_CPR_H_
+#include <ucommon/cpr.h>
+#endif
+
+#ifndef _UCOMMON_TIMERS_H_
+#include <ucommon/timers.h>
+#endif
+
+#ifndef _UCOMMON_SOCKET_H_
+#include <ucommon/socket.h>
+#endif
+
+#ifndef _UCOMMON_FSYS_H_
+#include <ucommon/fsys.h>
+#endif
+
+#ifndef _MSWINDOWS_
+
+namespace ucommon {
+
+/**
+ * An engine for many concurrent file and socket operations driven from
+ * one thread.  Each operation is described by a request object, which
+ * is queued with one of the operation methods, passed to the kernel by
+ * submit, and called back from complete once it is done.  A request
+ * must stay alive and is busy until called back, and the engine itself
+ * is not thread safe, so it should be used only from the thread that
+ * drives it.
+ * @author David Sugar <dyfet@gnutelephony.org>
+ */
+class __EXPORT AsyncIO
+{
+private:
+    __DELETE_COPY(AsyncIO);
+
+public:
+    /**
+     * Operations a request may perform.
+     */
+    typedef enum {
+        READ,
+        WRITE,
+        FSYNC,
+        ACCEPT,
+        CONNECT,
+        RECV,
+        SEND
+    } operation_t;
+
+    /**
+     * An asynchronous operation.  This is used as a base class for
+     * objects that override the completed callback, and holds the
+     * result of the operation once it is done.
+     * @author David Sugar <dyfet@gnutelephony.org>
+     */
+    class __EXPORT request
+    {
+    private:
+        __DELETE_COPY(request);
+
+        friend class AsyncIO;
+
+        request *next;
+        operation_t op;
+        int fd;
+        void *data;
+        size_t size;
+        off_t offset;
+        int flags;
+        struct sockaddr_storage *address;
+        socklen_t addrlen;
+        ssize_t status;
+        int err;
+        bool busy;
+
+    protected:
+        /**
+         * Called from complete when the operation is done.
+         */
+        virtual void completed(void);
+
+    public:
+        /**
+         * Create an idle request.
+         */
+        request();
+
+        /**
+         * Destroy request.  It must not be busy.
+         */
+        virtual ~request();
+
+        /**
+         * Get result of the operation.  This is the byte count for
+         * transfers, the new socket for accept, and 0 otherwise.
+         * @return result or -1 if failed.
+         */
+        inline ssize_t result(void) const {
+            return status;
+        }
+
+        /**
+         * Get error of a failed operation.
+         * @return error code or 0 if successful.
+         */
+        inline int error(void) const {
+            return err;
+        }
+
+        /**
+         * Get the operation last queued for.
+         * @return operation.
+         */
+        inline operation_t operation(void) const {
+            return op;
+        }
+
+        /**
+         * See if operation is queued or in progress.
+         * @return true if busy.
+         */
+        inline bool is_busy(void) const {
+            return busy;
+        }
+    };
+
+private:
+    class Backend;
+
+    Backend *backend;
+    size_t inflight;
+
+    bool queue(request *object, operation_t op, int fd, void *data, size_t size, off_t offset, int flags);
+
+public:
+    /**
+     * Create an engine.
+     * @param depth of the submission queue.
+     */
+    AsyncIO(unsigned depth = 256);
+
+    /**
+     * Destroy engine.  Requests still in progress are never called back.
+     */
+    virtual ~AsyncIO();
+
+    /**
+     * Queue a read from a descriptor.
+     * @param object to call back.
+     * @param file descriptor to read from.
+     * @param buffer to read into.
+     * @param size of buffer.
+     * @param offset in file, or -1 for current position.
+     * @return true if queued.
+     */
+    bool read(request *object, fd_t file, void *buffer, size_t size, off_t offset = -1);
+
+    /**
+     * Queue a read from a file.
+     * @param object to call back.
+     * @param file to read from.
+     * @param buffer to read into.
+     * @param size of buffer.
+     * @param offset in file, or -1 for current position.
+     * @return true if queued.
+     */
+    inline bool read(request *object, const fsys& file, void *buffer, size_t size, off_t offset = -1) {
+        return read(object, *file, buffer, size, offset);
+    }
+
+    /**
+     * Queue a write to a descriptor.
+     * @param object to call back.
+     * @param file descriptor to write to.
+     * @param buffer to write from.
+     * @param size of data to write.
+     * @param offset in file, or -1 for current position.
+     * @return true if queued.
+     */
+    bool write(request *object, fd_t file, const void *buffer, size_t size, off_t offset = -1);
+
+    /**
+     * Queue a write to a file.
+     * @param object to call back.
+     * @param file to write to.
+     * @param buffer to write from.
+     * @param size of data to write.
+     * @param offset in file, or -1 for current position.
+     * @return true if queued.
+     */
+    inline bool write(request *object, const fsys& file, const void *buffer, size_t size, off_t offset = -1) {
+        return write(object, *file, buffer, size, offset);
+    }
+
+    /**
+     * Queue a sync of a descriptor to storage.
+     * @param object to call back.
+     * @param file descriptor to sync.
+     * @return true if queued.
+     */
+    bool fsync(request *object, fd_t file);
+
+    /**
+     * Queue a sync of a file to storage.
+     * @param object to call back.
+     * @param file to sync.
+     * @return true if queued.
+     */
+    inline bool fsync(request *object, const fsys& file) {
+        return fsync(object, *file);
+    }
+
+    /**
+     * Queue accepting a connection from a listener.
+     * @param object to call back.
+     * @param socket to accept from.
+     * @param address to save peer address in, or NULL.
+     * @return true if queued.
+     */
+    bool accept(request *object, socket_t socket, struct sockaddr_storage *address = NULL);
+
+    /**
+     * Queue accepting a connection from a listener.
+     * @param object to call back.
+     * @param socket to accept from.
+     * @param address to save peer address in, or NULL.
+     * @return true if queued.
+     */
+    inline bool accept(request *object, const ListenSocket& socket, struct sockaddr_storage *address = NULL) {
+        return accept(object, *socket, address);
+    }
+
+    /**
+     * Queue connecting a socket.
+     * @param object to call back.
+     * @param socket to connect.
+     * @param address to connect to, which must stay valid until done.
+     * @return true if queued.
+     */
+    bool connect(request *object, socket_t socket, const struct sockaddr *address);
+
+    /**
+     * Queue receiving from a socket.
+     * @param object to call back.
+     * @param socket to receive from.
+     * @param buffer to receive into.
+     * @param size of buffer.
+     * @param flags for i/o operation.
+     * @return true if queued.
+     */
+    bool recv(request *object, socket_t socket, void *buffer, size_t size, int flags = 0);
+
+    /**
+     * Queue receiving from a socket.
+     * @param object to call back.
+     * @param socket to receive from.
+     * @param buffer to receive into.
+     * @param size of buffer.
+     * @param flags for i/o operation.
+     * @return true if queued.
+     */
+    inline bool recv(request *object, const Socket& socket, void *buffer, size_t size, int flags = 0) {
+        return recv(object, *socket, buffer, size, flags);
+    }
+
+    /**
+     * Queue sending on a socket.
+     * @param object to call back.
+     * @param socket to send on.
+     * @param buffer to send from.
+     * @param size of data to send.
+     * @param flags for i/o operation.
+     * @return true if queued.
+     */
+    bool send(request *object, socket_t socket, const void *buffer, size_t size, int flags = 0);
+
+    /**
+     * Queue sending on a socket.
+     * @param object to call back.
+     * @param socket to send on.
+     * @param buffer to send from.
+     * @param size of data to send.
+     * @param flags for i/o operation.
+     * @return true if queued.
+     */
+    inline bool send(request *object, const Socket& socket, const void *buffer, size_t size, int flags = 0) {
+        return send(object, *socket, buffer, size, flags);
+    }
+
+    /**
+     * Submit all queued requests in one batch.
+     * @return number of requests submitted.
+     */
+    unsigned submit(void);
+
+    /**
+     * Submit queued requests, wait for at least one to be done, and call
+     * back all that are done.
+     * @param timeout to wait if none are done yet.
+     * @return number of requests called back.
+     */
+    unsigned complete(timeout_t timeout = Timer::inf);
+
+    /**
+     * Get number of requests queued or in progress.
+     * @return count of busy requests.
+     */
+    inline size_t pending(void) const {
+        return inflight;
+    }
+
+    /**
+     * See if the engine uses kernel asynchronous i/o.
+     * @return true if io_uring is used.
+     */
+    bool is_native(void) const;
+};
+
+/**
+ * A convenience type for asynchronous requests.
+ */
+typedef AsyncIO::request aio_request;
+
+} // namespace ucommon
+
+#endif
+
+#endif
@@ -82,6 +82,15 @@ public:
         atomic_t get() volatile;
         void clear() volatile;
 
+        /**
+         * Replace value only if it still holds an expected value.  This
+         * is a full barrier, and may be used to build lockfree structures.
+         * @param expected value of counter.
+         * @param desired value to set if counter is expected value.
+         * @return true if replaced.
+         */
+        bool compare_exchange(atomic_t expected, atomic_t desired) volatile;
+
         inline operator atomic_t() volatile {
             return get();
         }
@@ -172,6 +181,14 @@ public:
     };
 
     static bool is_lockfree(void);
+
+    /**
+     * Full memory barrier.  Loads and stores made before the fence are
+     * ordered before any made after it.  This is used to order plain
+     * access to memory that may not be written by atomic operations, such
+     * as a read-only shared memory mapping.
+     */
+    static void fence(void);
 };
 
 } // namespace ucommon
@@ -857,6 +857,28 @@ public:
      * @param object to release.
      */
     static void release(tm_t *object);
+
+    /**
+     * Convert time to local time through a cache shared by all threads.
+     * The most recent second converted is kept, so the current time is
+     * only converted once a second however often it is asked for.  This
+     * is thread safe without locks, and there is nothing to release.
+     * @param result to save local time in.
+     * @param time object or NULL if using current time.
+     */
+    static void local(tm_t& result, const time_t *time = NULL);
+
+    /**
+     * Format the current local time as "yyyy-mm-dd hh:mm:ss.mmm" for
+     * timestamps.  The date and time come from the shared local time
+     * cache, so only milliseconds are formatted while the second is
+     * unchanged.
+     * @param buffer to save timestamp in.
+     * @param size of buffer, 24 bytes for a complete timestamp.
+     * @param millisec true to include milliseconds.
+     * @return length of timestamp.
+     */
+    static size_t stamp(char *buffer, size_t size, bool millisec = true);
 };
 
 /**
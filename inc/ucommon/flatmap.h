@@ -0,0 +1,422 @@
+// Copyright (C) 2015-2020 Cherokees of Idaho.
+//
+// This file is part of GNU uCommon C++.
+//
+// GNU uCommon C++ is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// GNU uCommon C++ is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with GNU uCommon C++.  If not, see <http://www.gnu.org/licenses/>.
+
+/**
+ * Flat open addressed maps of thread-safe strongly typed heap objects.
+ * This offers the same typeref keyed maps as mapref, but keeps every
+ * entry in one flat slot table probed by groups of control bytes rather
+ * than chaining a heap node for each entry.  Shared and exclusive locking
+ * is used based on lookup or modify operations.
+ * @file ucommon/flatmap.h
+ */
+
+#ifndef _UCOMMON_FLATMAP_H_
+#define _UCOMMON_FLATMAP_H_
+
+#ifndef _UCOMMON_CPR_H_
+#include <ucommon/cpr.h>
+#endif
+
+#ifndef _UCOMMON_ATOMIC_H_
+#include <ucommon/atomic.h>
+#endif
+
+#ifndef _UCOMMON_PROTOCOLS_H_
+#include <ucommon/protocols.h>
+#endif
+
+#ifndef _UCOMMON_OBJECT_H_
+#include <ucommon/object.h>
+#endif
+
+#ifndef	_UCOMMON_TYPEREF_H_
+#include <ucommon/typeref.h>
+#endif
+
+#ifndef _UCOMMON_THREAD_H_
+#include <ucommon/thread.h>
+#endif
+
+#ifndef _UCOMMON_MAPREF_H_
+#include <ucommon/mapref.h>
+#endif
+
+namespace ucommon {
+
+/**
+ * Base class for flat open addressed typeref maps.  Slots are kept in
+ * power of two tables split into groups of 16 control bytes.  Each
+ * control byte is either empty, deleted, or holds 7 bits of the key hash,
+ * so a whole group can be matched at once, with SSE2 where available,
+ * before any key is compared.
+ * @author David Sugar <dyfet@gnutelephony.org>
+ */
+class __EXPORT FlatRef : public TypeRef
+{
+public:
+	/**
+	 * A flat map slot.  The full hash is kept so the table can be
+	 * regrown without access to the typed keys.
+	 */
+	typedef struct {
+		Counted *key, *value;
+		size_t hash;
+	} slot_t;
+
+protected:
+	class Instance;
+
+	class __EXPORT Map : public Counted
+	{
+	private:
+		__DELETE_COPY(Map);
+
+		bool place(size_t hash, size_t& pos);
+
+	protected:
+		friend class Instance;
+
+		virtual void dealloc() __OVERRIDE;
+
+	public:
+		friend class FlatRef;
+
+		condlock_t lock;
+		uint8_t *ctrl;
+		slot_t *slots;
+		size_t capacity, count, deleted;
+
+		explicit Map(void *addr, size_t size, TypeRelease *ar);
+
+		/**
+		 * Match control bytes of a group.
+		 * @param group to examine.
+		 * @param tag control byte to match.
+		 * @return bit mask of matching slots in group.
+		 */
+		unsigned match(size_t group, uint8_t tag) const;
+
+		/**
+		 * Rebuild slot table at a new capacity.  This also drops any
+		 * deleted slot markers.
+		 * @param size of new table, rounded to a power of two.
+		 * @return true if rebuilt.
+		 */
+		bool resize(size_t size);
+
+		/**
+		 * Claim an unused slot for a new key hash, growing the table
+		 * when the load factor would exceed 7/8.
+		 * @param hash of key.
+		 * @return slot or NULL if table cannot grow.
+		 */
+		slot_t *insert(size_t hash);
+
+		void remove(size_t pos);
+
+		void clear(void);
+
+		inline slot_t *get(size_t pos) {
+			return &slots[pos];
+		}
+	};
+
+	/**
+	 * Walks the probe sequence of a key hash, visiting only slots whose
+	 * control byte matches the hash tag, and stops at the first group
+	 * that still has an empty slot.
+	 */
+	class __EXPORT Probe
+	{
+	private:
+		Map *map;
+		size_t group, step;
+		unsigned mask;
+		uint8_t tag;
+
+	public:
+		size_t pos;
+
+		Probe(Map *map, size_t hash);
+
+		bool next(void);
+
+		inline slot_t *slot(void) {
+			return map->get(pos);
+		}
+
+		inline slot_t *operator->() {
+			return map->get(pos);
+		}
+	};
+
+	class __EXPORT Instance
+	{
+	protected:
+		Map *map;
+		size_t pos;
+
+		Instance();
+
+		Instance(FlatRef& from);
+
+		Instance(const Instance& copy);
+
+		void assign(const Instance& copy);
+
+		void assign(FlatRef& from);
+
+		void drop(void);
+
+		Counted *key();
+
+		Counted *value();
+
+	public:
+		~Instance();
+
+		void rewind();
+
+		bool next();
+
+		bool eol();
+
+		inline operator bool() {
+			return map != NULL && pos < map->capacity;
+		}
+
+		inline bool operator!() {
+			return map == NULL || pos >= map->capacity;
+		}
+	};
+
+	FlatRef(size_t size, TypeRelease *ar = &auto_release);
+	FlatRef(const FlatRef& copy);
+	FlatRef();
+
+	static Map *create(size_t size, TypeRelease *ar = &auto_release);
+
+	Map *access(void);
+
+	Map *modify(void);
+
+	void add(Map *map, size_t hash, TypeRef& key, TypeRef& value);
+
+	void update(slot_t *slot, TypeRef& value);
+
+	void remove(Map *map, size_t pos);
+
+	void release(Map *map);
+
+	void commit(Map *map);
+
+public:
+	size_t count(void);
+
+	size_t capacity(void);
+
+	void purge(void);
+};
+
+template<typename T>
+inline size_t flatkeyhash(typeref<T>& object)
+{
+	return MapRef::hash((const uint8_t *)(object()), sizeof(T), sizeof(T));
+}
+
+template<>
+inline size_t flatkeyhash<const char *>(typeref<const char *>& object)
+{
+	return MapRef::hash((const uint8_t *)(*object), object.len(), 1);
+}
+
+template<>
+inline size_t flatkeyhash<const uint8_t *>(typeref<const uint8_t *>& object)
+{
+	return MapRef::hash(*object, object.size(), object.size());
+}
+
+/**
+ * Flat open addressed map of typeref keys and values.  This is used the
+ * same way as mapref, but avoids a heap node per entry and the pointer
+ * chasing of chained index lists on lookup.
+ * @author David Sugar <dyfet@gnutelephony.org>
+ */
+template<typename K, typename V>
+class flatmap : public FlatRef
+{
+protected:
+	bool erase(typeref<K>& key) {
+		size_t hash = flatkeyhash<K>(key);
+		Map *m = modify();
+		if(!m)
+			return false;
+		Probe probe(m, hash);
+		while(probe.next()) {
+			if(probe->hash != hash)
+				continue;
+			typeref<K> kv(probe->key);
+			if(is(kv) && kv == key) {
+				FlatRef::remove(m, probe.pos);
+				FlatRef::commit(m);
+				return true;
+			}
+		}
+		FlatRef::commit(m);
+		return false;
+	}
+
+public:
+	class instance : public FlatRef::Instance
+	{
+	public:
+		inline instance(const instance& copy) : Instance(static_cast<const Instance&>(copy)) {};
+
+		inline instance(flatmap& from) : Instance(static_cast<FlatRef&>(from)) {};
+
+		inline instance() : Instance() {};
+
+		inline typeref<K> key() {
+			return typeref<K>(Instance::key());
+		}
+
+		inline typeref<V> value() {
+			return typeref<V>(Instance::value());
+		}
+
+		inline instance& operator++() {
+			next();
+			return *this;
+		}
+
+		inline instance& operator=(const instance& copy) {
+			assign(static_cast<const Instance&>(copy));
+			return *this;
+		}
+
+		inline instance& operator=(flatmap& from) {
+			assign(static_cast<FlatRef&>(from));
+			return *this;
+		}
+	};
+
+	inline flatmap(const flatmap& copy) : FlatRef(copy) {};
+
+	inline flatmap(size_t size = 32, TypeRelease *ar = &auto_release) : FlatRef(size, ar) {};
+
+	inline flatmap& operator=(const flatmap& copy) {
+		TypeRef::set(copy);
+		return *this;
+	}
+
+	inline instance operator*() {
+		return instance(*this);
+	}
+
+	void value(typeref<K>& key, typeref<V>& val) {
+		size_t hash = flatkeyhash<K>(key);
+		Map *m = modify();
+		if(!m)
+			return;
+		Probe probe(m, hash);
+		while(probe.next()) {
+			if(probe->hash != hash)
+				continue;
+			typeref<K> kv(probe->key);
+			if(is(kv) && kv == key) {
+				update(probe.slot(), val);
+				commit(m);
+				return;
+			}
+		}
+		add(m, hash, key, val);
+		commit(m);
+	}
+
+	typeref<V> at(typeref<K>& key) {
+		size_t hash = flatkeyhash<K>(key);
+		Map *m = access();
+		if(!m)
+			return typeref<V>();
+		Probe probe(m, hash);
+		while(probe.next()) {
+			if(probe->hash != hash)
+				continue;
+			typeref<K> kv(probe->key);
+			if(is(kv) && kv == key) {
+				typeref<V> result(probe->value);
+				release(m);
+				return result;
+			}
+		}
+		release(m);
+		return typeref<V>();
+	}
+
+	typeref<V> take(typeref<K>& key) {
+		size_t hash = flatkeyhash<K>(key);
+		Map *m = modify();
+		if(!m)
+			return typeref<V>();
+		Probe probe(m, hash);
+		while(probe.next()) {
+			if(probe->hash != hash)
+				continue;
+			typeref<K> kv(probe->key);
+			if(is(kv) && kv == key) {
+				typeref<V> result(probe->value);
+				FlatRef::remove(m, probe.pos);
+				commit(m);
+				return result;
+			}
+		}
+		commit(m);
+		return typeref<V>();
+	}
+
+	inline bool remove(typeref<K>& key) {
+		return erase(key);
+	}
+
+	inline bool remove(K k) {
+		typeref<K> key(k);
+		return erase(key);
+	}
+
+	inline typeref<V> operator()(typeref<K>& key) {
+		return at(key);
+	}
+
+	inline typeref<V> operator()(K k) {
+		typeref<K> key(k);
+		return at(key);
+	}
+
+	inline void operator()(typeref<K>& key, typeref<V>& val) {
+		value(key, val);
+	}
+
+	inline void operator()(K k, V v) {
+		typeref<K> key(k);
+		typeref<V> val(v);
+		value(key, val);
+	}
+};
+
+} // namespace
+
+#endif
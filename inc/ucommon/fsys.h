@@ -144,6 +144,19 @@ public:
         DIR_TEMPORARY = 01777
     };
 
+    /**
+     * Options for copying files.  Cloning shares the blocks of the source
+     * file where the filesystem supports it, and is used unless NOCLONE
+     * is given.
+     */
+    enum {
+        COPY_MODE = 0x01,
+        COPY_TIMES = 0x02,
+        COPY_OWNER = 0x04,
+        COPY_PRESERVE = 0x07,
+        COPY_NOCLONE = 0x08
+    };
+
     typedef struct stat fileinfo_t;
 
 #ifdef  _MSWINDOWS_
@@ -175,6 +188,14 @@ public:
      */
     typedef long offset_t;
 
+    /**
+     * Callback for progress of a file copy.  It is passed the bytes copied
+     * so far and the size of the source file, which are 64 bit so large
+     * files are reported whole on 32 bit systems, and returns false to
+     * cancel the copy.
+     */
+    typedef bool (*progress_t)(void *user, uint64_t copied, uint64_t total);
+
     /**
      * Used to mark "append" in set position operations.
      */
@@ -390,13 +411,27 @@ public:
     static int erase(const char *path);
 
     /**
-     * Copy a file.
+     * Copy a file.  The kernel copies the file directly where it can, by
+     * cloning, copy_file_range, or sendfile, and otherwise it is copied
+     * through a buffer.
      * @param source file.
      * @param target file.
-     * @param size of buffer.
+     * @param size of buffer, or 0 for default.
      * @return error number or 0 on success.
      */
-    static int copy(const char *source, const char *target, size_t size = 1024);
+    static int copy(const char *source, const char *target, size_t size = 0);
+
+    /**
+     * Copy a file, preserving attributes and reporting progress.
+     * @param source file.
+     * @param target file.
+     * @param options of copy to preserve attributes or not clone.
+     * @param progress callback or NULL.
+     * @param user pointer passed to callback.
+     * @param size of buffer, or 0 for default.
+     * @return error number, ECANCELED if cancelled, or 0 on success.
+     */
+    static int copy(const char *source, const char *target, unsigned options, progress_t progress, void *user = NULL, size_t size = 0);
 
     /**
      * Rename a file.
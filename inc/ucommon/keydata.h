@@ -79,7 +79,7 @@ public:
     private:
         friend class keydata;
         friend class keyfile;
-        keyvalue(keyfile *allocator, keydata *section, const char *key, const char *data);
+        keyvalue(keyfile *allocator, keydata *section, const char *key, const char *data, bool copy = true);
         __DELETE_COPY(keyvalue);
 
     public:
@@ -161,9 +161,17 @@ class __EXPORT keyfile : public memalloc
 {
 private:
     friend class keydata;
+    class __LOCAL mapping;
+    class __LOCAL loader;
+
     OrderedIndex index;
     keydata *defaults;
     int errcode;
+    mapping *mapped;
+
+    keydata *parse(keydata *section, char *line, loader *from = NULL);
+    bool map(const char *path);
+    void unmap(void);
 
 protected:
     keydata *create(const char *section);
@@ -189,10 +197,20 @@ public:
 
     keyfile(const keyfile &copy, size_t pagesize = 0);
 
+    /**
+     * Destroy key file, releasing any files mapped by loading.
+     */
+    ~keyfile();
+
     /**
      * Load (overlay) another config file over the currently loaded one.
      * This is used to merge key data, such as getting default values from
-     * a global config, and then overlaying a local home config file.
+     * a global config, and then overlaying a local home config file.  A
+     * regular file is mapped privately and parsed in place, so that keys
+     * and values loaded refer into the mapping rather than being copied,
+     * and the mapping is kept until the key file is released.  Where pages
+     * cannot be copied as they are mapped, a file cut short by another
+     * process while it is being loaded may fault.
      * @param path to load keys from into current object.
      */
     void load(const char *path);
@@ -497,7 +497,9 @@ public:
     static NamedObject *skip(NamedObject **hash, NamedObject *current, unsigned size);
 
     /**
-     * Internal function to convert a name to a hash index number.
+     * Internal function to convert a name to a hash index number.  Every
+     * byte of the name is hashed, with ascii case folded so that case
+     * insensitive compare overrides still find their keys.
      * @param name to convert into index.
      * @param size of map table.
      */
@@ -565,6 +567,106 @@ public:
     }
 };
 
+/**
+ * A growable hash index of named objects.  This holds the hash map table
+ * used by the NamedObject map, remove, and skip functions, and doubles the
+ * table as more objects are added so chains stay short even when many
+ * thousands of names are indexed.
+ * @author David Sugar <dyfet@gnutelephony.org>
+ */
+class __EXPORT NamedIndex
+{
+private:
+    __DELETE_COPY(NamedIndex);
+
+protected:
+    NamedObject **table;
+    unsigned size, members;
+
+    /**
+     * Relist all indexed objects into a new hash map table.
+     * @param size of new hash map table.
+     */
+    void resize(unsigned size);
+
+public:
+    /**
+     * Create an empty named object index.
+     * @param size of initial hash map table.
+     */
+    NamedIndex(unsigned size = 31);
+
+    /**
+     * Destroy index.  This does not purge the objects indexed.
+     */
+    ~NamedIndex();
+
+    /**
+     * Add a named object to the index, replacing an existing object of
+     * the same name.  The table grows once it averages two names a path.
+     * @param object to add.
+     * @param name of the object, as a dup'd string.
+     */
+    void add(NamedObject *object, char *name);
+
+    /**
+     * Find a named object in the index.
+     * @param name of object to find.
+     * @return object pointer or NULL if not found.
+     */
+    NamedObject *map(const char *name) const;
+
+    /**
+     * Remove a named object from the index.
+     * @param name of object to remove.
+     * @return object that is removed or NULL if not found.
+     */
+    NamedObject *remove(const char *name);
+
+    /**
+     * Iterate through the index.
+     * @param current named object we iterated or NULL to find start.
+     * @return next named object in index or NULL if no more objects.
+     */
+    NamedObject *skip(NamedObject *current = NULL) const;
+
+    /**
+     * Convert index into a linear object pointer array.  The array is
+     * created from the heap and must be deleted when no longer used.
+     * @return array of named object pointers.
+     */
+    NamedObject **index(void) const;
+
+    /**
+     * Purge and release all objects in the index.
+     */
+    void purge(void);
+
+    /**
+     * Number of named objects in the index.
+     * @return count of objects.
+     */
+    inline unsigned count(void) const {
+        return members;
+    }
+
+    /**
+     * Size of the current hash map table.
+     * @return number of index paths.
+     */
+    inline unsigned range(void) const {
+        return size;
+    }
+
+    /**
+     * Get the hash map table for use with NamedObject functions.
+     * @return hash map table.
+     */
+    inline NamedObject **get(void) const {
+        return table;
+    }
+};
+
 /**
  * The named tree class is used to form a tree oriented list of associated
  * objects.  Typical uses for such data structures might be to form a
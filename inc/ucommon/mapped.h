@@ -80,6 +80,14 @@ protected:
      */
     void create(const char *name, size_t size = (size_t)0);
 
+    /**
+     * Supporting function to access an existing shared memory segment for
+     * both reading and writing, for segments that more than one process
+     * updates.  The size of the map is found from the existing segment.
+     * @param name of segment to access.
+     */
+    void attach(const char *name);
+
 public:
     /**
      * Construct a read/write access mapped shared segment of memory of a
@@ -155,6 +163,67 @@ public:
      */
     bool copy(size_t offset, void *buffer, size_t size) const;
 
+    /**
+     * Write a versioned record at a specific offset within the mapped
+     * memory segment.  A record starts with a sequence number that is odd
+     * while the record is being written, so that readers in other
+     * processes can take a consistent copy without locking.  Only one
+     * thread or process may write a given record.
+     * @param offset of record from start of segment.
+     * @param buffer to copy from.
+     * @param size of record data.
+     */
+    void update(size_t offset, const void *buffer, size_t size);
+
+    /**
+     * Copy a versioned record from a specific offset within the mapped
+     * memory segment.  The copy is only repeated if the writer changed
+     * the record while it was being copied.
+     * @param offset of record from start of segment.
+     * @param buffer to copy into.
+     * @param size of record data.
+     * @return true on success.
+     */
+    bool snapshot(size_t offset, void *buffer, size_t size) const;
+
+    /**
+     * Publish a record through a ring of versioned slots at a specific
+     * offset within the mapped memory segment.  Each update is written to
+     * the slot after the latest one, so readers copying the latest record
+     * are only disturbed if the writer laps every slot while they copy.
+     * Only one thread or process may publish to a given ring.
+     * @param offset of ring from start of segment.
+     * @param buffer to copy from.
+     * @param size of record data.
+     * @param slots in ring.
+     */
+    void publish(size_t offset, const void *buffer, size_t size, unsigned slots);
+
+    /**
+     * Copy the latest record published through a ring of versioned slots.
+     * @param offset of ring from start of segment.
+     * @param buffer to copy into.
+     * @param size of record data.
+     * @param slots in ring, or 0 for the number the publisher used.
+     * @return true on success, false if nothing published yet.
+     */
+    bool latest(size_t offset, void *buffer, size_t size, unsigned slots) const;
+
+    /**
+     * Get space used in a mapped segment by a versioned record.
+     * @param size of record data.
+     * @return size of record with its sequence number.
+     */
+    static size_t record(size_t size);
+
+    /**
+     * Get space used in a mapped segment by a ring of versioned slots.
+     * @param size of record data.
+     * @param slots in ring.
+     * @return size of ring.
+     */
+    static size_t ring(size_t size, unsigned slots);
+
     /**
      * Get size of mapped segment.
      * @return size of mapped segment.
@@ -261,6 +330,97 @@ public:
     void removeLocked(ReusableObject *object);
 };
 
+/**
+ * A ring of fixed size records in a named shared memory segment, used to
+ * pass messages between processes without locking.  Records are copied in
+ * by producers and out by a single consumer.  A ring is created either for
+ * a single producer, or for many producers that claim slots atomically.
+ * Each slot carries a sequence number that tells whether it is filled, so
+ * neither side ever waits on the other while there is room or data.  A
+ * producer or consumer that must wait sleeps on a futex in the segment
+ * where supported, and the other side only makes a system call to wake it
+ * when someone is actually waiting.
+ * @author David Sugar <dyfet@gnutelephony.org>
+ */
+class __EXPORT MappedRing : protected MappedMemory
+{
+private:
+    class __LOCAL control;
+
+    control *ring;
+    caddr_t slots;
+    size_t objsize, stride;
+
+    __DELETE_DEFAULTS(MappedRing);
+
+    bool push(const void *data);
+    bool pull(void *data);
+
+public:
+    /**
+     * Create a named ring.  Any existing segment of the same name is
+     * replaced.  The segment is removed when the creating ring is
+     * destroyed.
+     * @param name of shared memory segment.
+     * @param size of records.
+     * @param count of records the ring holds, rounded up to a power of 2.
+     * @param multiple producers may put records if true.
+     */
+    MappedRing(const char *name, size_t size, unsigned count, bool multiple = false);
+
+    /**
+     * Attach to a named ring created by another process.  The ring is
+     * inactive if it does not exist or holds records of another size.
+     * @param name of shared memory segment.
+     * @param size of records.
+     */
+    MappedRing(const char *name, size_t size);
+
+    /**
+     * Put a record into the ring.  Only one process may put records into
+     * a ring made for a single producer.
+     * @param data of record to copy in.
+     * @param timeout to wait for room if the ring is full.
+     * @return true if put, false if full.
+     */
+    bool put(const void *data, timeout_t timeout = 0);
+
+    /**
+     * Get the oldest record from the ring.  Only one process may get
+     * records from a ring.
+     * @param data of record to copy out.
+     * @param timeout to wait for a record if the ring is empty.
+     * @return true if copied, false if empty.
+     */
+    bool get(void *data, timeout_t timeout = 0);
+
+    /**
+     * Get number of records waiting in the ring.
+     * @return records pending.
+     */
+    unsigned pending(void) const;
+
+    /**
+     * Get number of records the ring holds.
+     * @return ring size.
+     */
+    unsigned max(void) const;
+
+    /**
+     * Test if ring is active.
+     * @return true if ring mapped.
+     */
+    inline operator bool() const
+        {return ring != NULL;}
+
+    /**
+     * Test if ring is inactive.
+     * @return true if ring not mapped.
+     */
+    inline bool operator!() const
+        {return ring == NULL;}
+};
+
 /**
  * Template class to map typed vector into shared memory.  This is used to
  * construct a typed read/write vector of objects that are held in a named
@@ -510,6 +670,160 @@ public:
         {return (unsigned)(size / sizeof(T));}
 };
 
+/**
+ * Template class to map a vector of typed versioned records into shared
+ * memory.  The publishing process creates the segment and updates members,
+ * while other processes map it read-only and take consistent copies of
+ * members without locking, only copying again if a member changed while
+ * being copied.  The type is copied as memory, and so should be plain data.
+ * @author David Sugar <dyfet@gnutelephony.org>
+ */
+template <class T>
+class mapped_record : public MappedMemory
+{
+private:
+    __DELETE_DEFAULTS(mapped_record);
+
+public:
+    /**
+     * Create and map a named segment of versioned records for writing.
+     * @param name of mapped segment to construct.
+     * @param number of records in the mapped vector.
+     */
+    inline mapped_record(const char *name, unsigned number) :
+        MappedMemory(name, number * record(sizeof(T))) {if(size) memset(addr(), 0, size);}
+
+    /**
+     * Map an existing named segment of versioned records read-only.
+     * @param name of memory segment to map.
+     */
+    inline mapped_record(const char *name) :
+        MappedMemory(name) {}
+
+    /**
+     * Update a member record.  Only the creating process may do this.
+     * @param member to update.
+     * @param value to copy into member.
+     */
+    inline void put(unsigned member, const T& value)
+        {update(member * record(sizeof(T)), &value, sizeof(T));}
+
+    /**
+     * Take a consistent copy of a member record.
+     * @param member to copy.
+     * @param buffer to copy into.
+     * @return true on success.
+     */
+    inline bool get(unsigned member, T& buffer) const
+        {return snapshot(member * record(sizeof(T)), &buffer, sizeof(T));}
+
+    /**
+     * Get count of typed records held in this map.
+     * @return count of records.
+     */
+    inline unsigned count(void) const
+        {return (unsigned)(size / record(sizeof(T)));}
+};
+
+/**
+ * Template class to publish the latest value of a typed record, such as a
+ * block of statistics, through shared memory.  Each update is written to
+ * the next of a ring of versioned slots and then made the latest, so that
+ * readers in other processes are never held up by an update in progress,
+ * and only copy again if the publisher laps the whole ring while they copy.
+ * The type is copied as memory, and so should be plain data.
+ * @author David Sugar <dyfet@gnutelephony.org>
+ */
+template <class T>
+class mapped_latest : public MappedMemory
+{
+private:
+    unsigned slots;
+
+    __DELETE_DEFAULTS(mapped_latest);
+
+public:
+    /**
+     * Create and map a named segment to publish a record through.
+     * @param name of mapped segment to construct.
+     * @param count of slots in ring, at least 2.
+     */
+    inline mapped_latest(const char *name, unsigned count) :
+        MappedMemory(name, ring(sizeof(T), count)) {slots = count; if(size) memset(addr(), 0, size);}
+
+    /**
+     * Map an existing named segment a record is published through
+     * read-only.  The number of slots is the one the publisher stored.
+     * @param name of memory segment to map.
+     */
+    inline mapped_latest(const char *name) :
+        MappedMemory(name) {slots = 0;}
+
+    /**
+     * Publish a new value of the record.  Only the creating process may
+     * do this.
+     * @param value to publish.
+     */
+    inline void put(const T& value)
+        {publish(0, &value, sizeof(T), slots);}
+
+    /**
+     * Take a consistent copy of the latest value published.
+     * @param buffer to copy into.
+     * @return true on success, false if nothing published yet.
+     */
+    inline bool get(T& buffer) const
+        {return latest(0, &buffer, sizeof(T), slots);}
+};
+
+/**
+ * Template class to pass typed records between processes through a ring in
+ * shared memory.  The type is copied as memory, and so should be plain
+ * data.
+ * @author David Sugar <dyfet@gnutelephony.org>
+ */
+template <class T>
+class mapped_ring : public MappedRing
+{
+private:
+    __DELETE_DEFAULTS(mapped_ring);
+
+public:
+    /**
+     * Create a named ring of typed records.
+     * @param name of shared memory segment.
+     * @param count of records the ring holds.
+     * @param multiple producers may put records if true.
+     */
+    inline mapped_ring(const char *name, unsigned count, bool multiple = false) :
+        MappedRing(name, sizeof(T), count, multiple) {}
+
+    /**
+     * Attach to a named ring of typed records created by another process.
+     * @param name of shared memory segment.
+     */
+    inline mapped_ring(const char *name) :
+        MappedRing(name, sizeof(T)) {}
+
+    /**
+     * Put a typed record into the ring.
+     * @param value to copy in.
+     * @param timeout to wait for room if the ring is full.
+     * @return true if put, false if full.
+     */
+    inline bool put(const T& value, timeout_t timeout = 0)
+        {return MappedRing::put(&value, timeout);}
+
+    /**
+     * Get the oldest typed record from the ring.
+     * @param value to copy out into.
+     * @param timeout to wait for a record if the ring is empty.
+     * @return true if copied, false if empty.
+     */
+    inline bool get(T& value, timeout_t timeout = 0)
+        {return MappedRing::get(&value, timeout);}
+};
+
 } // namespace ucommon
 
 #endif
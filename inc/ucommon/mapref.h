@@ -57,6 +57,14 @@ namespace ucommon {
 
 class __EXPORT MapRef : public TypeRef
 {
+public:
+	/**
+	 * Key hashing used to select map index paths.  SHIFT is the original
+	 * shift and xor hash.  MIX is a multiply and rotate hash that uses
+	 * every bit of the key, and is the default for new maps.
+	 */
+	typedef enum {SHIFT, MIX} hash_t;
+
 protected:
 	class Map;
     class Instance;
@@ -74,6 +82,7 @@ protected:
 		Index();
 
 		Counted *key, *value;
+		size_t path;
 	};
 
 	class __EXPORT Map : public Counted
@@ -94,12 +103,47 @@ protected:
 		LinkedObject *free, *last;
 		size_t count, alloc;
 
-		explicit Map(void *addr, size_t indexes, size_t paging = 0);
+		// while growing, prior buckets below migrate have been moved...
+		LinkedObject **table, **prior;
+		size_t buckets, previous, migrate;
+		hash_t hashing;
+
+		explicit Map(void *addr, size_t indexes, size_t paging = 0, hash_t mode = MIX);
 
 		inline LinkedObject **get(void) {
 			return reinterpret_cast<LinkedObject **>(((caddr_t)(this)) + sizeof(Map));
 		}
 
+		/**
+		 * Number of index paths to visit when iterating the map.  While
+		 * the map is growing this includes the prior index.
+		 * @return number of paths.
+		 */
+		inline size_t paths(void) const {
+			return previous + buckets;
+		}
+
+		/**
+		 * Get the first member of an iterated index path.
+		 * @param path to examine.
+		 * @return first member of path, or NULL if empty.
+		 */
+		LinkedObject *first(size_t path);
+
+		/**
+		 * Get root of the index list that holds a keyed path.
+		 * @param path of key.
+		 * @return root pointer of index list.
+		 */
+		LinkedObject **root(size_t path);
+
+		/**
+		 * Start growing a keyed map when its load factor is exceeded,
+		 * and migrate a few prior index lists each time it is modified
+		 * so no one insert pays for rehashing the entire map.
+		 */
+		void rehash(void);
+
 		Index *create(size_t path);
 
 		Index *append();
@@ -156,13 +200,15 @@ protected:
 		}
 	};
 
-	MapRef(size_t paths, size_t paging = 0);
+	MapRef(size_t paths, size_t paging = 0, hash_t mode = MIX);
 	MapRef(const MapRef& copy);
 	MapRef();
 
 	void assign(TypeRef& key, TypeRef& value);
 
-	static Map *create(size_t paths, size_t paging = 0);
+	static Map *create(size_t paths, size_t paging = 0, hash_t mode = MIX);
+
+	hash_t hashing(void);
 
 	linked_pointer<Index> access(size_t keyvalue = 0);
 
@@ -188,27 +234,47 @@ public:
 	void purge(void);
 
 	static size_t index(size_t& key, const uint8_t *addr, size_t len);
+
+	/**
+	 * Compute index path of a key with a selected hash.
+	 * @param key path to seed and update.
+	 * @param addr of key data.
+	 * @param len of key data.
+	 * @param mode of hashing to use.
+	 * @return index path.
+	 */
+	static size_t index(size_t& key, const uint8_t *addr, size_t len, hash_t mode);
+
+	/**
+	 * Fast well distributed hash of key data.  This processes a word at a
+	 * time with multiply and rotate mixing, and a final avalanche.
+	 * @param addr of key data.
+	 * @param len of key data.
+	 * @param seed for hash.
+	 * @return hash value.
+	 */
+	static size_t hash(const uint8_t *addr, size_t len, size_t seed = 0);
 };
 
 template<typename T>
-inline size_t mapkeypath(typeref<T>& object)
+inline size_t mapkeypath(typeref<T>& object, MapRef::hash_t mode = MapRef::SHIFT)
 {
 	size_t path = sizeof(T);
-	return MapRef::index(path, (const uint8_t *)(object()), sizeof(T));
+	return MapRef::index(path, (const uint8_t *)(object()), sizeof(T), mode);
 }
 
 template<>
-inline size_t mapkeypath<const char *>(typeref<const char *>& object)
+inline size_t mapkeypath<const char *>(typeref<const char *>& object, MapRef::hash_t mode)
 {
 	size_t path = 1;
-	return MapRef::index(path, (const uint8_t *)(*object), object.len());
+	return MapRef::index(path, (const uint8_t *)(*object), object.len(), mode);
 }
 
 template<>
-inline size_t mapkeypath<const uint8_t *>(typeref<const uint8_t *>& object)
+inline size_t mapkeypath<const uint8_t *>(typeref<const uint8_t *>& object, MapRef::hash_t mode)
 {
 	size_t path = object.size();
-	return MapRef::index(path, *object, object.size());
+	return MapRef::index(path, *object, object.size(), mode);
 }
 
 template<typename K, typename V>
@@ -216,7 +282,7 @@ class mapref : public MapRef
 {
 protected:
 	bool erase(typeref<K>& key) {
-		size_t path = mapkeypath<K>(key);
+		size_t path = mapkeypath<K>(key, hashing());
 		linked_pointer<Index> ip = modify(path);
 		while(is(ip)) {
 			typeref<K> kv(ip->key);
@@ -267,7 +333,7 @@ public:
 
 	inline mapref(const mapref& copy) : MapRef(copy) {};
 
-	inline mapref(size_t paths = 37, size_t paging = 0) : MapRef(paths, paging) {};
+	inline mapref(size_t paths = 37, size_t paging = 0, hash_t mode = MIX) : MapRef(paths, paging, mode) {};
 
 	inline mapref& operator=(const mapref& copy) {
 		TypeRef::set(copy);
@@ -279,7 +345,7 @@ public:
 	}
 
 	void value(typeref<K>& key, typeref<V>& val) {
-		size_t path = mapkeypath<K>(key);
+		size_t path = mapkeypath<K>(key, hashing());
 		linked_pointer<Index> ip = modify(path);
 		while(is(ip)) {
 			typeref<K> kv(ip->key);
@@ -295,7 +361,7 @@ public:
 	}
 
 	typeref<V> at(typeref<K>& key) {
-		linked_pointer<Index> ip = access(mapkeypath<K>(key));
+		linked_pointer<Index> ip = access(mapkeypath<K>(key, hashing()));
 		while(is(ip)) {
 			typeref<K> kv(ip->key);
 			if(is(kv) && kv == key) {
@@ -310,7 +376,7 @@ public:
 	}
 
 	typeref<V> take(typeref<K>& key) {
-		size_t path = mapkeypath<K>(key);
+		size_t path = mapkeypath<K>(key, hashing());
 		linked_pointer<Index> ip = modify(path);
 		while(is(ip)) {
 			typeref<K> kv(ip->key);
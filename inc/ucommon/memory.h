@@ -50,6 +50,20 @@
 namespace ucommon {
 
 class PagerPool;
+class PagerCache;
+class PagerIndex;
+
+/**
+ * Statistics for the per-thread caches of a memory pager or pager pool.
+ * Hits are requests served from the calling thread's cache, misses are
+ * requests that had to go to the shared (locked) pool, and remote counts
+ * objects that were released by a different thread than the one that
+ * acquired them.  Refills and returns count batch transfers between the
+ * thread caches and the shared pool.
+ */
+typedef struct {
+    unsigned long hits, misses, refills, returns, remote;
+} pagerstats_t;
 
 /**
  * A memory protocol pager for private heap manager.  This is used to allocate
@@ -62,6 +76,7 @@ class __EXPORT memalloc : public __PROTOCOL MemoryProtocol
 {
 private:
     friend class bufpager;
+    friend class mempager;
 
     size_t pagesize, align;
     unsigned count;
@@ -74,7 +89,21 @@ private:
         };
     }   page_t;
 
+    typedef union memslab {
+        union memslab *next;
+        size_t id;
+    }   slab_t;
+
     page_t *page;
+    slab_t **slabs;
+    unsigned classes;
+
+    /**
+     * Allocate from size class free lists or the current page.
+     * @param size of memory request.
+     * @return allocated memory.
+     */
+    void *_slab(size_t size);
 
 protected:
     unsigned limit;
@@ -87,10 +116,15 @@ protected:
 
 public:
     /**
-     * Construct a memory pager.
+     * Construct a memory pager.  When a slab size is given, the pager
+     * keeps free lists for each pointer sized class of object up to that
+     * size, allocates only from the current page, and can recycle memory
+     * that is returned with dealloc.  Slab objects are pointer aligned, as
+     * other pager memory is; the pager alignment applies to pages only.
      * @param page size to use or 0 for OS allocation size.
+     * @param slab size of largest recycled object, or 0 if none.
      */
-    memalloc(size_t page = 0);
+    memalloc(size_t page = 0, size_t slab = 0);
 
     memalloc(const memalloc& copy);
 
@@ -126,6 +160,15 @@ public:
         return pagesize;
     }
 
+    /**
+     * Get the largest object size that is managed by size class free
+     * lists.
+     * @return largest recycled object size, or 0 if not slab pager.
+     */
+    inline size_t slab(void) const {
+        return classes * sizeof(void *);
+    }
+
     /**
      * Determine fragmentation level of acquired heap pages.  This is
      * represented as an average % utilization (0-100) and represents the
@@ -143,6 +186,15 @@ public:
      */
     void purge(void);
 
+    /**
+     * Return memory back to pager heap.  If the pager was created with
+     * a slab size, memory of that size or smaller is placed on the free
+     * list for it's size class and will be reused by the next request of
+     * the same class.  Otherwise this does nothing.
+     * @param memory to free back to private heap.
+     */
+    virtual void dealloc(void *memory);
+
 protected:
     /**
      * Allocate memory from the pager heap.  The size of the request must be
@@ -179,12 +231,18 @@ public:
  * it is best to allocate objects a significant fraction smaller than the
  * page size, as fragmentation occurs at the end of pages when there is
  * insufficient space in the current page to complete a request.
+ *
+ * A mempager may also be created with a slab size.  In that case small
+ * objects are grouped into pointer sized classes, each with it's own free
+ * list, and memory returned with dealloc is reused.  This allows a pager
+ * to be used for long lived objects that are created and destroyed often.
  * @author David Sugar <dyfet@gnutelephony.org>
  */
 class __EXPORT mempager : public memalloc, public __PROTOCOL LockingProtocol
 {
 private:
     mutable pthread_mutex_t mutex;
+    PagerCache *caches;
 
 protected:
     /**
@@ -202,10 +260,15 @@ protected:
 
 public:
     /**
-     * Construct a memory pager.
+     * Construct a memory pager.  A slab pager may also use per-thread
+     * caches of free objects so that most requests do not need to lock
+     * the pager.  Caches are refilled from and returned to the pager in
+     * batches.
      * @param page size to use or 0 for OS allocation size.
+     * @param slab size of largest recycled object, or 0 if none.
+     * @param cache batch size of thread caches, or 0 if not used.
      */
-    mempager(size_t page = 0);
+    mempager(size_t page = 0, size_t slab = 0, unsigned cache = 0);
 
     mempager(const mempager& copy);
 
@@ -232,13 +295,20 @@ public:
     void purge(void);
 
     /**
-     * Return memory back to pager heap.  This actually does nothing, but
-     * might be used in a derived class to create a memory heap that can
-     * also receive (free) memory allocated from our heap and reuse it,
+     * Return memory back to pager heap.  This is locked and recycles
+     * memory for a slab pager, and otherwise does nothing.  It might also
+     * be used in a derived class to create a memory heap that can
+     * receive (free) memory allocated from our heap and reuse it,
      * for example in a full private malloc implementation in a derived class.
      * @param memory to free back to private heap.
      */
-    virtual void dealloc(void *memory);
+    virtual void dealloc(void *memory) __OVERRIDE;
+
+    /**
+     * Get statistics for thread caches of this pager.
+     * @return cache statistics, all zero if no thread caches are used.
+     */
+    pagerstats_t stats(void) const;
 
 protected:
     /**
@@ -293,12 +363,15 @@ private:
     size_t typesize;
     member *last;
     void **index;
+    PagerIndex *chunks;
 
     __DELETE_COPY(ObjectPager);
 
 protected:
     ObjectPager(size_t objsize, size_t pagesize = 256);
 
+    ~ObjectPager();
+
     /**
      * Get object from list.  This is useful when objectpager is
      * passed as a pointer and hence inconvenient for the [] operator.
@@ -452,6 +525,8 @@ public:
 
     StringPager(char **list, size_t pagesize = 256);
 
+    ~StringPager();
+
     /**
      * Get the number of items in the pager string list.
      * @return number of items stored.
@@ -576,7 +651,8 @@ public:
     void sort(void);
 
     /**
-     * Gather index list.
+     * Gather index list.  The list stays valid until the pager is cleared,
+     * even after the pager is changed or sorted.
      * @return index.
      */
     char **list(void);
@@ -634,6 +710,7 @@ public:
 private:
     member *last;
     char **index;
+    PagerIndex *chunks;
 
 public:
     /**
@@ -789,6 +866,7 @@ protected:
     friend class PagerPool;
 
     PagerPool *pager;
+    unsigned origin;
 
     /**
      * Create a pager object.  This is object is constructed by a PagerPool.
@@ -826,11 +904,19 @@ class __EXPORT PagerPool : public __PROTOCOL MemoryProtocol
 private:
     LinkedObject *freelist;
     mutable pthread_mutex_t mutex;
+    PagerCache *caches;
 
     __DELETE_COPY(PagerPool);
 
 protected:
-    PagerPool();
+    /**
+     * Create a pager pool.  A pool may keep per-thread caches of free
+     * objects that are refilled from and returned to the shared free
+     * list in batches, so most requests do not lock the pool.  Objects
+     * of a pool with caches take an extra link word of memory each.
+     * @param cache batch size of thread caches, or 0 if not used.
+     */
+    PagerPool(unsigned cache = 0);
     virtual ~PagerPool();
 
     PagerObject *get(size_t size);
@@ -841,6 +927,12 @@ public:
      * @param object to return to pool.
      */
     void put(PagerObject *object);
+
+    /**
+     * Get statistics for thread caches of this pool.
+     * @return cache statistics, all zero if no thread caches are used.
+     */
+    pagerstats_t stats(void) const;
 };
 
 /**
@@ -859,8 +951,9 @@ public:
     /**
      * Construct a pager and optionally assign a private pager heap.
      * @param heap pager to use.  If NULL, uses global heap.
+     * @param cache batch size of thread caches, or 0 if not used.
      */
-    inline pager(mempager *heap = NULL) : MemoryRedirect(heap), PagerPool() {}
+    inline pager(mempager *heap = NULL, unsigned cache = 0) : MemoryRedirect(heap), PagerPool(cache) {}
 
     /**
      * Create a managed object by casting reference.
@@ -877,6 +970,14 @@ public:
     inline T *operator*() {
         return new(get(sizeof(T))) T;
     }
+
+    /**
+     * Get statistics for thread caches of the pager.
+     * @return cache statistics.
+     */
+    inline pagerstats_t stats(void) const {
+        return PagerPool::stats();
+    }
 };
 
 /**
@@ -0,0 +1,296 @@
+// Copyright (C) 2015-2020 Cherokees of Idaho.
+//
+// This file is part of GNU uCommon C++.
+//
+// GNU uCommon C++ is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// GNU uCommon C++ is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with GNU uCommon C++.  If not, see <http://www.gnu.org/licenses/>.
+
+/**
+ * Event loop for many sockets and descriptors in one thread.  A reactor
+ * waits on every attached descriptor at once, using epoll where available
+ * and poll otherwise, and calls back the source attached for each one
+ * that becomes ready.  The reactor is also a timer queue, so timer events
+ * may be attached to it and are expired from the same loop.
+ * @file ucommon/reactor.h
+ */
+
+#ifndef _UCOMMON_REACTOR_H_
+#define _UCOMMON_REACTOR_H_
+
+#ifndef _UCOMMON_CPR_H_
+#include <ucommon/cpr.h>
+#endif
+
+#ifndef _UCOMMON_ATOMIC_H_
+#include <ucommon/atomic.h>
+#endif
+
+#ifndef _UCOMMON_TIMERS_H_
+#include <ucommon/timers.h>
+#endif
+
+#ifndef _UCOMMON_THREAD_H_
+#include <ucommon/thread.h>
+#endif
+
+#ifndef _UCOMMON_SOCKET_H_
+#include <ucommon/socket.h>
+#endif
+
+#ifndef _UCOMMON_FSYS_H_
+#include <ucommon/fsys.h>
+#endif
+
+#ifndef _MSWINDOWS_
+
+namespace ucommon {
+
+/**
+ * A single threaded event loop for descriptors and timers.  Sources are
+ * attached for a descriptor and the events they want, and are called
+ * back from dispatch when their descriptor is ready.  Readiness is level
+ * triggered, so a source that does not consume all pending input is called
+ * again on the next dispatch.  Timer events attached to the reactor are
+ * expired before each wait, and the wait is limited to when the next
+ * timer will expire.  Timers may be armed and sources attached from other
+ * threads, which wake the loop, but sources should only be deleted from
+ * the loop thread or while it is stopped.
+ * @author David Sugar <dyfet@gnutelephony.org>
+ */
+class __EXPORT Reactor : public TimerQueue
+{
+private:
+    __DELETE_COPY(Reactor);
+
+public:
+    /**
+     * Events a source may be attached for.
+     */
+    enum {
+        READ = 0x01,
+        WRITE = 0x02
+    };
+
+    /**
+     * A descriptor attached to a reactor.  This is used as a base class
+     * for connection and listener objects, which override the readable
+     * and writable callbacks.  A source is detached when destroyed.
+     * @author David Sugar <dyfet@gnutelephony.org>
+     */
+    class __EXPORT source
+    {
+    private:
+        __DELETE_COPY(source);
+
+        friend class Reactor;
+
+        Reactor *reactor;
+        socket_t fd;
+        unsigned mask;
+        size_t index;
+
+    protected:
+        /**
+         * Create a source that is not yet attached.
+         */
+        source();
+
+        /**
+         * Called when the descriptor has input, or has hung up or failed.
+         */
+        virtual void readable(void);
+
+        /**
+         * Called when the descriptor can be written.
+         */
+        virtual void writable(void);
+
+    public:
+        /**
+         * Detaches from the reactor when destroyed.
+         */
+        virtual ~source();
+
+        /**
+         * Change the events the source waits for.
+         * @param events to wait for.
+         * @return true if changed.
+         */
+        bool wait(unsigned events);
+
+        /**
+         * Detach source from its reactor.
+         */
+        void detach(void);
+
+        /**
+         * Get the descriptor the source is attached for.
+         * @return descriptor or INVALID_SOCKET if not attached.
+         */
+        inline socket_t handle(void) const {
+            return fd;
+        }
+
+        /**
+         * Get the events the source waits for.
+         * @return event mask.
+         */
+        inline unsigned events(void) const {
+            return mask;
+        }
+
+        /**
+         * Get the reactor we are attached to.
+         * @return reactor or NULL if not attached.
+         */
+        inline Reactor *list(void) const {
+            return reactor;
+        }
+    };
+
+private:
+    class Backend;
+
+    Backend *backend;
+    Mutex lock;
+    pthread_t owner;
+    bool running, stopped;
+    Atomic::counter waking;
+    fd_t wake[2];
+    size_t sources;
+
+    void drain(void);
+
+protected:
+    /**
+     * Lock the reactor while timers are changed.
+     */
+    virtual void modify(void) __OVERRIDE;
+
+    /**
+     * Unlock the reactor after timers are changed, and wake the loop if
+     * this is called from another thread.
+     */
+    virtual void update(void) __OVERRIDE;
+
+public:
+    /**
+     * Create a reactor.
+     * @param hint of how many descriptors to expect.
+     */
+    Reactor(size_t hint = 64);
+
+    /**
+     * Destroy reactor.  Attached sources are detached first.
+     */
+    virtual ~Reactor();
+
+    /**
+     * Attach a source for a descriptor.  A source already attached is
+     * detached from its prior reactor first.
+     * @param object to attach.
+     * @param descriptor to wait on.
+     * @param events to wait for.
+     * @return true if attached.
+     */
+    bool attach(source *object, socket_t descriptor, unsigned events = READ);
+
+    /**
+     * Attach a source for a socket.
+     * @param object to attach.
+     * @param socket to wait on.
+     * @param events to wait for.
+     * @return true if attached.
+     */
+    inline bool attach(source *object, const Socket& socket, unsigned events = READ) {
+        return attach(object, *socket, events);
+    }
+
+    /**
+     * Attach a source for a listener.
+     * @param object to attach.
+     * @param socket to accept from.
+     * @return true if attached.
+     */
+    inline bool attach(source *object, const ListenSocket& socket) {
+        return attach(object, *socket, READ);
+    }
+
+    /**
+     * Attach a source for a file or pipe descriptor.
+     * @param object to attach.
+     * @param file to wait on.
+     * @param events to wait for.
+     * @return true if attached.
+     */
+    inline bool attach(source *object, const fsys& file, unsigned events = READ) {
+        return attach(object, (socket_t)(*file), events);
+    }
+
+    /**
+     * Change the events an attached source waits for.
+     * @param object to change.
+     * @param events to wait for.
+     * @return true if changed.
+     */
+    bool wait(source *object, unsigned events);
+
+    /**
+     * Detach a source.  A source detached from a callback will not be
+     * called again, even if its descriptor was also ready.
+     * @param object to detach.
+     */
+    void detach(source *object);
+
+    /**
+     * Expire timers and then wait for and dispatch ready sources once.
+     * @param timeout to wait if no timer expires sooner.
+     * @return number of sources called back.
+     */
+    unsigned dispatch(timeout_t timeout = Timer::inf);
+
+    /**
+     * Dispatch sources and timers until stopped.
+     */
+    void run(void);
+
+    /**
+     * Stop the loop.  This may be called from another thread or from a
+     * callback.
+     */
+    void stop(void);
+
+    /**
+     * Wake the loop from another thread so it re-examines timers.
+     */
+    void wakeup(void);
+
+    /**
+     * Get number of attached sources.
+     * @return count of sources.
+     */
+    inline size_t count(void) const {
+        return sources;
+    }
+};
+
+/**
+ * A convenience type for reactor sources.
+ */
+typedef Reactor::source reactor_source;
+
+} // namespace ucommon
+
+#endif
+
+#endif
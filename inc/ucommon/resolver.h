@@ -0,0 +1,203 @@
+// Copyright (C) 2015-2020 Cherokees of Idaho.
+//
+// This file is part of GNU uCommon C++.
+//
+// GNU uCommon C++ is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// GNU uCommon C++ is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with GNU uCommon C++.  If not, see <http://www.gnu.org/licenses/>.
+
+/**
+ * Caching and asynchronous host name resolver.  Lookups are remembered
+ * for a time, both those that found addresses and those that failed, and
+ * may be made from a pool of resolver threads that call back when done.
+ * A resolver may be installed for socket addresses, so that every name
+ * lookup made by sockets uses its cache.
+ * @file ucommon/resolver.h
+ */
+
+#ifndef _UCOMMON_RESOLVER_H_
+#define _UCOMMON_RESOLVER_H_
+
+#ifndef _UCOMMON_CPR_H_
+#include <ucommon/cpr.h>
+#endif
+
+#ifndef _UCOMMON_ATOMIC_H_
+#include <ucommon/atomic.h>
+#endif
+
+#ifndef _UCOMMON_TIMERS_H_
+#include <ucommon/timers.h>
+#endif
+
+#ifndef _UCOMMON_SOCKET_H_
+#include <ucommon/socket.h>
+#endif
+
+namespace ucommon {
+
+/**
+ * A host name resolver with a cache and a pool of lookup threads.  Found
+ * addresses are kept for the positive time to live, and failed lookups for
+ * the negative one, since getaddrinfo does not report the time to live of
+ * the records it finds.  Cached lookups return a new address list, which
+ * is released with freeaddrinfo as usual.  Asynchronous lookups queue a
+ * request that is called back from a resolver thread when done.
+ * @author David Sugar <dyfet@gnutelephony.org>
+ */
+class __EXPORT Resolver
+{
+private:
+    __DELETE_COPY(Resolver);
+
+public:
+    /**
+     * An asynchronous lookup.  This is used as a base class for objects
+     * that override the completed callback, and holds the address list
+     * found once the lookup is done.
+     * @author David Sugar <dyfet@gnutelephony.org>
+     */
+    class __EXPORT request
+    {
+    private:
+        __DELETE_COPY(request);
+
+        friend class Resolver;
+
+        request *next;
+        char *host, *service;
+        struct addrinfo hint;
+        struct addrinfo *list;
+        int err;
+        mutable Atomic::counter busy;
+
+    protected:
+        /**
+         * Called from a resolver thread when the lookup is done.
+         */
+        virtual void completed(void);
+
+    public:
+        /**
+         * Create an idle request.
+         */
+        request();
+
+        /**
+         * Destroy request.  It must not be busy.
+         */
+        virtual ~request();
+
+        /**
+         * Get the addresses found.  These belong to the request until
+         * it is reused or destroyed.
+         * @return address list or NULL if none found.
+         */
+        inline struct addrinfo *result(void) const {
+            return list;
+        }
+
+        /**
+         * Take the addresses found from the request.
+         * @return address list to release with freeaddrinfo, or NULL.
+         */
+        struct addrinfo *release(void);
+
+        /**
+         * Get error of a failed lookup.
+         * @return getaddrinfo error code or 0 if successful.
+         */
+        inline int error(void) const {
+            return err;
+        }
+
+        /**
+         * See if lookup is queued or in progress.  Once this is false the
+         * completed callback has returned and the request may be reused
+         * or destroyed.
+         * @return true if busy.
+         */
+        bool is_busy(void) const;
+    };
+
+private:
+    class Backend;
+
+    Backend *backend;
+
+public:
+    /**
+     * Create a resolver.
+     * @param threads to make asynchronous lookups from.
+     * @param ttl to keep found addresses for.
+     * @param negative ttl to keep failed lookups for.
+     * @param limit of lookups to keep.
+     */
+    Resolver(unsigned threads = 2, timeout_t ttl = 60000, timeout_t negative = 5000, unsigned limit = 1024);
+
+    /**
+     * Destroy resolver.  It is removed from sockets if installed, and
+     * requests still queued are called back as failed with EAI_AGAIN.
+     */
+    virtual ~Resolver();
+
+    /**
+     * Look up a host and service, using the cache if the same lookup was
+     * done recently.  Lookups for a canonical name, for a numeric host,
+     * or for no host at all, are always passed to getaddrinfo.
+     * @param host name to look up.
+     * @param service id or port to look up.
+     * @param hint of family, type, and flags of lookup.
+     * @param result list of addresses found, released with freeaddrinfo.
+     * @return 0 on success or getaddrinfo error code.
+     */
+    int lookup(const char *host, const char *service, const struct addrinfo *hint, struct addrinfo **result);
+
+    /**
+     * Queue a lookup for a resolver thread.  A lookup found in the cache
+     * is called back before this returns.
+     * @param object to call back.
+     * @param host name to look up.
+     * @param service id or port to look up, or NULL.
+     * @param hint of family, type, and flags of lookup, or NULL.
+     * @return true if queued.
+     */
+    bool lookup(request *object, const char *host, const char *service = NULL, const struct addrinfo *hint = NULL);
+
+    /**
+     * Remove all lookups from the cache.
+     */
+    void clear(void);
+
+    /**
+     * Get number of lookups in the cache, including expired ones not yet
+     * removed.
+     * @return count of cached lookups.
+     */
+    size_t count(void) const;
+
+    /**
+     * Use this resolver for every host name lookup made by sockets.  Only
+     * one resolver may be installed at a time.
+     */
+    void install(void);
+
+    /**
+     * Remove the installed resolver from sockets, which then use
+     * getaddrinfo directly again.
+     */
+    static void release(void);
+};
+
+} // namespace ucommon
+
+#endif
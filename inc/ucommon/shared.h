@@ -110,6 +110,136 @@ public:
 	}
 };
 
+/**
+ * Read-copy-update shared reference for read-mostly shared data.  Readers
+ * enter a short read section that only marks their own thread record, and
+ * then use the current object without retaining it, so readers never
+ * write to shared cache lines.  When the reference is replaced, the prior
+ * object is retired and only released once every read section that may
+ * have seen it has ended.  The final release of the object then goes
+ * through the TypeRelease it was created with.
+ * @author David Sugar <dyfet@gnutelephony.org>
+ */
+class __EXPORT RCURef : protected TypeRef
+{
+private:
+	__DELETE_COPY(RCURef);
+
+protected:
+	Mutex lock;
+	Atomic::counter version;
+
+	/**
+	 * A read section.  While a reader exists in a thread the object
+	 * it references cannot be released.  Read sections may be nested.
+	 */
+	class __EXPORT Reader
+	{
+	private:
+		__DELETE_COPY(Reader);
+
+	protected:
+		friend class RCURef;
+
+		void *record;
+		Counted *object;
+
+		Reader(RCURef& from);
+		~Reader();
+	};
+
+	RCURef();
+	~RCURef();
+
+	/**
+	 * Get current object from within a read section.
+	 * @return current object or NULL.
+	 */
+	Counted *read(void);
+
+	/**
+	 * Replace current object, retiring the prior one.
+	 * @param object to make current.
+	 */
+	void get(TypeRef& object);
+
+	/**
+	 * Retain a copy of the current object.
+	 * @param object to set to current object.
+	 */
+	void put(TypeRef& object);
+
+public:
+	/**
+	 * Release retired objects that no read section can still reference.
+	 * This is also done whenever a reference is replaced, when a thread
+	 * that read a reference exits, and when the process exits.
+	 * @return number of objects released.
+	 */
+	static unsigned reclaim(void);
+};
+
+template<typename T>
+class rcuref : private RCURef
+{
+private:
+	__DELETE_COPY(rcuref);
+
+public:
+	/**
+	 * Read access to the current object of an rcuref.  The object stays
+	 * valid for the life of the reader even if the rcuref is replaced.
+	 */
+	class reader : private RCURef::Reader
+	{
+	public:
+		inline reader(rcuref& from) : Reader(from) {};
+
+		inline const T* operator->() const {
+			return typeref<T>::data(object);
+		}
+
+		inline const T& operator*() const {
+			const T* v = typeref<T>::data(object);
+			__THROW_DEREF(v);
+			return *v;
+		}
+
+		inline operator bool() const {
+			return object != NULL;
+		}
+
+		inline bool operator!() const {
+			return object == NULL;
+		}
+	};
+
+	inline rcuref() : RCURef() {};
+
+	inline operator typeref<T>() {
+		typeref<T> ptr;
+		RCURef::put(ptr);
+		return ptr;
+	}
+
+	inline typeref<T> operator*() {
+		typeref<T> ptr;
+		RCURef::put(ptr);
+		return ptr;
+	}
+
+	inline rcuref& operator=(typeref<T> ptr) {
+		RCURef::get(ptr);
+		return *this;
+	}
+
+	inline rcuref& operator=(T obj) {
+		typeref<T> ptr(obj);
+		RCURef::get(ptr);
+		return *this;
+	}
+};
+
 class __EXPORT MappedPointer
 {
 private:
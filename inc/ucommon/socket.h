@@ -155,6 +155,8 @@ struct sockaddr_storage
 
 namespace ucommon {
 
+class RWLock;
+
 /**
  * A class to hold internet segment routing rules.  This class can be used
  * to provide a stand-alone representation of a cidr block of internet
@@ -234,6 +236,65 @@ public:
      */
     static const cidr *container(const policy *policy, const struct sockaddr *address);
 
+    /**
+     * A compiled index of a cidr policy chain.  The cidr blocks are
+     * kept in a path compressed prefix trie for each address family, so a
+     * lookup takes time by prefix length rather than by policy size.  The
+     * compiled index is immutable, and is rebuilt and swapped in whole when
+     * the policy changes, so lookups may continue from other threads while
+     * a reload is done.  The cidr entries it returns are from the policy
+     * chain, which must remain valid while it is indexed.
+     * @author David Sugar <dyfet@gnutelephony.org>
+     */
+    class __EXPORT index
+    {
+    private:
+        __DELETE_COPY(index);
+
+        class table;
+
+        table *current;
+        RWLock *lock;
+
+    public:
+        /**
+         * Create an empty index.
+         */
+        index();
+
+        /**
+         * Create an index of a policy chain.
+         * @param policy chain to index.
+         */
+        index(const policy *policy);
+
+        /**
+         * Destroy index.
+         */
+        ~index();
+
+        /**
+         * Rebuild from a policy chain and swap in the result.
+         * @param policy chain to index, or NULL to clear.
+         */
+        void update(const policy *policy);
+
+        /**
+         * Find the smallest cidr entry that matches the socket address.
+         * @param address to search for.
+         * @return smallest cidr or NULL if none match.
+         */
+        const cidr *find(const struct sockaddr *address) const;
+
+        /**
+         * Get the largest container cidr entry that matches the socket
+         * address.
+         * @param address to search for.
+         * @return largest cidr or NULL if none match.
+         */
+        const cidr *container(const struct sockaddr *address) const;
+    };
+
     /**
      * Get the saved name of our cidr.  This is typically used with find
      * when the same policy name might be associated with multiple non-
@@ -336,6 +397,22 @@ public:
     typedef struct hostaddr_internet host_t;
     typedef cidr cidr_t;
 
+    /**
+     * A datagram for batched send and receive.  To receive, data and size
+     * describe the buffer, and length, the sender address if one is given,
+     * and the coalesced segment size are filled in.  To send, size is the
+     * length of data, address is the destination or NULL if connected, and
+     * a non-zero segment size has the data sent as a series of datagrams of
+     * that size.
+     */
+    typedef struct {
+        void *data;
+        size_t size;
+        size_t length;
+        struct sockaddr_storage *address;
+        size_t segment;
+    } datagram_t;
+
     /**
      * Get an address list directly.  This is used internally by some derived
      * socket types when generic address lists would be invalid.
@@ -353,6 +430,31 @@ public:
      */
     static void release(struct addrinfo *list);
 
+    /**
+     * A host name lookup handler.  This has the same arguments and result
+     * as getaddrinfo, and must return a list that freeaddrinfo can release.
+     */
+    typedef int (*resolver_t)(const char *host, const char *service, const struct addrinfo *hint, struct addrinfo **result);
+
+    /**
+     * Look up a host and service.  Socket addresses and queries resolve
+     * names through this, which passes them to an installed resolver,
+     * or to getaddrinfo if none is installed.
+     * @param host name to look up.
+     * @param service id or port to look up.
+     * @param hint of family, type, and flags of lookup.
+     * @param result list of addresses found, released with freeaddrinfo.
+     * @return 0 on success or getaddrinfo error code.
+     */
+    static int resolve(const char *host, const char *service, const struct addrinfo *hint, struct addrinfo **result);
+
+    /**
+     * Install a handler for host name lookups.  This should be done
+     * before lookups are made from other threads.
+     * @param handler to use, or NULL to use getaddrinfo.
+     */
+    static void resolver(resolver_t handler);
+
     /**
      * A generic socket address class.  This class uses the addrinfo list
      * to store socket multiple addresses in a protocol and family
@@ -849,6 +951,107 @@ public:
 
     friend class address;
 
+    /**
+     * A receive buffer for stream sockets.  Input is read into the buffer
+     * with one recv for as much as will fit, and lines are then found in
+     * what was buffered, so a line protocol needs no peek before each read.
+     * Unread input slides to the front only when the end of the buffer is
+     * reached, which keeps every line contiguous so it can be viewed in
+     * place.  This may be used directly with a socket descriptor, or
+     * attached to a socket object with Socket::buffering.
+     * @author David Sugar <dyfet@gnutelephony.org>
+     */
+    class __EXPORT buffer
+    {
+    private:
+        __DELETE_COPY(buffer);
+
+        char *data;
+        size_t size, head, tail, scan;
+
+        ssize_t locate(socket_t socket, size_t limit, timeout_t timeout, bool& found);
+
+    public:
+        /**
+         * Create a receive buffer.
+         * @param size of buffer, which is also the longest line.
+         */
+        buffer(size_t size = 2048);
+
+        /**
+         * Release buffer memory.
+         */
+        ~buffer();
+
+        /**
+         * Receive once into the free space of the buffer.
+         * @param socket to receive from.
+         * @return bytes received, 0 on eof, -1 on error.
+         */
+        ssize_t fill(socket_t socket);
+
+        /**
+         * Read data, using buffered input first.  If nothing is buffered
+         * and the request is at least as large as the buffer, the data is
+         * received directly.
+         * @param socket to receive from.
+         * @param data to save input in.
+         * @param size of data to read.
+         * @param timeout to wait for input.
+         * @return bytes read, 0 if none, -1 on error.
+         */
+        ssize_t read(socket_t socket, void *data, size_t size, timeout_t timeout = Timer::inf);
+
+        /**
+         * Read a line of input into a string, dropping the newline, as
+         * Socket::readline does.
+         * @param socket to receive from.
+         * @param data to save input line.
+         * @param size of input line buffer.
+         * @param timeout to wait for a complete input line.
+         * @return bytes consumed, 0 if none, -1 on error.
+         */
+        ssize_t readline(socket_t socket, char *data, size_t size, timeout_t timeout = Timer::inf);
+
+        /**
+         * View the next line of input in place.  The newline is replaced
+         * with a null byte, and the line stays valid until the buffer is
+         * next used.  A line longer than the buffer is returned in pieces.
+         * @param socket to receive from.
+         * @param length of line, without newline, saved here.
+         * @param timeout to wait for a complete input line.
+         * @return line or NULL if none.
+         */
+        const char *getline(socket_t socket, size_t& length, timeout_t timeout = Timer::inf);
+
+        /**
+         * Drop any buffered input.
+         */
+        inline void clear(void) {
+            head = tail = scan = 0;
+        }
+
+        /**
+         * Get number of bytes buffered and not yet read.
+         * @return bytes buffered.
+         */
+        inline size_t pending(void) const {
+            return tail - head;
+        }
+
+        /**
+         * Get size of buffer.
+         * @return size of buffer.
+         */
+        inline size_t max(void) const {
+            return size;
+        }
+    };
+
+protected:
+    buffer *input;
+
+public:
     /**
      * Create a socket object for use.
      */
@@ -971,9 +1174,31 @@ public:
      * @return bytes pending.
      */
     inline unsigned pending(void) const {
+        if(input)
+            return (unsigned)input->pending() + pending(so);
         return pending(so);
     }
 
+    /**
+     * Keep a receive buffer for this socket, which is then used by
+     * readline, readfrom, and getline.  This should only be used for
+     * stream sockets, and input that is already buffered is lost if the
+     * buffer is changed or removed.
+     * @param size of buffer, or 0 to remove it.
+     * @return true if buffer set.
+     */
+    bool buffering(size_t size = 2048);
+
+    /**
+     * View the next line of input in place in the receive buffer, without
+     * copying.  The trailing newline is dropped.  The line stays valid
+     * until the socket is next read from.  A receive buffer is created if
+     * there is none.
+     * @param length of line saved here.
+     * @return line or NULL if none.
+     */
+    const char *getline(size_t& length);
+
     /**
      * Set socket for unicast mode broadcasts.
      * @param enable broadcasting if true.
@@ -1208,8 +1433,8 @@ public:
     /**
      * Read a newline of text data from the socket and save in NULL terminated
      * string.  This uses an optimized I/O method that takes advantage of
-     * socket peeking.  This presumes a connected socket on a streamble
-     * protocol.  Because the trailing newline is dropped, the return size
+     * socket peeking, or the receive buffer if buffering is set.  This
+     * presumes a connected socket on a streamble protocol.  Because the trailing newline is dropped, the return size
      * may be greater than the string length.  If there was no data read
      * because of eof of data, an error has occured, or timeout without
      * input, then 0 will be returned.
@@ -1418,6 +1643,16 @@ public:
      */
     static int broadcast(socket_t socket, bool enable);
 
+    /**
+     * Set udp receive offload on socket descriptor, so that a run of
+     * datagrams from one sender may be received together as one buffer.
+     * The segment size is then reported with the datagram in recvbatch.
+     * @param socket descriptor.
+     * @param enable coalescing if true.
+     * @return 0 on success or error code.
+     */
+    static int coalesce(socket_t socket, bool enable);
+
     /**
      * Set tcp nodelay option on socket descriptor.
      * @param socket descriptor.
@@ -1495,6 +1730,40 @@ public:
      */
     static ssize_t sendto(socket_t socket, const void *buffer, size_t size, int flags = 0, const struct sockaddr *address = NULL);
 
+    /**
+     * Get a batch of datagrams waiting in receive queue.  This waits for
+     * the first datagram if the socket is blocking, and then takes what is
+     * already queued up to count.
+     * @param socket to get from.
+     * @param list of datagrams to receive into.
+     * @param count of datagrams in list.
+     * @param flags for i/o operation (MSG_PEEK, etc).
+     * @return number of datagrams received, -1 if error.
+     */
+    static ssize_t recvbatch(socket_t socket, datagram_t *list, unsigned count, int flags = 0);
+
+    /**
+     * Send a batch of datagrams on socket.
+     * @param socket to send to.
+     * @param list of datagrams to send.
+     * @param count of datagrams in list.
+     * @param flags for i/o operation (MSG_DONTWAIT, etc).
+     * @return number of datagrams sent, -1 if error.
+     */
+    static ssize_t sendbatch(socket_t socket, const datagram_t *list, unsigned count, int flags = 0);
+
+    /**
+     * Send part of a file on a socket.  The kernel copies the file data
+     * to the socket directly where it can, and otherwise the file is read
+     * and sent in blocks.
+     * @param socket to send to.
+     * @param file descriptor to send from.
+     * @param offset in file to start from, or -1 for current position.
+     * @param size of data to send.
+     * @return number of bytes sent, -1 if error.
+     */
+    static ssize_t sendfile(socket_t socket, fd_t file, off_t offset, size_t size);
+
     /**
      * Send reply on socket.  Used to reply to a recvfrom message.
      * @param socket to send to.
@@ -225,6 +225,28 @@ public:
      * socket but is a disconnect.
      */
     void close(void);
+
+    /**
+     * Send part of a file on the stream connection.  Pending stream output
+     * is flushed first, and the file data is then passed to the kernel
+     * directly rather than copied through the stream buffer.
+     * @param file descriptor to send from.
+     * @param offset in file to start from, or -1 for current position.
+     * @param size of data to send.
+     * @return number of bytes sent, -1 if error.
+     */
+    ssize_t sendfile(fd_t file, off_t offset, size_t size);
+
+    /**
+     * Send part of an open file on the stream connection.
+     * @param file to send from.
+     * @param offset in file to start from, or -1 for current position.
+     * @param size of data to send.
+     * @return number of bytes sent, -1 if error.
+     */
+    inline ssize_t sendfile(const fsys& file, off_t offset, size_t size) {
+        return sendfile(*file, offset, size);
+    }
 };
 
 /**
@@ -131,6 +131,84 @@ public:
         }
     };
 
+    /**
+     * A set of characters to scan text for.  The set is kept as a table
+     * indexed by the low and high half of each character, so that vector
+     * instructions can test sixteen or thirty two characters at a time
+     * where the processor supports them.
+     * @author David Sugar <dyfet@gnutelephony.org>
+     */
+    class __EXPORT charset
+    {
+    private:
+        uint8_t map[32];
+
+    public:
+        /**
+         * Create a set from a list of characters.
+         * @param list of characters in set, or NULL for empty set.
+         */
+        charset(const char *list);
+
+        /**
+         * Test if a character is in the set.
+         * @param ch to test.
+         * @return true if in set.
+         */
+        inline bool test(char ch) const {
+            unsigned char code = (unsigned char)ch;
+            return ((map[((code >> 3) & 0x10) | (code & 0x0f)] >> ((code >> 4) & 0x07)) & 1) != 0;
+        }
+
+        /**
+         * Find first character of text in the set.
+         * @param text to scan.
+         * @param size of text.
+         * @return pointer to character or NULL if none.
+         */
+        const char *find(const char *text, size_t size) const;
+
+        /**
+         * Find first character of text not in the set.
+         * @param text to scan.
+         * @param size of text.
+         * @return pointer to character or NULL if none.
+         */
+        const char *skip(const char *text, size_t size) const;
+
+        /**
+         * Find last character of text in the set.
+         * @param text to scan.
+         * @param size of text.
+         * @return pointer to character or NULL if none.
+         */
+        const char *rfind(const char *text, size_t size) const;
+
+        /**
+         * Find last character of text not in the set.
+         * @param text to scan.
+         * @param size of text.
+         * @return pointer to character or NULL if none.
+         */
+        const char *rskip(const char *text, size_t size) const;
+
+        /**
+         * Count leading characters of null terminated text in the set,
+         * like strspn.
+         * @param text to scan.
+         * @return count of characters.
+         */
+        size_t span(const char *text) const;
+
+        /**
+         * Count leading characters of null terminated text not in the set,
+         * like strcspn.
+         * @param text to scan.
+         * @return count of characters.
+         */
+        size_t cspan(const char *text) const;
+    };
+
     class __EXPORT cstring : public CountedObject
     {
     private:
@@ -1063,6 +1141,19 @@ public:
      */
     static char *add(char *buffer, size_t size, const char *text, size_t max);
 
+    /**
+     * Find a substring within text of a known size.  Vector instructions
+     * are used where the processor supports them.  Case insensitive search
+     * folds ascii letters only.
+     * @param text to search in.
+     * @param size of text.
+     * @param substring to locate.
+     * @param length of substring.
+     * @param flags for case insensitive search.
+     * @return substring position if found, or NULL.
+     */
+    static const char *search(const char *text, size_t size, const char *substring, size_t length, unsigned flags = 0);
+
     /**
      * Find position of case insensitive substring within a string.
      * @param text to search in.
@@ -0,0 +1,273 @@
+// Copyright (C) 2015-2020 Cherokees of Idaho.
+//
+// This file is part of GNU uCommon C++.
+//
+// GNU uCommon C++ is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// GNU uCommon C++ is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with GNU uCommon C++.  If not, see <http://www.gnu.org/licenses/>.
+
+/**
+ * A pool of threads to run tasks on.  Each pool thread keeps its own
+ * queue of tasks, and threads that run out of work steal from the others,
+ * so that tasks which create more tasks spread across the pool without
+ * contending on one shared queue.
+ * @file ucommon/taskpool.h
+ */
+
+#ifndef _UCOMMON_TASKPOOL_H_
+#define _UCOMMON_TASKPOOL_H_
+
+#ifndef _UCOMMON_CPR_H_
+#include <ucommon/cpr.h>
+#endif
+
+#ifndef _UCOMMON_ATOMIC_H_
+#include <ucommon/atomic.h>
+#endif
+
+#ifndef _UCOMMON_TIMERS_H_
+#include <ucommon/timers.h>
+#endif
+
+namespace ucommon {
+
+/**
+ * A work stealing pool of threads.  Tasks submitted from a pool thread are
+ * pushed on that thread's own deque and run newest first, while idle pool
+ * threads steal the oldest task from another.  Tasks submitted from other
+ * threads go on a shared queue.  Pool threads with nothing to do sleep
+ * until more tasks are submitted.  A task may be joined to wait for it to
+ * finish, and pool threads that join help run other tasks while waiting.
+ * @author David Sugar <dyfet@gnutelephony.org>
+ */
+class __EXPORT TaskPool
+{
+private:
+    __DELETE_COPY(TaskPool);
+
+public:
+    class job;
+
+    /**
+     * A unit of work to run on the pool.  This is used as a base class
+     * for objects that override the run method.  A task must stay alive
+     * and is busy from when it is submitted until it has run.
+     * @author David Sugar <dyfet@gnutelephony.org>
+     */
+    class __EXPORT task
+    {
+    private:
+        __DELETE_COPY(task);
+
+        friend class TaskPool;
+        friend class job;
+
+        task *next;
+        TaskPool *owner;
+        bool counted;
+        mutable Atomic::counter busy;
+
+    protected:
+        /**
+         * Work to do, called from a pool thread.
+         */
+        virtual void run(void) = 0;
+
+    public:
+        /**
+         * Create an idle task.
+         */
+        task();
+
+        /**
+         * Destroy task.  It must not be busy.
+         */
+        virtual ~task();
+
+        /**
+         * See if task is queued or running.
+         * @return true if busy.
+         */
+        bool is_busy(void) const;
+
+        /**
+         * Wait for the task to finish running.
+         * @param timeout to wait.
+         * @return true if finished, false if timed out.
+         */
+        bool join(timeout_t timeout = Timer::inf);
+    };
+
+    /**
+     * A reference counted task.  The pool holds a reference while the
+     * job is queued or running, so that a job may be submitted and
+     * forgotten, or waited on through futures that reference it.  A job is
+     * deleted when the last reference is released, and so must be created
+     * with new.
+     * @author David Sugar <dyfet@gnutelephony.org>
+     */
+    class __EXPORT job : public task
+    {
+    private:
+        __DELETE_COPY(job);
+
+        Atomic::counter refs;
+
+    public:
+        /**
+         * Create an unreferenced job.
+         */
+        job();
+
+        /**
+         * Add a reference.
+         */
+        void retain(void);
+
+        /**
+         * Remove a reference, deleting the job if it was the last.
+         */
+        void release(void);
+    };
+
+    /**
+     * A job that calls a copy of a function object.  Any functor or
+     * plain function that can be called with no arguments may be used.
+     * @author David Sugar <dyfet@gnutelephony.org>
+     */
+    template<typename F>
+    class call : public job
+    {
+    private:
+        __DELETE_COPY(call);
+
+        F function;
+
+    protected:
+        void run(void) __OVERRIDE {
+            function();
+        }
+
+    public:
+        inline call(const F& object) : job(), function(object) {}
+    };
+
+    /**
+     * A reference to a submitted job, used to wait for it to finish.
+     * Copies share the same job, which is kept until every copy and the
+     * pool are done with it.
+     * @author David Sugar <dyfet@gnutelephony.org>
+     */
+    class __EXPORT future
+    {
+    private:
+        job *ref;
+
+    public:
+        future();
+
+        future(job *object);
+
+        future(const future& copy);
+
+        ~future();
+
+        future& operator=(const future& copy);
+
+        /**
+         * Wait for the job to finish running.
+         * @param timeout to wait.
+         * @return true if finished or empty, false if timed out.
+         */
+        bool join(timeout_t timeout = Timer::inf);
+
+        /**
+         * See if the job is still queued or running.
+         * @return true if busy.
+         */
+        bool is_busy(void) const;
+
+        /**
+         * Drop our reference to the job.
+         */
+        void clear(void);
+
+        inline operator bool() const {
+            return ref != NULL;
+        }
+
+        inline bool operator!() const {
+            return ref == NULL;
+        }
+    };
+
+private:
+    class Backend;
+
+    Backend *backend;
+
+public:
+    /**
+     * Create and start a pool of threads.
+     * @param threads in pool, or 0 for one per processor.
+     * @param affinity to bind each pool thread to its own processor.
+     * @param stack size of pool threads or 0 for default.
+     */
+    TaskPool(unsigned threads = 0, bool affinity = false, size_t stack = 0);
+
+    /**
+     * Stop and destroy pool.  Tasks already queued are run first.
+     */
+    virtual ~TaskPool();
+
+    /**
+     * Queue a task to run on the pool.
+     * @param object to run.
+     * @return true if queued, false if already busy.
+     */
+    bool submit(task *object);
+
+    /**
+     * Queue a copy of a function object to run on the pool.
+     * @param function to call.
+     * @return future of job.
+     */
+    template<typename F>
+    inline future async(const F& function) {
+        call<F> *object = new call<F>(function);
+        future result(object);
+        submit(object);
+        return result;
+    }
+
+    /**
+     * Wait until no tasks are queued or running.  This is not called
+     * from a task, which would wait on itself.
+     */
+    void wait(void);
+
+    /**
+     * Get number of threads in pool.
+     * @return thread count.
+     */
+    unsigned size(void) const;
+
+    /**
+     * Get number of tasks queued or running.
+     * @return pending task count.
+     */
+    unsigned pending(void) const;
+};
+
+} // namespace ucommon
+
+#endif
@@ -768,6 +768,20 @@ public:
      */
     static size_t cache(void);
 
+    /**
+     * Get number of processors online.
+     * @return processor count, at least 1.
+     */
+    static unsigned cpus(void);
+
+    /**
+     * Bind the current thread to run only on a given processor.  This is
+     * a hint, and does nothing where affinity is not supported.
+     * @param cpu to run on, counting from 0.
+     * @return true if bound.
+     */
+    static bool affinity(unsigned cpu);
+
     /**
      * Used to specify scheduling policy for threads above priority "0".
      * Normally we apply static realtime policy SCHED_FIFO (default) or
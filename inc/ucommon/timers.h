@@ -284,6 +284,10 @@ public:
     private:
         __DELETE_DEFAULTS(event);
 
+        event *slot_next, *slot_prev;
+        Timer::tick_t deadline;
+        unsigned slot;
+
     protected:
         friend class TimerQueue;
 
@@ -354,7 +358,9 @@ public:
         }
 
         /**
-         * Notify timer queue that the timer has been updated.
+         * Notify timer queue that the timer has been updated.  This must
+         * be called if the timer is changed directly rather than through
+         * arm or disarm, so the queue can reschedule it.
          */
         void update(void);
 
@@ -367,9 +373,35 @@ public:
         }
     };
 
+private:
+    class Wheel;
+
+    Wheel *wheel;
+
+    void link(event *timer, unsigned slot);
+    void unlink(event *timer);
+    void place(event *timer);
+    void advance(Timer::tick_t now);
+    timeout_t first(Timer::tick_t now);
+
 protected:
     friend class event;
 
+    /**
+     * Schedule an attached event on the timer wheel from its current
+     * timer, or take it off the wheel if the timer is not armed.
+     * @param timer event to schedule.
+     */
+    void schedule(event *timer);
+
+    /**
+     * Take an event off the timer wheel.  Also used when the event is
+     * being detached so an expire in progress will not touch it again.
+     * @param timer event to cancel.
+     * @param detach true if event is leaving the queue.
+     */
+    void cancel(event *timer, bool detach = false);
+
     /**
      * Called in derived class when the queue is being modified.
      * This is often used to lock the list.
@@ -410,7 +442,11 @@ public:
      * Process timer queue and find when next event triggers.  This function
      * will call the expired methods on expired timers.  Normally this function
      * will be called in the context of a timer thread which sleeps for the
-     * timeout returned unless it is awoken on an update event.
+     * timeout returned unless it is awoken on an update event.  Armed events
+     * are kept on a hierarchical timing wheel of millisecond slots, so only
+     * the events that are due are visited, rather than every event that is
+     * attached to the queue.  If an expired event is left armed, it is placed
+     * back on the wheel for the timeout it returns.
      * @return timeout until next timer expires in milliseconds.
      */
     timeout_t expire();
@@ -71,6 +71,8 @@ protected:
 	friend class ArrayRef;
 	friend class SharedRef;
 	friend class MapRef;
+	friend class FlatRef;
+	friend class RCURef;
 	friend class TypeRelease;
 
 	class Release;
@@ -422,6 +424,20 @@ public:
 		TypeRef::set(new(mem(p)) value(p, object, pool));
 	}
 
+	/**
+	 * Get data of a heap container without retaining it.  This is used
+	 * when something else assures the container stays referenced.
+	 * @param object container to access.
+	 * @return data of container or NULL.
+	 */
+	inline static const T* data(Counted *object) {
+		value *v = polystatic_cast<value *>(object);
+		if(!v)
+			return nullptr;
+
+		return &(v->data);
+	}
+
 	inline typeref& operator=(T& object) {
 		set(object);
 		return *this;
@@ -107,8 +107,13 @@
 #include <ucommon/thread.h>
 #include <ucommon/arrayref.h>
 #include <ucommon/mapref.h>
+#include <ucommon/flatmap.h>
 #include <ucommon/shared.h>
 #include <ucommon/fsys.h>
+#include <ucommon/reactor.h>
+#include <ucommon/asyncio.h>
+#include <ucommon/resolver.h>
+#include <ucommon/taskpool.h>
 #include <ucommon/temporary.h>
 #include <ucommon/shell.h>
 
@@ -0,0 +1,192 @@
+// Copyright (C) 2015-2020 Cherokees of Idaho.
+//
+// This file is part of GNU uCommon C++.
+//
+// GNU uCommon C++ is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// GNU uCommon C++ is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with GNU uCommon C++.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include <commoncpp/commoncpp.h>
+
+#include <stdio.h>
+#include <string.h>
+
+using namespace ost;
+
+#define LOG_THREADS     4
+#define LOG_MESSAGES    500
+#define QUEUE_THREADS   4
+#define QUEUE_MESSAGES  1000
+#define QUEUE_POOLSIZE  128
+
+static AppLog *applog = NULL;
+static ucommon::Barrier *started = NULL;
+
+class logThread : public Thread
+{
+public:
+    unsigned id;
+
+    logThread() : Thread() {}
+
+    void run(void) {
+        applog->subscribe();
+        applog->level(Slog::levelDebug);
+        started->wait();
+        for(unsigned pos = 0; pos < LOG_MESSAGES; ++pos)
+            applog->info("thread %u message %u\n", id, pos);
+    }
+};
+
+typedef struct {
+    unsigned id;
+    unsigned seq;
+    unsigned len;
+}   queued_t;
+
+// sizes on either side of the pool size, so posts both reuse kept items
+// and allocate their own...
+static unsigned queued_size(unsigned seq)
+{
+    static const unsigned sizes[] = {0, 20, QUEUE_POOLSIZE - sizeof(queued_t), 200, 1500};
+    return sizeof(queued_t) + sizes[seq % (sizeof(sizes) / sizeof(unsigned))];
+}
+
+class testQueue : public ThreadQueue
+{
+public:
+    unsigned delivered, bad;
+    unsigned next[QUEUE_THREADS];
+    ucommon::Semaphore done;
+
+    testQueue() : ThreadQueue("test", 0), done(1, 0) {
+        delivered = bad = 0;
+        memset(next, 0, sizeof(next));
+        setPool(16, QUEUE_POOLSIZE);
+    }
+
+    void runQueue(void *data) {
+        queued_t *msg = (queued_t *)data;
+        unsigned char *body = (unsigned char *)data + sizeof(queued_t);
+
+        if(msg->id >= QUEUE_THREADS || msg->seq != next[msg->id]++ || msg->len != queued_size(msg->seq))
+            ++bad;
+        else for(unsigned pos = 0; pos < msg->len - sizeof(queued_t); ++pos) {
+            if(body[pos] != (unsigned char)(msg->seq + pos)) {
+                ++bad;
+                break;
+            }
+        }
+        if(++delivered == QUEUE_THREADS * QUEUE_MESSAGES)
+            done.release();
+    }
+};
+
+static testQueue *queue = NULL;
+
+class postThread : public Thread
+{
+public:
+    unsigned id;
+
+    postThread() : Thread() {}
+
+    void run(void) {
+        unsigned char buf[sizeof(queued_t) + 1500];
+        queued_t *msg = (queued_t *)buf;
+
+        started->wait();
+        for(unsigned seq = 0; seq < QUEUE_MESSAGES; ++seq) {
+            msg->id = id;
+            msg->seq = seq;
+            msg->len = queued_size(seq);
+            for(unsigned pos = 0; pos < msg->len - sizeof(queued_t); ++pos)
+                buf[sizeof(queued_t) + pos] = (unsigned char)(seq + pos);
+            queue->post(buf, msg->len);
+        }
+    }
+};
+
+#ifndef _MSWINDOWS_
+static unsigned lines(const char *path)
+{
+    unsigned count = 0;
+    int ch;
+    FILE *fp = fopen(path, "r");
+
+    if(!fp)
+        return 0;
+
+    while(EOF != (ch = fgetc(fp))) {
+        if(ch == '\n')
+            ++count;
+    }
+    fclose(fp);
+    return count;
+}
+#endif
+
+extern "C" int main()
+{
+    // several threads post mixed sizes, and each message arrives whole and
+    // in the order its thread posted it; the queue thread is left to run
+    // until we exit...
+    postThread posters[QUEUE_THREADS];
+    bool finished;
+
+    queue = new testQueue();
+    started = new ucommon::Barrier(QUEUE_THREADS);
+    for(unsigned pos = 0; pos < QUEUE_THREADS; ++pos) {
+        posters[pos].id = pos;
+        posters[pos].start();
+    }
+    for(unsigned pos = 0; pos < QUEUE_THREADS; ++pos)
+        posters[pos].join();
+
+    finished = queue->done.wait(10000);
+    assert(finished);
+    assert(queue->delivered == QUEUE_THREADS * QUEUE_MESSAGES);
+    assert(queue->bad == 0);
+    delete started;
+
+#ifndef _MSWINDOWS_
+    // several threads log into a small ring, so some messages are dropped
+    // but every one is either written or counted...
+    const char *logfile = "commoncpp.log";
+    logThread threads[LOG_THREADS];
+    unsigned long dropped;
+
+    remove(logfile);
+    applog = new AppLog(logfile);
+    applog->asyncEnable(true, 8);
+    started = new ucommon::Barrier(LOG_THREADS);
+    for(unsigned pos = 0; pos < LOG_THREADS; ++pos) {
+        threads[pos].id = pos;
+        threads[pos].start();
+    }
+    for(unsigned pos = 0; pos < LOG_THREADS; ++pos)
+        threads[pos].join();
+
+    dropped = applog->asyncDropped();
+    applog->asyncEnable(false);
+    assert(lines(logfile) + dropped == LOG_THREADS * LOG_MESSAGES);
+
+    delete applog;
+    delete started;
+    remove(logfile);
+#endif
+    return 0;
+}
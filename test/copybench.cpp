@@ -0,0 +1,113 @@
+// Copyright (C) 2015-2020 Cherokees of Idaho.
+//
+// This file is part of GNU uCommon C++.
+//
+// GNU uCommon C++ is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// GNU uCommon C++ is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with GNU uCommon C++.  If not, see <http://www.gnu.org/licenses/>.
+
+// compare copy times of fsys::copy, with and without cloning, and of the
+// old loop through a 1k buffer.  Pass a file size in megabytes to change
+// the size.
+
+#include <ucommon/ucommon.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace ucommon;
+
+static unsigned long elapsed(Timer::tick_t start)
+{
+    return (unsigned long)((Timer::ticks() - start) / 10000);
+}
+
+static void generate(const char *path, int megabytes)
+{
+    char buf[65536];
+    FILE *fp = fopen(path, "w");
+
+    if(!fp)
+        return;
+
+    for(unsigned pos = 0; pos < sizeof(buf); ++pos)
+        buf[pos] = (char)(pos * 7);
+
+    for(int count = 0; count < megabytes * 16; ++count) {
+        buf[0] = (char)count;
+        fwrite(buf, 1, sizeof(buf), fp);
+    }
+    fclose(fp);
+}
+
+static int loop(const char *source, const char *target)
+{
+    char buf[1024];
+    ssize_t count;
+    fsys src, dest;
+
+    src.open(source, fsys::STREAM);
+    dest.open(target, fsys::GROUP_PUBLIC, fsys::STREAM);
+    if(!is(src) || !is(dest))
+        return EBADF;
+
+    while((count = src.read(buf, sizeof(buf))) > 0) {
+        if(dest.write(buf, count) != count)
+            return EIO;
+    }
+    return 0;
+}
+
+static void bench(const char *name, int megabytes, int result, Timer::tick_t start)
+{
+    unsigned long msec = elapsed(start);
+
+    if(!msec)
+        msec = 1;
+
+    printf("%-8s %8d MB: copy %6lu msec, %6lu MB/sec (%d)\n",
+        name, megabytes, msec, (unsigned long)megabytes * 1000ul / msec, result);
+}
+
+extern "C" int main(int argc, char **argv)
+{
+    const char *source = "copybench.src";
+    const char *target = "copybench.dst";
+    int megabytes = 256;
+    int result;
+
+    if(argc > 1)
+        megabytes = atoi(argv[1]);
+
+    if(megabytes < 1)
+        megabytes = 1;
+
+    generate(source, megabytes);
+
+    Timer::tick_t start = Timer::ticks();
+    result = fsys::copy(source, target);
+    bench("copy", megabytes, result, start);
+    fsys::erase(target);
+
+    start = Timer::ticks();
+    result = fsys::copy(source, target, fsys::COPY_NOCLONE, NULL);
+    bench("noclone", megabytes, result, start);
+    fsys::erase(target);
+
+    start = Timer::ticks();
+    result = loop(source, target);
+    bench("loop", megabytes, result, start);
+    fsys::erase(target);
+
+    fsys::erase(source);
+    return 0;
+}
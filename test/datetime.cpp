@@ -98,6 +98,25 @@ int main(int argc, char **argv)
     tmp += 5;   // add 5 seconds to force rollover...
     assert((long)tmp == 20030301l);
 
+    // cached local time and timestamps...
+    time_t now;
+    tm_t cached, *converted;
+    time(&now);
+    DateTime::local(cached, &now);
+    converted = DateTime::local(&now);
+    assert(cached.tm_mday == converted->tm_mday && cached.tm_sec == converted->tm_sec);
+    DateTime::release(converted);
+    now = 1000000000l;
+    DateTime::local(cached, &now);
+    converted = DateTime::local(&now);
+    assert(cached.tm_year == 101 && cached.tm_hour == converted->tm_hour);
+    DateTime::release(converted);
+    char stamp[24];
+    assert(DateTime::stamp(stamp, sizeof(stamp)) == 23);
+    assert(stamp[4] == '-' && stamp[10] == ' ' && stamp[19] == '.');
+    assert(DateTime::stamp(stamp, sizeof(stamp), false) == 19);
+    assert(DateTime::stamp(stamp, 11, false) == 10 && stamp[4] == '-');
+
     return 0;
 }
 
@@ -0,0 +1,141 @@
+// Copyright (C) 2015-2020 Cherokees of Idaho.
+//
+// This file is part of GNU uCommon C++.
+//
+// GNU uCommon C++ is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// GNU uCommon C++ is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with GNU uCommon C++.  If not, see <http://www.gnu.org/licenses/>.
+
+// example echo server that runs every connection from one reactor thread.
+// Pass an address and port to listen on, and an idle timeout in seconds
+// after which a quiet connection is closed.
+
+#include <ucommon/ucommon.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace ucommon;
+
+static Reactor loop(1024);
+static timeout_t idle = 30000;
+
+// a non-blocking socket that is not ready fails with one of these, and is
+// simply waited on again rather than closed...
+static bool again(void)
+{
+    int err = Socket::error();
+    return err == EAGAIN || err == EWOULDBLOCK || err == EINTR;
+}
+
+class client : public Reactor::source, public TQEvent
+{
+private:
+    char buffer[4096];
+    size_t pending;
+
+    // closing the socket is left to readable, which sees end of input...
+    void expired(void) __FINAL {
+        ::shutdown(handle(), SHUT_RDWR);
+    }
+
+    void readable(void) __FINAL {
+        ssize_t len = Socket::recvfrom(handle(), buffer, sizeof(buffer));
+        if(len < 0 && again())
+            return;
+        if(len < 1) {
+            delete this;
+            return;
+        }
+        pending = (size_t)len;
+        TQEvent::arm(idle);
+        writable();
+    }
+
+    void writable(void) __FINAL {
+        ssize_t len = Socket::sendto(handle(), buffer, pending);
+        if(len < 0 && again())
+            len = 0;
+        else if(len < 0) {
+            delete this;
+            return;
+        }
+        pending -= (size_t)len;
+        if(pending) {
+            memmove(buffer, buffer + len, pending);
+            Reactor::source::wait(Reactor::WRITE);
+        }
+        else
+            Reactor::source::wait(Reactor::READ);
+    }
+
+public:
+    client(socket_t so) : Reactor::source(), TQEvent(&loop, idle) {
+        pending = 0;
+        Socket::blocking(so, false);
+        loop.attach(this, so);
+    }
+
+    ~client() {
+        socket_t so = handle();
+        Reactor::source::detach();
+        Socket::release(so);
+    }
+};
+
+class listener : public Reactor::source
+{
+private:
+    ListenSocket server;
+
+    void readable(void) __FINAL {
+        socket_t so = server.accept();
+        if(so != INVALID_SOCKET)
+            new client(so);
+    }
+
+public:
+    listener(const char *address, const char *port) :
+    Reactor::source(), server(address, port, 64) {}
+
+    bool start(void) {
+        if(server.handle() == INVALID_SOCKET)
+            return false;
+        Socket::blocking(*server, false);
+        return loop.attach(this, server);
+    }
+};
+
+extern "C" int main(int argc, char **argv)
+{
+    const char *address = "127.0.0.1";
+    const char *port = "7777";
+
+    if(argc > 1)
+        address = argv[1];
+
+    if(argc > 2)
+        port = argv[2];
+
+    if(argc > 3)
+        idle = (timeout_t)atol(argv[3]) * 1000l;
+
+    listener server(address, port);
+    if(!server.start()) {
+        fprintf(stderr, "echoserver: cannot listen on %s:%s\n", address, port);
+        return 1;
+    }
+
+    printf("echoserver: listening on %s:%s\n", address, port);
+    loop.run();
+    return 0;
+}
@@ -0,0 +1,83 @@
+// Copyright (C) 2015-2020 Cherokees of Idaho.
+//
+// This file is part of GNU uCommon C++.
+//
+// GNU uCommon C++ is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// GNU uCommon C++ is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with GNU uCommon C++.  If not, see <http://www.gnu.org/licenses/>.
+
+// compare insert, lookup, and remove times of mapref and flatmap with
+// the same typeref keys and values.  Pass a key count to change the size.
+
+#include <ucommon/ucommon.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace ucommon;
+
+static unsigned long elapsed(Timer::tick_t start)
+{
+    return (unsigned long)((Timer::ticks() - start) / 10000);
+}
+
+template<typename M>
+static void bench(const char *name, M& map, int keys)
+{
+    Timer::tick_t start = Timer::ticks();
+    int key;
+    long sum = 0;
+
+    for(key = 0; key < keys; ++key)
+        map(key, key);
+    unsigned long insert = elapsed(start);
+
+    start = Timer::ticks();
+    for(int pass = 0; pass < 4; ++pass) {
+        for(key = 0; key < keys * 2; ++key) {
+            typeref<int> v = map(key);
+            if(is(v))
+                sum += *v;
+        }
+    }
+    unsigned long lookup = elapsed(start);
+
+    start = Timer::ticks();
+    for(key = 0; key < keys; ++key)
+        map.remove(key);
+    unsigned long remove = elapsed(start);
+
+    printf("%-8s %8d keys: insert %6lu msec, lookup %6lu msec, remove %6lu msec (%ld)\n",
+        name, keys, insert, lookup, remove, sum);
+}
+
+extern "C" int main(int argc, char **argv)
+{
+    int keys = 100000;
+
+    if(argc > 1)
+        keys = atoi(argv[1]);
+
+    if(keys < 1)
+        keys = 1;
+
+    mapref<int,int> chained((size_t)keys);
+    flatmap<int,int> flat((size_t)keys);
+    bench("mapref", chained, keys);
+    bench("flatmap", flat, keys);
+
+    mapref<int,int> growing(37);
+    flatmap<int,int> regrow(32);
+    bench("mapref", growing, keys);
+    bench("flatmap", regrow, keys);
+    return 0;
+}
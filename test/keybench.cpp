@@ -0,0 +1,155 @@
+// Copyright (C) 2015-2020 Cherokees of Idaho.
+//
+// This file is part of GNU uCommon C++.
+//
+// GNU uCommon C++ is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// GNU uCommon C++ is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with GNU uCommon C++.  If not, see <http://www.gnu.org/licenses/>.
+
+// compare load times of a key file mapped in place and the same file read
+// line by line through a pipe.  Pass a section count to change the size.
+
+#include <ucommon/ucommon.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifndef _MSWINDOWS_
+#include <unistd.h>
+#include <fcntl.h>
+#endif
+
+using namespace ucommon;
+
+#define KEYS_PER_SECTION    50
+
+static unsigned long elapsed(Timer::tick_t start)
+{
+    return (unsigned long)((Timer::ticks() - start) / 10000);
+}
+
+static void generate(const char *path, int sections)
+{
+    FILE *fp = fopen(path, "w");
+
+    if(!fp)
+        return;
+
+    for(int section = 0; section < sections; ++section) {
+        fprintf(fp, "# section %d\n[section%d]\n", section, section);
+        for(int key = 0; key < KEYS_PER_SECTION; ++key)
+            fprintf(fp, "key%d = \"value %d of section %d\"\n", key, key, section);
+        fprintf(fp, "joined = first\\\n  second\n\n");
+    }
+    fclose(fp);
+}
+
+static long check(keyfile& keys, int sections)
+{
+    char name[32];
+    long sum = 0;
+
+    for(int section = 0; section < sections; ++section) {
+        snprintf(name, sizeof(name), "section%d", section);
+        keydata *data = keys.get(name);
+        if(data)
+            sum += (long)strlen(data->get("joined"));
+    }
+    return sum;
+}
+
+#ifndef _MSWINDOWS_
+// the read path is taken for anything that is not a regular file, so the
+// same text is fed through a pipe...
+class feeder : public JoinableThread
+{
+private:
+    const char *path;
+    int fd;
+
+public:
+    feeder(const char *name, int pipe) : JoinableThread() {
+        path = name;
+        fd = pipe;
+    }
+
+    ~feeder() {
+        join();
+    }
+
+    void run(void) {
+        char buf[4096];
+        ssize_t len;
+        int in = ::open(path, O_RDONLY);
+
+        while(in > -1 && (len = ::read(in, buf, sizeof(buf))) > 0) {
+            if(::write(fd, buf, len) != len)
+                break;
+        }
+        if(in > -1)
+            ::close(in);
+        ::close(fd);
+    }
+};
+
+static long piped(const char *path, int sections)
+{
+    char name[32];
+    int fds[2];
+
+    if(pipe(fds))
+        return 0;
+
+    feeder feed(path, fds[1]);
+    feed.start();
+    snprintf(name, sizeof(name), "/dev/fd/%d", fds[0]);
+    keyfile keys(name);
+    ::close(fds[0]);
+    return check(keys, sections);
+}
+#endif
+
+extern "C" int main(int argc, char **argv)
+{
+    const char *path = "keybench.conf";
+    int sections = 200;
+    int passes = 20;
+    long sum = 0;
+
+    if(argc > 1)
+        sections = atoi(argv[1]);
+
+    if(sections < 1)
+        sections = 1;
+
+    generate(path, sections);
+
+    Timer::tick_t start = Timer::ticks();
+    for(int pass = 0; pass < passes; ++pass) {
+        keyfile keys(path);
+        sum += check(keys, sections);
+    }
+    printf("%-8s %8d keys: load %6lu msec (%ld)\n",
+        "mapped", sections * KEYS_PER_SECTION, elapsed(start), sum);
+
+#ifndef _MSWINDOWS_
+    sum = 0;
+    start = Timer::ticks();
+    for(int pass = 0; pass < passes; ++pass)
+        sum += piped(path, sections);
+    printf("%-8s %8d keys: load %6lu msec (%ld)\n",
+        "read", sections * KEYS_PER_SECTION, elapsed(start), sum);
+#endif
+
+    remove(path);
+    return 0;
+}
@@ -41,5 +41,19 @@ extern "C" int main()
     keys = myfile["section2"];
     assert(keys != NULL);
     assert(eq_case(keys->get("key1"), "replaced value"));
+    assert(eq_case(keys->get("key2"), "joinedvalue"));
+    assert(eq(keys->get("key3"), ""));
+
+    keys->set("key2", "changed");
+    assert(eq(keys->get("key2"), "changed"));
+
+    keyfile copy(myfile);
+    assert(eq(copy["section2"]->get("key2"), "changed"));
+    assert(eq(copy["section1"]->get("key2"), "this is value 2 unquoted"));
+
+    myfile.release();
+    assert(myfile["section1"] == NULL);
+    myfile.load("keydata.conf");
+    assert(eq(myfile["section2"]->get("key2"), "joinedvalue"));
     return 0;
 }
@@ -38,6 +38,12 @@ public:
     unsigned value;
 };
 
+class named : public NamedObject
+{
+public:
+    inline named() : NamedObject() {}
+};
+
 extern "C" int main()
 {
     linked_pointer<ints> ptr;
@@ -69,5 +75,31 @@ extern "C" int main()
 
     assert(ov2.value == 2);
 
+    NamedIndex names(7);
+    char id[16];
+    for(unsigned pos = 0; pos < 1000; ++pos) {
+        snprintf(id, sizeof(id), "name%u", pos);
+        names.add(new named(), strdup(id));
+    }
+    assert(names.count() == 1000);
+    assert(names.range() > 7);
+    names.add(new named(), strdup("name500"));
+    assert(names.count() == 1000);
+    assert(eq(names.map("name999")->getId(), "name999"));
+    assert(names.map("name1000") == NULL);
+    names.remove("name10")->release();
+    assert(names.count() == 999);
+    assert(names.map("name10") == NULL);
+    NamedObject *np = names.skip();
+    count = 0;
+    while(np) {
+        ++count;
+        np = names.skip(np);
+    }
+    assert(count == 999);
+    names.purge();
+    assert(names.count() == 0);
+    assert(NamedObject::keyindex("Name", 97) == NamedObject::keyindex("name", 97));
+
     return 0;
 }
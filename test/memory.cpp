@@ -44,6 +44,66 @@ public:
     }
 };
 
+class pooled : public PagerObject
+{
+public:
+    int v;
+};
+
+static pooled *handed[64];
+
+class pooltaker : public JoinableThread
+{
+public:
+    pager<pooled> *pool;
+
+    pooltaker(pager<pooled> *source) : JoinableThread(), pool(source) {}
+
+    ~pooltaker() {
+        join();
+    }
+
+    void run(void) {
+        for(unsigned pos = 0; pos < 64; ++pos) {
+            handed[pos] = **pool;
+            handed[pos]->v = (int)pos;
+        }
+    }
+};
+
+// sets the reference to another map while holding the lock of its own...
+class swapflat : public flatmap<int,int>
+{
+public:
+    void swap(flatmap<int,int>& other) {
+        Map *m = modify();
+        flatmap<int,int>::operator=(other);
+        commit(m);
+    }
+};
+
+// reads a reference until told to leave, so the object it saw is retired
+// while it is still being read...
+class rcureader : public JoinableThread
+{
+public:
+    rcuref<int> *ref;
+    Barrier *sync;
+
+    rcureader(rcuref<int> *from, Barrier *with) : JoinableThread(), ref(from), sync(with) {}
+
+    ~rcureader() {
+        join();
+    }
+
+    void run(void) {
+        rcuref<int>::reader rr(*ref);
+        sync->wait();
+        sync->wait();
+        assert(*rr == 6);
+    }
+};
+
 typedef struct {
     char key[12];
     int v;
@@ -79,6 +139,31 @@ extern "C" int main()
 
     assert(list[2] == NULL);
 
+    StringPager tokens(4096);
+    char tok[16];
+    for(unsigned pos = 0; pos < 2000; ++pos) {
+        snprintf(tok, sizeof(tok), "%05u", pos);
+        tokens << tok;
+    }
+    tokens >> "first";
+    assert(tokens.count() == 2001);
+    assert(eq(tokens[0u], "first"));
+    assert(eq(tokens[1500u], "01499"));
+    assert(eq(tokens.pop(), "01999"));
+    assert(eq(tokens.pull(), "first"));
+    tokens.set(1000u, "00000x");
+    tokens.sort();
+    assert(eq(tokens[1u], "00000x"));
+    assert(eq(tokens[1998u], "01998"));
+    tokens << "zzz";
+    list = tokens;
+    assert(eq(list[1999], "zzz"));
+    assert(list[2000] == NULL);
+    tokens.sort();
+    tokens << "zzzz";
+    assert(eq(list[0], "00000") && eq(list[1999], "zzz"));
+    assert(eq(tokens.list()[2000], "zzzz"));
+
     int *pval = &tval;
     int& rval = deref_pointer<int>(pval);
     assert(&rval == pval);
@@ -157,6 +242,40 @@ extern "C" int main()
     typeref<int> sv = sint;
     assert(sv.copies() == 2);
 
+    rcuref<int> rint;
+    rint = 5;
+    typeref<int> rv = rint;
+    assert(rv.copies() == 2);
+    if(true) {
+        rcuref<int>::reader rr(rint);
+        assert(*rr == 5);
+        rint = 6;
+        assert(*rr == 5);
+        assert(RCURef::reclaim() == 0);
+        assert(rv.copies() == 2);
+        rcuref<int>::reader nested(rint);
+        assert(*nested == 6);
+    }
+    assert(RCURef::reclaim() == 1);
+    assert(rv.copies() == 1);
+    rv = *rint;
+    assert(*rv == 6);
+
+    // the last object retired is reclaimed when its reader exits, even
+    // though nothing is retired after it...
+    Barrier rsync(2);
+    if(true) {
+        rcureader reading(&rint, &rsync);
+        reading.start();
+        rsync.wait();
+        rint = 7;
+        assert(rv.copies() == 2);
+        rsync.wait();
+    }
+    assert(rv.copies() == 1);
+    rv = *rint;
+    assert(*rv == 7);
+
     stackref<int> stackofints(20);
     stackofints << 17;
     stackofints << 25;
@@ -177,6 +296,18 @@ extern "C" int main()
     queueofints >> sv;
     assert(sv == 55);
 
+    ringref<int> ringofints(3);
+    ringofints << 11 << 22 << 33 << 44;
+    assert(ringofints.count() == 4);
+    assert(!ringofints.push(55, 0));
+    ringofints >> sv;
+    assert(sv == 11);
+    ringofints.pop();
+    sv = ringofints.pull(0);
+    assert(sv == 33);
+    assert(sv.copies() == 1);
+    assert(ringofints.count() == 1);
+
 //  avoid: consistently fails on bigendian archs
 //  assert(mapkeypath(sv) == 8779);
 
@@ -217,6 +348,74 @@ extern "C" int main()
     sr = map(7);
     assert(*sr == nullptr);
 
+    mapref<int,int> bigmap(7);
+    for(int key = 0; key < 1000; ++key)
+        bigmap(key, key * 3);
+    assert(bigmap.count() == 1000);
+    for(int key = 0; key < 1000; key += 2)
+        assert(bigmap.remove(key));
+    assert(bigmap.count() == 500);
+    typeref<int> bv = bigmap(501);
+    assert(*bv == 1503);
+    bv = bigmap(500);
+    assert(!bv);
+    passes = 0;
+    mapref<int,int>::instance binst = bigmap;
+    while(is(binst)) {
+        ++binst;
+        ++passes;
+    }
+    assert(passes == 500);
+    binst = mapref<int,int>::instance();
+
+    mapref<int,int> oldmap(7, 0, MapRef::SHIFT);
+    oldmap(5, 10);
+    assert(*oldmap(5) == 10);
+    assert(MapRef::hash((const uint8_t *)"abc", 3) != MapRef::hash((const uint8_t *)"abd", 3));
+
+    flatmap<int,int> flat(8);
+    for(int key = 0; key < 1000; ++key)
+        flat(key, key * 3);
+    assert(flat.count() == 1000);
+    assert(flat.capacity() >= 1024);
+    for(int key = 0; key < 1000; key += 2)
+        assert(flat.remove(key));
+    assert(!flat.remove(2));
+    assert(flat.count() == 500);
+    bv = flat(501);
+    assert(*bv == 1503);
+    bv = flat(500);
+    assert(!bv);
+    flat(501, 7);
+    assert(*flat(501) == 7);
+    typeref<int> fk(501);
+    bv = flat.take(fk);
+    assert(*bv == 7 && flat.count() == 499);
+    passes = 0;
+    flatmap<int,int>::instance finst = flat;
+    while(is(finst)) {
+        assert(*finst.value() == *finst.key() * 3);
+        ++finst;
+        ++passes;
+    }
+    assert(passes == 499);
+    finst = flatmap<int,int>::instance();
+    flat.purge();
+    assert(flat.count() == 0);
+
+    swapflat fswap;
+    flatmap<int,int> fkeep(8);
+    fkeep = fswap;
+    fswap.swap(flat);
+    fkeep(1, 2);
+    assert(*fkeep(1) == 2 && fswap.count() == 0);
+
+    flatmap<Type::Chars,int> names;
+    names("alpha", 1);
+    names("beta", 2);
+    assert(*names("beta") == 2);
+    assert(!names("gamma"));
+
     listref<int> intlist;
     intlist << 3 << 5 << 7 << 9;
     assert(intlist.count() == 4);
@@ -281,5 +480,106 @@ extern "C" int main()
     s6 = "";
     s7 = "";
     assert(release_later.purge() == 2);
+
+    mempager slabs(4096, 64);
+    assert(slabs.slab() == 64);
+    void *m1 = slabs.alloc(24);
+    void *m2 = slabs.alloc(24);
+    assert(m1 != m2);
+    slabs.dealloc(m1);
+    assert(slabs.alloc(20) == m1);
+    slabs.dealloc(m2);
+    assert(slabs.alloc(40) != m2);
+    assert(slabs.alloc(24) == m2);
+    void *m3 = slabs.alloc(200);
+    slabs.dealloc(m3);
+    assert(slabs.alloc(200) != m3);
+    assert(slabs.pages() == 1);
+
+    mempager cached(4096, 64, 4);
+    m1 = cached.alloc(16);
+    cached.dealloc(m1);
+    assert(cached.alloc(16) == m1);
+    pagerstats_t ps = cached.stats();
+    assert(ps.misses == 1 && ps.hits == 1 && ps.refills == 1);
+
+    pager<pooled> pool(&cached, 4);
+    pooled *p1 = *pool;
+    static_cast<CountedObject *>(p1)->retain();
+    static_cast<CountedObject *>(p1)->release();
+    assert(*pool == p1);
+    ps = pool.stats();
+    assert(ps.hits == 1 && ps.remote == 0);
+
+    // objects taken in another thread are released into our own cache...
+    pooltaker *taker = new pooltaker(&pool);
+    taker->start();
+    delete taker;
+    unsigned pages = cached.pages();
+    for(unsigned pos = 0; pos < 64; ++pos) {
+        assert(handed[pos]->v == (int)pos);
+        static_cast<CountedObject *>(handed[pos])->retain();
+        static_cast<CountedObject *>(handed[pos])->release();
+    }
+    ps = pool.stats();
+    assert(ps.remote == 64);
+    for(unsigned pos = 0; pos < 64; ++pos)
+        handed[pos] = *pool;
+    assert(cached.pages() == pages);
+
+    maptest rec;
+    mapped_record<maptest> records("ucommon-test-records", 4);
+    assert(records.count() == 4);
+    String::set(rec.key, sizeof(rec.key), "second");
+    rec.v = 2;
+    records.put(1, rec);
+    rec.v = 3;
+    records.put(1, rec);
+    mapped_record<maptest> reader("ucommon-test-records");
+    memset(&rec, 0, sizeof(rec));
+    assert(reader.get(1, rec));
+    assert(eq(rec.key, "second") && rec.v == 3);
+    assert(reader.get(0, rec) && rec.v == 0);
+
+    mapped_latest<maptest> stats("ucommon-test-latest", 3);
+    mapped_latest<maptest> view("ucommon-test-latest");
+    assert(!view.get(rec));
+    for(int count = 1; count <= 10; ++count) {
+        rec.v = count;
+        stats.put(rec);
+    }
+    rec.v = 0;
+    assert(view.get(rec) && rec.v == 10);
+
+    // a segment rounded up past its ring still reads the slots the ring
+    // was published with...
+    MappedMemory padded("ucommon-test-padded", MappedMemory::ring(sizeof(rec), 3) + 4096);
+    for(int count = 1; count <= 5; ++count) {
+        rec.v = count;
+        padded.publish(0, &rec, sizeof(rec), 3);
+    }
+    MappedMemory padview("ucommon-test-padded");
+    rec.v = 0;
+    assert(padview.latest(0, &rec, sizeof(rec), 0) && rec.v == 5);
+    mapped_ring<maptest> ring("ucommon-test-ring", 3);
+    mapped_ring<maptest> producer("ucommon-test-ring");
+    assert(ring && producer && ring.max() == 4);
+    for(int count = 0; count < 4; ++count) {
+        rec.v = count;
+        assert(producer.put(rec));
+    }
+    assert(!producer.put(rec) && !producer.put(rec, 20));
+    assert(ring.pending() == 4);
+    assert(ring.get(rec) && rec.v == 0);
+    rec.v = 4;
+    assert(producer.put(rec));
+    for(int count = 1; count < 5; ++count)
+        assert(ring.get(rec) && rec.v == count);
+    assert(!ring.get(rec, 20) && !ring.pending());
+    mapped_ring<int> wrong("ucommon-test-ring");
+    assert(!wrong);
+
+    MappedMemory::remove("ucommon-test-records");
+    MappedMemory::remove("ucommon-test-latest");
     return 0;
 }
@@ -34,6 +34,78 @@ static Socket::address testing6("44:022:66::1", 4444);
 static Socket::address localhost6("::1", 4444);
 #endif
 
+class testLookup : public Resolver::request
+{
+public:
+    volatile unsigned calls;
+
+    testLookup() : Resolver::request() {
+        calls = 0;
+    }
+
+    void completed(void) {
+        ++calls;
+    }
+};
+
+// takes its time in the callback, so a request freed while it is still
+// being called back is caught...
+class slowLookup : public testLookup
+{
+public:
+    void completed(void) {
+        Thread::sleep(50);
+        testLookup::completed();
+    }
+};
+
+#ifndef _MSWINDOWS_
+class testSource : public Reactor::source
+{
+public:
+    unsigned reads;
+
+    testSource() : Reactor::source() {
+        reads = 0;
+    }
+
+    void readable(void) {
+        char buf[16];
+        if(::read(handle(), buf, sizeof(buf)) > 0)
+            ++reads;
+    }
+};
+
+class testStop : public TQEvent
+{
+private:
+    Reactor *reactor;
+
+public:
+    testStop(Reactor *r, timeout_t timeout) : TQEvent(r, timeout) {
+        reactor = r;
+    }
+
+    void expired(void) {
+        reactor->stop();
+    }
+};
+
+class testRequest : public AsyncIO::request
+{
+public:
+    unsigned calls;
+
+    testRequest() : AsyncIO::request() {
+        calls = 0;
+    }
+
+    void completed(void) {
+        ++calls;
+    }
+};
+#endif
+
 extern "C" int main()
 {
     struct sockaddr_internet addr;
@@ -98,5 +170,188 @@ extern "C" int main()
         assert(0 == strcmp(addrbuf, "44:22:66::1"));
     }
 #endif
+
+    cidr::policy *acl = NULL;
+    cidr net(&acl, "127.0.0.0/8", "loopback");
+    cidr host(&acl, "127.0.0.1/32", "localhost");
+    cidr ten(&acl, "10.0.0.0/255.255.0.0", "private");
+    cidr::index acls(acl);
+    struct sockaddr_in sin;
+    memset(&sin, 0, sizeof(sin));
+    sin.sin_family = AF_INET;
+    sin.sin_addr.s_addr = htonl(0x7f000001);
+    assert(acls.find((struct sockaddr *)&sin) == &host);
+    assert(acls.container((struct sockaddr *)&sin) == &net);
+    sin.sin_addr.s_addr = htonl(0x7f020304);
+    assert(acls.find((struct sockaddr *)&sin) == &net);
+    assert(acls.find((struct sockaddr *)&sin) == cidr::find(acl, (struct sockaddr *)&sin));
+    sin.sin_addr.s_addr = htonl(0x0a000107);
+    assert(acls.find((struct sockaddr *)&sin) == &ten);
+    sin.sin_addr.s_addr = htonl(0x0a050107);
+    assert(acls.find((struct sockaddr *)&sin) == NULL);
+    acls.update(NULL);
+    sin.sin_addr.s_addr = htonl(0x7f000001);
+    assert(acls.find((struct sockaddr *)&sin) == NULL);
+
+    Resolver dns(1, 60000, 5000, 2);
+    struct addrinfo hint, *found = NULL, *cached = NULL;
+    memset(&hint, 0, sizeof(hint));
+    hint.ai_family = AF_INET;
+    hint.ai_socktype = SOCK_STREAM;
+    assert(dns.lookup("localhost", "4444", &hint, &found) == 0 && found != NULL);
+    assert(dns.count() == 1);
+    assert(dns.lookup("localhost", "4444", &hint, &cached) == 0 && cached != NULL);
+    assert(cached != found && eq(cached->ai_addr, found->ai_addr));
+    sin.sin_addr.s_addr = htonl(0x7f000001);
+    sin.sin_port = htons(4444);
+    assert(eq(cached->ai_addr, (struct sockaddr *)&sin));
+    freeaddrinfo(found);
+    freeaddrinfo(cached);
+    assert(dns.lookup("localhost", "4445", &hint, &found) == 0);
+    freeaddrinfo(found);
+    assert(dns.lookup("localhost", "4446", &hint, &found) == 0);
+    freeaddrinfo(found);
+    assert(dns.count() == 2);
+    testLookup query;
+    assert(dns.lookup(&query, "localhost", "4444", &hint));
+    while(query.is_busy())
+        Thread::sleep(10);
+    assert(query.calls == 1 && query.error() == 0);
+    assert(eq(query.result()->ai_addr, (struct sockaddr *)&sin));
+    slowLookup *slow = new slowLookup();
+    assert(dns.lookup(slow, "localhost", "4447", &hint));
+    while(slow->is_busy())
+        Thread::yield();
+    assert(slow->calls == 1);
+    delete slow;
+    dns.install();
+    Socket::address named(AF_INET, "localhost", "4444");
+    assert(named.get() != NULL && eq(named.get(), (struct sockaddr *)&sin));
+    Resolver::release();
+    dns.clear();
+    assert(dns.count() == 0);
+
+    // lookups still queued are called back when the resolver goes away...
+    Resolver *doomed = new Resolver(1, 60000, 5000, 8);
+    testLookup pending[4];
+    char svc[8];
+    for(unsigned pos = 0; pos < 4; ++pos) {
+        snprintf(svc, sizeof(svc), "%u", 5000 + pos);
+        assert(doomed->lookup(&pending[pos], "localhost", svc, &hint));
+    }
+    delete doomed;
+    for(unsigned pos = 0; pos < 4; ++pos)
+        assert(pending[pos].calls == 1 && !pending[pos].is_busy());
+
+#ifndef _MSWINDOWS_
+    Reactor reactor;
+    testSource source;
+    fd_t input, output;
+
+    assert(fsys::pipe(input, output) == 0);
+    assert(reactor.attach(&source, (socket_t)input));
+    assert(reactor.count() == 1);
+    assert(reactor.dispatch(0) == 0);
+    assert(::write(output, "x", 1) == 1);
+    assert(reactor.dispatch(1000) == 1);
+    assert(source.reads == 1);
+
+    int pair[2];
+    char line[32];
+    const char *view;
+    size_t size;
+
+    assert(::socketpair(AF_UNIX, SOCK_STREAM, 0, pair) == 0);
+    Socket::buffer rx(16);
+    assert(::write(pair[1], "one\r\ntwo\nthree", 14) == 14);
+    assert(rx.readline(pair[0], line, sizeof(line)) == 4);
+    assert(eq(line, "one"));
+    view = rx.getline(pair[0], size);
+    assert(size == 3 && eq(view, "two"));
+    assert(rx.pending() == 5);
+    assert(::write(pair[1], "-line-that-is-longer\n", 21) == 21);
+    view = rx.getline(pair[0], size);
+    assert(size == 16 && eq(view, "three-line-that-"));
+    view = rx.getline(pair[0], size);
+    assert(size == 9 && eq(view, "is-longer"));
+    assert(::write(pair[1], "tail", 4) == 4);
+    ::shutdown(pair[1], SHUT_WR);
+    assert(rx.read(pair[0], line, 2) == 2);
+    view = rx.getline(pair[0], size);
+    assert(size == 2 && eq(view, "il"));
+    assert(rx.getline(pair[0], size) == NULL);
+
+    ::close(pair[0]);
+    ::close(pair[1]);
+
+    assert(::socketpair(AF_UNIX, SOCK_STREAM, 0, pair) == 0);
+    Socket stream(pair[0]);
+    assert(stream.buffering(64));
+    assert(::write(pair[1], "alpha\nbeta\ngamma\n", 17) == 17);
+    assert(stream.readline(line, sizeof(line)) == 6);
+    assert(eq(line, "alpha"));
+    assert(stream.pending() == 11);
+    view = stream.getline(size);
+    assert(size == 4 && eq(view, "beta"));
+    assert(stream.readfrom(line, sizeof(line)) == 6);
+    assert(!memcmp(line, "gamma\n", 6));
+    ::close(pair[1]);
+
+    char store[4][8];
+    Socket::datagram_t msgs[4];
+    memset(msgs, 0, sizeof(msgs));
+    msgs[0].data = (void *)"one";
+    msgs[0].size = 3;
+    msgs[1].data = (void *)"two";
+    msgs[1].size = 3;
+    msgs[2].data = (void *)"three";
+    msgs[2].size = 5;
+    assert(::socketpair(AF_UNIX, SOCK_DGRAM, 0, pair) == 0);
+    assert(Socket::sendbatch(pair[1], msgs, 3) == 3);
+    for(unsigned pos = 0; pos < 4; ++pos) {
+        msgs[pos].data = store[pos];
+        msgs[pos].size = sizeof(store[pos]);
+    }
+    assert(Socket::recvbatch(pair[0], msgs, 4) == 3);
+    assert(msgs[0].length == 3 && !memcmp(store[0], "one", 3));
+    assert(msgs[2].length == 5 && !memcmp(store[2], "three", 5));
+    ::close(pair[0]);
+    ::close(pair[1]);
+
+    AsyncIO aio(16);
+    testRequest rd, wr, rx2, tx2;
+    assert(::socketpair(AF_UNIX, SOCK_STREAM, 0, pair) == 0);
+    assert(aio.recv(&rx2, pair[0], store[0], sizeof(store[0])));
+    assert(aio.write(&wr, output, "async", 5));
+    assert(!aio.write(&wr, output, "busy", 4));
+    assert(aio.pending() == 2);
+    assert(aio.submit() == 2);
+    while(!wr.calls)
+        aio.complete(1000);
+    assert(wr.result() == 5 && wr.error() == 0);
+    assert(aio.read(&rd, input, line, sizeof(line)));
+    while(!rd.calls)
+        aio.complete(1000);
+    assert(rd.result() == 5 && !memcmp(line, "async", 5));
+    assert(rx2.is_busy() && !rx2.calls);
+    assert(aio.send(&tx2, pair[1], "hello", 5));
+    while(!rx2.calls)
+        aio.complete(1000);
+    assert(rx2.result() == 5 && !memcmp(store[0], "hello", 5));
+    while(aio.pending())
+        aio.complete(1000);
+    assert(tx2.calls == 1 && tx2.result() == 5);
+    ::close(pair[0]);
+    ::close(pair[1]);
+
+    testStop stop(&reactor, 20);
+    reactor.run();
+    assert(source.reads == 1);
+    source.detach();
+    assert(reactor.count() == 0);
+    assert(source.list() == nullptr);
+    fsys::release(input);
+    fsys::release(output);
+#endif
     return 0;
 }
@@ -24,6 +24,10 @@
 #include <ucommon/ucommon.h>
 
 #include <stdio.h>
+#ifndef _MSWINDOWS_
+#include <signal.h>
+#include <sys/resource.h>
+#endif
 
 using namespace ucommon;
 using namespace std;
@@ -36,22 +40,171 @@ public:
     void run() {
         Socket::address localhost("127.0.0.1", 9000);
         tcpstream tcp(localhost);
-        tcp << "pippo" << endl << ends;
+        tcp << "pippo" << endl;
+
+        // buffered output goes first, then file data, then piped data...
+        FILE *fp = tmpfile();
+        fputs("prefix-recording\n", fp);
+        fflush(fp);
+        tcp << "buffered\n";
+        assert(tcp.sendfile(fileno(fp), 7, 10) == 10);
+        fclose(fp);
+
+        fd_t input, output;
+        assert(fsys::pipe(input, output) == 0);
+        assert(::write(output, "piped\n", 6) == 6);
+        assert(tcp.sendfile(input, -1, 6) == 6);
+        fsys::release(input);
+        fsys::release(output);
+
+        tcp << ends;
         tcp.close();
     }
 };
 
+static bool copying(void *user, uint64_t copied, uint64_t total)
+{
+    __UNUSED(copied);
+    ++*(unsigned *)user;
+    return total != 0;
+}
+
+static bool cancel(void *user, uint64_t copied, uint64_t total)
+{
+    __UNUSED(user);
+    __UNUSED(copied);
+    __UNUSED(total);
+    return false;
+}
+
+#ifndef _MSWINDOWS_
+static bool piping(void *user, uint64_t copied, uint64_t total)
+{
+    *(uint64_t *)user = copied;
+    return total == 0;
+}
+
+// feeds a file into a pipe, so that copying from the pipe has no size and
+// goes through the buffer...
+class FeedPipe : public JoinableThread
+{
+private:
+    const char *path;
+    fd_t output;
+
+public:
+    FeedPipe(const char *name, fd_t fd) : JoinableThread() {
+        path = name;
+        output = fd;
+    }
+
+    ~FeedPipe() {
+        join();
+    }
+
+    void run() {
+        char buf[4096];
+        ssize_t count;
+        FILE *fp = fopen(path, "r");
+
+        while(fp && (count = (ssize_t)fread(buf, 1, sizeof(buf), fp)) > 0) {
+            if(::write(output, buf, count) != count)
+                break;
+        }
+        if(fp)
+            fclose(fp);
+        fsys::release(output);
+    }
+};
+
+static int piped(const char *source, const char *target, fsys::progress_t progress, void *user)
+{
+    char path[32];
+    fd_t input, output;
+    int result;
+
+    assert(fsys::pipe(input, output) == 0);
+    FeedPipe feed(source, output);
+    feed.start();
+    snprintf(path, sizeof(path), "/dev/fd/%d", input);
+    result = fsys::copy(path, target, 0, progress, user, 1000);
+    fsys::release(input);
+    return result;
+}
+#endif
+
+static bool same(const char *one, const char *two)
+{
+    char buf1[4096], buf2[4096];
+    FILE *fp1 = fopen(one, "r"), *fp2 = fopen(two, "r");
+    size_t count;
+    bool result = (fp1 != NULL && fp2 != NULL);
+
+    while(result && (count = fread(buf1, 1, sizeof(buf1), fp1)) > 0)
+        result = fread(buf2, 1, count, fp2) == count && !memcmp(buf1, buf2, count);
+    if(result)
+        result = fread(buf2, 1, 1, fp2) == 0;
+    if(fp1)
+        fclose(fp1);
+    if(fp2)
+        fclose(fp2);
+    return result;
+}
+
 int main(int argc, char *argv[])
 {
     ThreadOut thread;
 
     char line[200];
+    unsigned calls = 0;
+    fsys::fileinfo_t ino;
+
+    FILE *fp = fopen("copy-source.tmp", "w");
+    for(unsigned pos = 0; pos < 100000; ++pos)
+        fprintf(fp, "%u\n", pos);
+    fclose(fp);
+    assert(fsys::mode("copy-source.tmp", 0640) == 0);
+    assert(fsys::copy("copy-source.tmp", "copy-target.tmp") == 0);
+    assert(same("copy-source.tmp", "copy-target.tmp"));
+    assert(fsys::copy("copy-source.tmp", "copy-target.tmp", fsys::COPY_PRESERVE, &copying, &calls, 100) == 0);
+    assert(same("copy-source.tmp", "copy-target.tmp") && calls > 0);
+    assert(fsys::info("copy-target.tmp", &ino) == 0 && (ino.st_mode & 0777) == 0640);
+    assert(fsys::copy("copy-source.tmp", "copy-target.tmp", fsys::COPY_NOCLONE, &cancel) == ECANCELED);
+    assert(!fsys::is_exists("copy-target.tmp"));
+    assert(fsys::copy("copy-missing.tmp", "copy-target.tmp") == ENOENT);
+
+#ifndef _MSWINDOWS_
+    // a buffer that does not divide the file leaves short reads...
+    uint64_t bytes = 0;
+    assert(fsys::info("copy-source.tmp", &ino) == 0);
+    assert(piped("copy-source.tmp", "copy-target.tmp", &piping, &bytes) == 0);
+    assert(same("copy-source.tmp", "copy-target.tmp") && bytes == (uint64_t)ino.st_size);
+
+    // a file size limit cuts a write short, and the write after it fails...
+    struct rlimit saved, limit;
+    signal(SIGPIPE, SIG_IGN);
+    signal(SIGXFSZ, SIG_IGN);
+    assert(getrlimit(RLIMIT_FSIZE, &saved) == 0);
+    limit = saved;
+    limit.rlim_cur = 300500;
+    assert(setrlimit(RLIMIT_FSIZE, &limit) == 0);
+    assert(piped("copy-source.tmp", "copy-target.tmp", NULL, NULL) == EFBIG);
+    assert(setrlimit(RLIMIT_FSIZE, &saved) == 0);
+    assert(!fsys::is_exists("copy-target.tmp"));
+#endif
+    fsys::erase("copy-source.tmp");
     TCPServer sock("127.0.0.1", "9000");
     thread.start();
     if (sock.wait(1000)){
         tcpstream tcp(&sock);
         tcp.getline(line, 200);
         assert(!strcmp(line, "pippo"));
+        tcp.getline(line, 200);
+        assert(!strcmp(line, "buffered"));
+        tcp.getline(line, 200);
+        assert(!strcmp(line, "recording"));
+        tcp.getline(line, 200);
+        assert(!strcmp(line, "piped"));
         tcp.close();
 
         line[0] = 0;
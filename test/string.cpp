@@ -23,6 +23,7 @@
 #include <ucommon/ucommon.h>
 
 #include <stdio.h>
+#include <string.h>
 
 using namespace ucommon;
 
@@ -92,6 +93,62 @@ extern "C" int main()
     assert(eq(paste_test, "foobar"));
     assert(eq(paste_test_empty, "bar"));
 
+    String found = "abcabc and ABCabc";
+    assert(found.search("abc", 2) == found.c_str() + 3);
+    assert(found.search("Abca", 0, String::INSENSITIVE) == found.c_str());
+    assert(found.search("cab", 3) == NULL);
+    assert(String::search("xxxneedle", 9, "NEEDLE", 6, String::INSENSITIVE) != NULL);
+    assert(String::search("xxxneedle", 8, "needle", 6) == NULL);
+    assert(found.replace("b", "X") == 3);
+    assert(eq(found, "aXcaXc and ABCaXc"));
+
+    String::charset delims(",;");
+    const char *fields = "key=value;next,last";
+    assert(delims.cspan(fields) == 9);
+    assert(delims.span(fields + 9) == 1);
+    assert(delims.find(fields, 9) == NULL);
+    assert(delims.rfind(fields, 19) == fields + 14);
+    String::set(buff, sizeof(buff), fields);
+    assert(String::find(buff, ",") == buff + 14);
+
+    // a text long enough for whole vector blocks and a scalar tail, with the
+    // key placed everywhere, among fillers whose first and last characters
+    // match the key but whose middle does not...
+    char longtext[203];
+    const size_t longsize = sizeof(longtext) - 1;
+    for(size_t pos = 0; pos + 6 <= longsize; ++pos) {
+        for(size_t fill = 0; fill < longsize; ++fill)
+            longtext[fill] = "nzedle"[fill % 6];
+        longtext[longsize] = 0;
+        memcpy(longtext + pos, "NeEdLe", 6);
+        assert(String::search(longtext, longsize, "needle", 6, String::INSENSITIVE) == longtext + pos);
+        assert(String::search(longtext, longsize, "NEEDLE", 6, String::INSENSITIVE) == longtext + pos);
+        assert(String::search(longtext, longsize, "NeEdLe", 6) == longtext + pos);
+        assert(String::search(longtext, longsize, "needle", 6) == NULL);
+        assert(String::search(longtext, pos + 5, "NeEdLe", 6) == NULL);
+    }
+
+    // high bit members share the low half of their code with fillers below
+    // 128, so a lookup in the wrong half of the table shows...
+    String::charset high("\xe9\xff,");
+    for(size_t pos = 0; pos < longsize; ++pos) {
+        for(size_t fill = 0; fill < longsize; ++fill)
+            longtext[fill] = (fill & 1) ? 'i' : '\x7f';
+        longtext[longsize] = 0;
+        longtext[pos] = (pos & 1) ? '\xe9' : '\xff';
+        assert(high.find(longtext, longsize) == longtext + pos);
+        assert(high.rfind(longtext, longsize) == longtext + pos);
+        assert(high.cspan(longtext) == pos);
+        assert(high.find(longtext, pos) == NULL);
+
+        memset(longtext, (pos & 1) ? '\xff' : '\xe9', longsize);
+        longtext[pos] = (pos & 1) ? 'i' : '\x7f';
+        assert(high.skip(longtext, longsize) == longtext + pos);
+        assert(high.rskip(longtext, longsize) == longtext + pos);
+        assert(high.span(longtext) == pos);
+        assert(high.skip(longtext, pos) == NULL);
+    }
+
     assert(String::check("xxx", 3));
     assert(!String::check("xxxx", 3));
 
@@ -42,6 +42,31 @@ private:
 
 static testLocal local;
 
+class testQueue : public TimerQueue
+{
+private:
+    virtual void modify(void) __FINAL {};
+    virtual void update(void) __FINAL {};
+};
+
+class testTimer : public TQEvent
+{
+public:
+    unsigned fired, repeat;
+
+    testTimer(TimerQueue *tq, timeout_t timeout) : TQEvent(tq, timeout) {
+        fired = repeat = 0;
+    }
+
+    void expired(void) {
+        ++fired;
+        if(repeat) {
+            --repeat;
+            arm(20);
+        }
+    }
+};
+
 class testThread : public JoinableThread
 {
 public:
@@ -56,6 +81,42 @@ public:
     };
 };
 
+static TaskPool *pool = nullptr;
+static Atomic::counter calls;
+
+class testTask : public TaskPool::task
+{
+public:
+    int value;
+    long result;
+
+    testTask(int n) : TaskPool::task() {
+        value = n;
+        result = 0;
+    }
+
+    void run(void) {
+        if(value < 2) {
+            result = value;
+            return;
+        }
+        testTask left(value - 1), right(value - 2);
+        assert(pool->submit(&left));
+        assert(pool->submit(&right));
+        assert(right.join());
+        assert(left.join());
+        result = left.result + right.result;
+    }
+};
+
+class testCall
+{
+public:
+    void operator()() {
+        calls.fetch_add(1);
+    }
+};
+
 extern "C" int main()
 {
     time_t now, later;
@@ -76,6 +137,51 @@ extern "C" int main()
     time(&later);
     assert(later >= now + 1);
 
+    testQueue tq;
+    testTimer early(&tq, 10), late(&tq, 300), never(&tq, 50), again(&tq, 30);
+    timeout_t next;
+    Timer limit((timeout_t)2000);
+
+    never.disarm();
+    again.repeat = 2;
+    assert(tq.expire() <= 10);
+    while(!late.fired && !limit) {
+        next = tq.expire();
+        assert(next > 0);
+        if(next > 20)
+            next = 20;
+        Thread::sleep(next);
+    }
+    assert(early.fired == 1);
+    assert(late.fired == 1);
+    assert(never.fired == 0);
+    assert(again.fired == 3);
+    assert(tq.expire() == Timer::inf);
+
+    tq -= early;
+    assert(early.list() == nullptr);
+    early.arm(10);
+    Thread::sleep(20);
+    tq.expire();
+    assert(early.fired == 1);
+
+    assert(Thread::cpus() > 0);
+    TaskPool tp(3);
+    pool = &tp;
+    assert(tp.size() == 3);
+    testTask fib(15);
+    assert(tp.submit(&fib));
+    assert(fib.join());
+    assert(fib.result == 610);
+    TaskPool::future last;
+    for(unsigned pos = 0; pos < 1000; ++pos)
+        last = tp.async(testCall());
+    tp.wait();
+    assert(calls.get() == 1000);
+    assert(tp.pending() == 0);
+    assert(!last.is_busy());
+    assert(last.join(0));
+
     time(&now);
     TimedEvent evt;
     evt.wait(2000);
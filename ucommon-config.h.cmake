@@ -37,6 +37,11 @@
 #cmakedefine HAVE_REGEX_H 1
 #cmakedefine HAVE_SYS_INOTIFY_H 1
 #cmakedefine HAVE_SYS_EVENT_H 1
+#cmakedefine HAVE_SYS_EPOLL_H 1
+#cmakedefine HAVE_SYS_SENDFILE_H 1
+#cmakedefine HAVE_LINUX_IO_URING_H 1
+#cmakedefine HAVE_LINUX_FUTEX_H 1
+#cmakedefine HAVE_LINUX_FS_H 1
 #cmakedefine HAVE_SYSLOG_H 1
 #cmakedefine HAVE_LIBINTL_H 1
 #cmakedefine HAVE_NETINET_IN_H 1
@@ -66,6 +71,7 @@
 #cmakedefine HAVE_PTHREAD_CONDATTR_SETCLOCK 1
 #cmakedefine HAVE_PTHREAD_DELAY 1
 #cmakedefine HAVE_PTHREAD_DELAY_NP 1
+#cmakedefine HAVE_PTHREAD_SETAFFINITY_NP 1
 #cmakedefine HAVE_PTHREAD_SETCONCURRENCY 1
 #cmakedefine HAVE_PTHREAD_SETSCHEDPRIO 1
 #cmakedefine HAVE_PTHREAD_YIELD 1
@@ -75,6 +81,10 @@
 #cmakedefine HAVE_SOCKETPAIR 1
 #define HAVE_STDEXCEPT 1        /* cannot seem to test in cmake... */
 #cmakedefine HAVE_STRLCPY 1
+#cmakedefine HAVE_RECVMMSG 1
+#cmakedefine HAVE_SENDMMSG 1
+#cmakedefine HAVE_COPY_FILE_RANGE 1
+#cmakedefine HAVE_FUTIMENS 1
 #cmakedefine HAVE_STRICMP 1
 #cmakedefine HAVE_STRCOLL 1
 #cmakedefine HAVE_STRINGS_H 1
@@ -13,7 +13,7 @@
 # license that conforms to the Open Source Definition (Version 1.9)
 # published by the Open Source Initiative.
 
-%define libname	libucommon8
+%define libname	libucommon9
 %if %{_target_cpu} == "x86_64"
 %define	build_docs	1
 %else